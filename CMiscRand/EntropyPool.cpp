@@ -0,0 +1,172 @@
+// EntropyPool.cpp seeds the generators of this library from the hardware random number generators.  RDSEED
+// and RDRAND take hundreds of cycles per call and may fail and need retries, which is too slow for
+// generating random numbers but fine for seeding.  Each thread keeps a pool of NUM_ENTROPY_POOL_WORDS 64-bit
+// words refilled in one batch, and each MiscRandState or MiscRandEngine takes a single word from it, which
+// SplitMix64 expands into all the seeds the state needs.  Seeding thousands of states then takes a few
+// hundred cycles each instead of one hardware call per lane.
+//
+// A refill takes RDSEED output while RDSEED keeps up and switches to RDRAND for the rest of the batch the
+// first time RDSEED runs dry, as it does when called back to back.  If RDRAND fails ENTROPY_RETRY times in a
+// row, or the CPU has neither instruction, the word is made from the time-stamp counter mixed with a
+// per-thread counter and the address of the pool instead.  Such words differ between calls and threads
+// but are not unpredictable.
+
+#include <string.h>
+#include <immintrin.h>
+#include "MiscRand.h"
+#include "cpudetect.h"
+
+#define NUM_ENTROPY_POOL_WORDS		64			// 64-bit words fetched per refill
+#define ENTROPY_RETRY				10			// RDRAND calls before we fall back to the time-stamp counter
+
+// EntropyPool keeps the words of one thread not handed out yet and counts where the words came from.
+typedef struct alignas(64) EntropyPool
+{
+	unsigned long long	words[NUM_ENTROPY_POOL_WORDS];
+	unsigned long long	uFallbackCounter;
+	unsigned long long	numRDSEEDWords;
+	unsigned long long	numRDRANDWords;
+	unsigned long long	numFallbackWords;
+	int					numAvailableWords;					// Number of entries left in words[]
+} EntropyPool;
+
+// entropyPool is constant-initialized empty, so each thread fills its own on first use.
+static thread_local EntropyPool	entropyPool;
+
+// SplitMix64() returns the next output of the SplitMix64 generator with state *pState.  It turns one pool
+//     word into as many well-mixed seeds as a state needs.
+static inline unsigned long long	SplitMix64(unsigned long long *pState)
+{
+	unsigned long long	z = (*pState += 0x9E3779B97F4A7C15ULL);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// RefillEntropyPool() fills all of pPool->words[].
+static void	RefillEntropyPool(EntropyPool *pPool)
+{
+	bool	bUseRDSEED = supportRDSEED();
+	bool	bUseRDRAND = supportRDRAND();
+
+	for (int i = 0; i < NUM_ENTROPY_POOL_WORDS; i++)
+	{
+		unsigned long long	uWord;
+		int					uRetryCount;
+
+		if (bUseRDSEED)
+		{
+			if (_rdseed64_step(&uWord))
+			{
+				pPool->words[i] = uWord;
+				pPool->numRDSEEDWords++;
+				continue;
+			}
+			bUseRDSEED = false;
+		}
+
+		if (bUseRDRAND)
+		{
+			for (uRetryCount = 0; uRetryCount < ENTROPY_RETRY; uRetryCount++)
+				if (_rdrand64_step(&uWord))
+					break;
+			if (uRetryCount < ENTROPY_RETRY)
+			{
+				pPool->words[i] = uWord;
+				pPool->numRDRANDWords++;
+				continue;
+			}
+		}
+
+		uWord = __rdtsc() ^ (unsigned long long) (size_t) pPool ^ (++pPool->uFallbackCounter << 48);
+		pPool->words[i] = SplitMix64(&uWord);
+		pPool->numFallbackWords++;
+	}
+	pPool->numAvailableWords = NUM_ENTROPY_POOL_WORDS;
+}
+
+// EntropyPoolNext() returns the next 64-bit word of the pool of the calling thread, refilling it if empty.
+unsigned long long	MISCRAND_CDECL	EntropyPoolNext()
+{
+	if (entropyPool.numAvailableWords == 0)
+		RefillEntropyPool(&entropyPool);
+
+	return entropyPool.words[NUM_ENTROPY_POOL_WORDS - entropyPool.numAvailableWords--];
+}
+
+// EntropyPoolFill() fills pOut[0], ..., pOut[n - 1] with what n EntropyPoolNext() calls would return.
+void	MISCRAND_CDECL	EntropyPoolFill(unsigned long long *pOut, size_t n)
+{
+	while (n > 0)
+	{
+		size_t	numTaken;
+
+		if (entropyPool.numAvailableWords == 0)
+			RefillEntropyPool(&entropyPool);
+		numTaken = ((size_t) entropyPool.numAvailableWords < n) ? entropyPool.numAvailableWords : n;
+		memcpy(pOut, &entropyPool.words[NUM_ENTROPY_POOL_WORDS - entropyPool.numAvailableWords],
+			numTaken * sizeof(unsigned long long));
+		entropyPool.numAvailableWords -= (int) numTaken;
+		pOut += numTaken;
+		n -= numTaken;
+	}
+}
+
+// EntropyPoolStats() returns how many words the pool of the calling thread has taken from RDSEED, from
+//     RDRAND and from the time-stamp counter so far.  Any of the pointers may be NULL.
+void	MISCRAND_CDECL	EntropyPoolStats(unsigned long long *pNumRDSEEDWords, unsigned long long *pNumRDRANDWords,
+	unsigned long long *pNumFallbackWords)
+{
+	if (pNumRDSEEDWords != NULL)
+		*pNumRDSEEDWords = entropyPool.numRDSEEDWords;
+	if (pNumRDRANDWords != NULL)
+		*pNumRDRANDWords = entropyPool.numRDRANDWords;
+	if (pNumFallbackWords != NULL)
+		*pNumFallbackWords = entropyPool.numFallbackWords;
+}
+
+// EntropySeed() seeds LargerRand() and the GaussianRandVec(), GaussianRandZig() and GaussianRandVecFloat()
+//     lanes of the calling thread from the pool.  See EntropySeed_r().
+void	MISCRAND_CDECL	EntropySeed()
+{
+	EntropySeed_r(MiscRandDefaultState());
+}
+
+// EntropySeed_r() puts *pState to the state MiscRandStateInit() sets up, but with LargerRand() and every
+//     lane seeded from one word of the pool of the calling thread.
+void	MISCRAND_CDECL	EntropySeed_r(MiscRandState *pState)
+{
+	unsigned long long	uMix = EntropyPoolNext();
+	unsigned long long	uSeeds;
+
+	MiscRandStateInit(pState);
+	uSeeds = SplitMix64(&uMix);
+	pState->uLargerRandSeed = (unsigned long) (unsigned int) uSeeds;
+	for (int lane = 0; lane < NUM_GAUSSIANRAND_LANES; lane += 2)
+	{
+		uSeeds = SplitMix64(&uMix);
+		pState->laneSeeds[lane] = (unsigned int) uSeeds;
+		pState->laneSeeds[lane + 1] = (unsigned int) (uSeeds >> 32);
+	}
+	for (int lane = 0; lane < NUM_GAUSSIANRANDFLOAT_LANES; lane += 2)
+	{
+		uSeeds = SplitMix64(&uMix);
+		pState->floatLaneSeeds[lane] = (unsigned int) uSeeds;
+		pState->floatLaneSeeds[lane + 1] = (unsigned int) (uSeeds >> 32);
+	}
+}
+
+// EntropySeedStates() runs EntropySeed_r() on pStates[0], ..., pStates[n - 1], for n threads or jobs to
+//     start from independent states.  Unlike SplitStreams(), the streams are not guaranteed to be apart.
+void	MISCRAND_CDECL	EntropySeedStates(MiscRandState *pStates, int n)
+{
+	for (int j = 0; j < n; j++)
+		EntropySeed_r(&pStates[j]);
+}
+
+// EntropySeedEngine() sets up *pEngine as an engine of the given type seeded with one word of the pool.
+void	MISCRAND_CDECL	EntropySeedEngine(MiscRandEngine *pEngine, MiscRandEngineType type)
+{
+	RandEngineInit(pEngine, type, EntropyPoolNext());
+}
@@ -0,0 +1,328 @@
+// GaussianInverseCDF.cpp turns uniform numbers into Gaussian ones through the inverse of the standard normal
+// distribution function, with algorithm AS 241 of Wichura ("The Percentage Points of the Normal
+// Distribution", Applied Statistics, 1988), PPND16, which is accurate to about 1e-16 relative.  Unlike the
+// Polar form of Box-Muller transform and the ziggurat, it takes exactly one uniform number per Gaussian
+// number and rejects nothing, so the i-th output depends on the i-th input alone.  That makes it the
+// transform for quasi-random inputs, for stream replay and for anything else that needs a fixed mapping.
+//
+// AS 241 has three regions: the central one for |p - 0.5| <= 0.425, a rational function of
+// 0.180625 - (p - 0.5)^2, and two tail ones, rational functions of r - 1.6 for r <= 5 and of r - 5 above,
+// with r = sqrt(-log(min(p, 1 - p))).  All three are ratios of two polynomials of degree 7, so the SIMD
+// kernels below do not branch: every lane computes the logarithm and the square root, picks the 15
+// coefficients of its region from inverseCDFCoefs[] with one permute each, and runs the same Horner
+// schemes.  The latency is the same whatever mix of regions a vector holds.
+//
+// The scalar kernel takes the logarithm and square root from the SSE2 code of MiscRandVecMath.h, and none
+// of the kernels use fused multiply-adds, so they all return the same numbers bit for bit.
+
+#include <float.h>
+#include <math.h>
+#include <immintrin.h>
+#include "MiscRand.h"
+#include "MiscRandVecMath.h"
+#include "cpudetect.h"
+
+#define NUM_INVERSECDF_CHUNK		512			// Uniform numbers drawn at a time by GaussianRandInvFill()
+#define NUM_INVERSECDF_COEFS		15			// 8 numerator and 7 denominator coefficients per region
+#define INVERSECDF_CENTRAL_HALFWIDTH	0.425	// The central region is |p - 0.5| <= this
+#define INVERSECDF_CENTRAL_SQUARE	0.180625	// INVERSECDF_CENTRAL_HALFWIDTH^2
+#define INVERSECDF_FAR_TAIL			5.0			// The far tail region is r > this
+
+// The regions index the columns of inverseCDFCoefs[].
+enum
+{
+	INVERSECDF_REGION_CENTRAL = 0,
+	INVERSECDF_REGION_NEAR = 1,
+	INVERSECDF_REGION_FAR = 2
+};
+
+// inverseCDFCoefs[k][region] is the k-th coefficient of the region: the numerator coefficients of degree 0
+//     to 7, then the denominator coefficients of degree 1 to 7; the denominators start with 1.  The rows
+//     are padded to 8 doubles so that one aligned load gives the permutes all the regions.
+//     inverseCDFOffsets[region] is what r is shifted by in the tail regions.
+alignas(64) static const double	inverseCDFCoefs[NUM_INVERSECDF_COEFS][8] =
+{
+	{ 3.3871328727963666080e0, 1.42343711074968357734e0, 6.65790464350110377720e0 },
+	{ 1.3314166789178437745e+2, 4.63033784615654529590e0, 5.46378491116411436990e0 },
+	{ 1.9715909503065514427e+3, 5.76949722146069140550e0, 1.78482653991729133580e0 },
+	{ 1.3731693765509461125e+4, 3.64784832476320460504e0, 2.96560571828504891230e-1 },
+	{ 4.5921953931549871457e+4, 1.27045825245236838258e0, 2.65321895265761230930e-2 },
+	{ 6.7265770927008700853e+4, 2.41780725177450611770e-1, 1.24266094738807843860e-3 },
+	{ 3.3430575583588128105e+4, 2.27238449892691845833e-2, 2.71155556874348757815e-5 },
+	{ 2.5090809287301226727e+3, 7.74545014278341407640e-4, 2.01033439929228813265e-7 },
+	{ 4.2313330701600911252e+1, 2.05319162663775882187e0, 5.99832206555887937690e-1 },
+	{ 6.8718700749205790830e+2, 1.67638483018380384940e0, 1.36929880922735805310e-1 },
+	{ 5.3941960214247511077e+3, 6.89767334985100004550e-1, 1.48753612908506148525e-2 },
+	{ 2.1213794301586595867e+4, 1.48103976427480074590e-1, 7.86869131145613259100e-4 },
+	{ 3.9307895800092710610e+4, 1.51986665636164571966e-2, 1.84631831751005468180e-5 },
+	{ 2.8729085735721942674e+4, 5.47593808499534494600e-4, 1.42151175831644588870e-7 },
+	{ 5.2264952788528545610e+3, 1.05075007164441684324e-9, 2.04426310338993978564e-15 }
+};
+static const double	inverseCDFOffsets[3] = { 0.0, 1.6, INVERSECDF_FAR_TAIL };
+
+// InverseCDF_t writes the inverse of the standard normal distribution function at pIn[i] to pOut[i] for
+//     i < n.  pIn may be pOut.
+typedef void (*InverseCDF_t)(const double *pIn, double *pOut, size_t n);
+
+// InverseCDFOne() is the scalar kernel for one number.  The p <= 0 and p >= 1 checks come last, as in the
+//     SIMD kernels, which clamp min(p, 1 - p) to DBL_MIN so the logarithm stays finite.
+static inline double	InverseCDFOne(double p)
+{
+	double	q = p - 0.5;
+	double	t, sign, num, den, x;
+	int		region;
+
+	if (fabs(q) <= INVERSECDF_CENTRAL_HALFWIDTH)
+	{
+		region = INVERSECDF_REGION_CENTRAL;
+		t = INVERSECDF_CENTRAL_SQUARE - q * q;
+		sign = q;
+	}
+	else
+	{
+		double	pMin = (q < 0.0) ? p : 1.0 - p;
+		__m128d	r;
+
+		pMin = (pMin > DBL_MIN) ? pMin : DBL_MIN;
+		r = _mm_sqrt_pd(_mm_sub_pd(_mm_setzero_pd(), Log128d(_mm_set1_pd(pMin))));
+		region = (_mm_cvtsd_f64(r) > INVERSECDF_FAR_TAIL) ? INVERSECDF_REGION_FAR : INVERSECDF_REGION_NEAR;
+		t = _mm_cvtsd_f64(r) - inverseCDFOffsets[region];
+		sign = (q < 0.0) ? -1.0 : 1.0;
+	}
+
+	num = inverseCDFCoefs[7][region];
+	for (int k = 6; k >= 0; k--)
+		num = num * t + inverseCDFCoefs[k][region];
+	den = inverseCDFCoefs[14][region];
+	for (int k = 13; k >= 8; k--)
+		den = den * t + inverseCDFCoefs[k][region];
+	den = den * t + 1.0;
+	x = sign * num / den;
+
+	if (p <= 0.0)
+		x = -HUGE_VAL;
+	if (p >= 1.0)
+		x = HUGE_VAL;
+	return x;
+}
+
+static void	InverseCDFScalar(const double *pIn, double *pOut, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		pOut[i] = InverseCDFOne(pIn[i]);
+}
+
+// CoefAVX2() returns coefficient k of the region of each lane.  _mm256_permutevar8x32_ps() moves 32-bit
+//     elements, so index holds 2c and 2c + 1 in the two halves of a lane of region c.
+static inline __m256d	CoefAVX2(__m256i index, int k)
+{
+	return _mm256_castps_pd(_mm256_permutevar8x32_ps(_mm256_castpd_ps(_mm256_load_pd(inverseCDFCoefs[k])), index));
+}
+
+static void	InverseCDFAVX2(const double *pIn, double *pOut, size_t n)
+{
+	const __m256d	half = _mm256_set1_pd(0.5), one = _mm256_set1_pd(1.0), zero = _mm256_setzero_pd();
+	const __m256d	halfWidth = _mm256_set1_pd(INVERSECDF_CENTRAL_HALFWIDTH);
+	const __m256d	centralSquare = _mm256_set1_pd(INVERSECDF_CENTRAL_SQUARE);
+	const __m256d	farTail = _mm256_set1_pd(INVERSECDF_FAR_TAIL), nearOffset = _mm256_set1_pd(inverseCDFOffsets[1]);
+	const __m256d	minNormal = _mm256_set1_pd(DBL_MIN), signMask = _mm256_set1_pd(-0.0);
+	const __m256d	negInf = _mm256_set1_pd(-HUGE_VAL), posInf = _mm256_set1_pd(HUGE_VAL);
+	const __m256i	centralIndex = _mm256_set1_epi64x(0x0000000100000000LL);
+	const __m256i	nearIndex = _mm256_set1_epi64x(0x0000000300000002LL);
+	const __m256i	farIndex = _mm256_set1_epi64x(0x0000000500000004LL);
+	size_t			i = 0;
+
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256d	p = _mm256_loadu_pd(&pIn[i]);
+		__m256d	q = _mm256_sub_pd(p, half);
+		__m256d	central = _mm256_cmp_pd(_mm256_andnot_pd(signMask, q), halfWidth, _CMP_LE_OQ);
+		__m256d	pMin = _mm256_max_pd(_mm256_min_pd(p, _mm256_sub_pd(one, p)), minNormal);
+		__m256d	r = _mm256_sqrt_pd(_mm256_sub_pd(zero, Log256d(pMin)));
+		__m256d	far = _mm256_cmp_pd(r, farTail, _CMP_GT_OQ);
+		__m256d	t, sign, num, den, x;
+		__m256i	index;
+
+		t = _mm256_sub_pd(r, _mm256_blendv_pd(nearOffset, farTail, far));
+		t = _mm256_blendv_pd(t, _mm256_sub_pd(centralSquare, _mm256_mul_pd(q, q)), central);
+		sign = _mm256_blendv_pd(_mm256_or_pd(one, _mm256_and_pd(q, signMask)), q, central);
+		index = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(nearIndex), _mm256_castsi256_pd(farIndex), far));
+		index = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(index), _mm256_castsi256_pd(centralIndex), central));
+
+		num = CoefAVX2(index, 7);
+		for (int k = 6; k >= 0; k--)
+			num = _mm256_add_pd(_mm256_mul_pd(num, t), CoefAVX2(index, k));
+		den = CoefAVX2(index, 14);
+		for (int k = 13; k >= 8; k--)
+			den = _mm256_add_pd(_mm256_mul_pd(den, t), CoefAVX2(index, k));
+		den = _mm256_add_pd(_mm256_mul_pd(den, t), one);
+		x = _mm256_div_pd(_mm256_mul_pd(sign, num), den);
+
+		x = _mm256_blendv_pd(x, negInf, _mm256_cmp_pd(p, zero, _CMP_LE_OQ));
+		x = _mm256_blendv_pd(x, posInf, _mm256_cmp_pd(p, one, _CMP_GE_OQ));
+		_mm256_storeu_pd(&pOut[i], x);
+	}
+	InverseCDFScalar(pIn + i, pOut + i, n - i);
+}
+
+// CoefAVX512() returns coefficient k of the region of each lane, index holding the regions.
+static inline __m512d	CoefAVX512(__m512i index, int k)
+{
+	return _mm512_permutexvar_pd(index, _mm512_load_pd(inverseCDFCoefs[k]));
+}
+
+static void	InverseCDFAVX512(const double *pIn, double *pOut, size_t n)
+{
+	const __m512d	half = _mm512_set1_pd(0.5), one = _mm512_set1_pd(1.0), zero = _mm512_setzero_pd();
+	const __m512d	halfWidth = _mm512_set1_pd(INVERSECDF_CENTRAL_HALFWIDTH);
+	const __m512d	centralSquare = _mm512_set1_pd(INVERSECDF_CENTRAL_SQUARE);
+	const __m512d	farTail = _mm512_set1_pd(INVERSECDF_FAR_TAIL), nearOffset = _mm512_set1_pd(inverseCDFOffsets[1]);
+	const __m512d	minNormal = _mm512_set1_pd(DBL_MIN);
+	const __m512i	signMask = _mm512_set1_epi64(0x8000000000000000LL);
+	const __m512d	negInf = _mm512_set1_pd(-HUGE_VAL), posInf = _mm512_set1_pd(HUGE_VAL);
+	size_t			i = 0;
+
+	for (; i + 8 <= n; i += 8)
+	{
+		__m512d		p = _mm512_loadu_pd(&pIn[i]);
+		__m512d		q = _mm512_sub_pd(p, half);
+		__mmask8	central = _mm512_cmp_pd_mask(_mm512_abs_pd(q), halfWidth, _CMP_LE_OQ);
+		__m512d		pMin = _mm512_max_pd(_mm512_min_pd(p, _mm512_sub_pd(one, p)), minNormal);
+		__m512d		r = _mm512_sqrt_pd(_mm512_sub_pd(zero, Log512d(pMin)));
+		__mmask8	far = _mm512_cmp_pd_mask(r, farTail, _CMP_GT_OQ);
+		__m512d		t, sign, num, den, x;
+		__m512i		index;
+
+		t = _mm512_sub_pd(r, _mm512_mask_blend_pd(far, nearOffset, farTail));
+		t = _mm512_mask_blend_pd(central, t, _mm512_sub_pd(centralSquare, _mm512_mul_pd(q, q)));
+		sign = _mm512_castsi512_pd(_mm512_or_si512(_mm512_castpd_si512(one),
+			_mm512_and_si512(_mm512_castpd_si512(q), signMask)));
+		sign = _mm512_mask_blend_pd(central, sign, q);
+		index = _mm512_mask_blend_epi64(far, _mm512_set1_epi64(INVERSECDF_REGION_NEAR),
+			_mm512_set1_epi64(INVERSECDF_REGION_FAR));
+		index = _mm512_mask_blend_epi64(central, index, _mm512_set1_epi64(INVERSECDF_REGION_CENTRAL));
+
+		num = CoefAVX512(index, 7);
+		for (int k = 6; k >= 0; k--)
+			num = _mm512_add_pd(_mm512_mul_pd(num, t), CoefAVX512(index, k));
+		den = CoefAVX512(index, 14);
+		for (int k = 13; k >= 8; k--)
+			den = _mm512_add_pd(_mm512_mul_pd(den, t), CoefAVX512(index, k));
+		den = _mm512_add_pd(_mm512_mul_pd(den, t), one);
+		x = _mm512_div_pd(_mm512_mul_pd(sign, num), den);
+
+		x = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(p, zero, _CMP_LE_OQ), x, negInf);
+		x = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(p, one, _CMP_GE_OQ), x, posInf);
+		_mm512_storeu_pd(&pOut[i], x);
+	}
+	InverseCDFScalar(pIn + i, pOut + i, n - i);
+}
+
+// SelectGaussianRandInvISA() returns the fastest instruction set we have kernels for on the running CPU.
+static MiscRandISA	SelectGaussianRandInvISA()
+{
+	if (supportAVX512F())
+		return MISCRAND_ISA_AVX512;
+	else if (supportAVX2())
+		return MISCRAND_ISA_AVX2;
+	else
+		return MISCRAND_ISA_SCALAR;
+}
+
+static void	InverseCDFResolve(const double *pIn, double *pOut, size_t n);
+
+// pInverseCDF and gaussianRandInvISA are bound at startup the same way as pGaussianRandVecBlock in
+//     GaussianRand.cpp.
+static InverseCDF_t	pInverseCDF = InverseCDFResolve;
+static MiscRandISA	gaussianRandInvISA = MISCRAND_ISA_SCALAR;
+static const bool	bGaussianRandInvBound = GaussianRandInvSetISA(SelectGaussianRandInvISA());
+
+static void	InverseCDFResolve(const double *pIn, double *pOut, size_t n)
+{
+	GaussianRandInvSetISA(SelectGaussianRandInvISA());
+	pInverseCDF(pIn, pOut, n);
+}
+
+// GaussianRandInvISA() returns the instruction set of the kernels UniformToGaussian() and
+//     GaussianRandInvFill() use; the uniform numbers come from kernels with their own settings.
+MiscRandISA	MISCRAND_CDECL	GaussianRandInvISA()
+{
+	if (pInverseCDF == InverseCDFResolve)
+		GaussianRandInvSetISA(SelectGaussianRandInvISA());
+	return gaussianRandInvISA;
+}
+
+// GaussianRandInvSetISA() makes UniformToGaussian() and GaussianRandInvFill() use the kernels for isa.  It
+//     returns false and changes nothing if there are no such kernels or the running CPU does not support
+//     isa.  It is not meant to be called while other threads are generating.
+bool	MISCRAND_CDECL	GaussianRandInvSetISA(MiscRandISA isa)
+{
+	switch (isa)
+	{
+	case MISCRAND_ISA_AVX512:
+		if (!supportAVX512F())
+			return false;
+		pInverseCDF = InverseCDFAVX512;
+		break;
+	case MISCRAND_ISA_AVX2:
+		if (!supportAVX2())
+			return false;
+		pInverseCDF = InverseCDFAVX2;
+		break;
+	case MISCRAND_ISA_SCALAR:
+		pInverseCDF = InverseCDFScalar;
+		break;
+	default:
+		return false;
+	}
+	gaussianRandInvISA = isa;
+	return true;
+}
+
+// UniformToGaussian() writes the inverse of the standard normal distribution function at pIn[i] to pOut[i]
+//     for i < n, so uniform numbers in (0, 1) become standard Gaussian ones.  pIn may be pOut; neither needs
+//     to be aligned.  0 and 1 give -HUGE_VAL and HUGE_VAL.  The inputs must not be NaNs, and the ones below
+//     DBL_MIN, or within DBL_MIN of 1, are taken as DBL_MIN away from 0 or 1: they give about -/+37.5.
+void	MISCRAND_CDECL	UniformToGaussian(const double *pIn, double *pOut, size_t n)
+{
+	pInverseCDF(pIn, pOut, n);
+}
+
+// GaussianRandInv() returns a standard Gaussian random number from the inverse distribution function at one
+//     UniformRandFillOpen() number of the calling thread, so two LargerRand() outputs per number.  The calls
+//     return the same sequence as GaussianRandInvFill().
+double	MISCRAND_CDECL	GaussianRandInv()
+{
+	return GaussianRandInv_r(MiscRandDefaultState());
+}
+
+// GaussianRandInv_r() is GaussianRandInv() working on *pState.
+double	MISCRAND_CDECL	GaussianRandInv_r(MiscRandState *pState)
+{
+	double	u;
+
+	UniformRandFillOpen_r(pState, &u, 1, 0.0, 1.0);
+	return InverseCDFOne(u);
+}
+
+// GaussianRandInvFill() fills pOut[0], ..., pOut[n - 1] with standard Gaussian random numbers as
+//     GaussianRandInv() makes them.  pOut does not need to be aligned.
+void	MISCRAND_CDECL	GaussianRandInvFill(double *pOut, size_t n)
+{
+	GaussianRandInvFill_r(MiscRandDefaultState(), pOut, n);
+}
+
+// GaussianRandInvFill_r() is GaussianRandInvFill() working on *pState.  The uniform numbers are written
+//     straight into pOut and transformed in place, a chunk at a time so that they are still in cache.
+void	MISCRAND_CDECL	GaussianRandInvFill_r(MiscRandState *pState, double *pOut, size_t n)
+{
+	while (n > 0)
+	{
+		size_t	m = (n < NUM_INVERSECDF_CHUNK) ? n : NUM_INVERSECDF_CHUNK;
+
+		UniformRandFillOpen_r(pState, pOut, m, 0.0, 1.0);
+		pInverseCDF(pOut, pOut, m);
+		pOut += m;
+		n -= m;
+	}
+}
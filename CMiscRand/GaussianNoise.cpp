@@ -0,0 +1,330 @@
+// GaussianNoise.cpp adds Gaussian noise to signal buffers in place: p[i] += mean + sigma * g[i].  The noise
+// is drawn a chunk of NUM_NOISE_CHUNK numbers at a time with GaussianRandVecFill_r() or
+// GaussianRandVecFloatFill_r(), whose body goes straight from the kernels into the chunk, and the SIMD
+// kernels below add the chunk to the signal while it is still in the L1 cache.  So the signal is read and
+// written once, and the only other memory the noise touches is the chunk.
+//
+// The kernels compute each sum in the same order without fused multiply-adds, so they all return the same
+// numbers bit for bit: p[i] + (g[i] * sigma + mean).  The 16-bit kernels add in float, clamp to the range
+// of a short and round to nearest-even.
+
+#include <math.h>
+#include <immintrin.h>
+#include "MiscRand.h"
+#include "cpudetect.h"
+
+#define NUM_NOISE_CHUNK			512			// Noise numbers drawn at a time
+
+typedef void (*AddNoiseDouble_t)(double *p, const double *pNoise, size_t n, double sigma, double mean);
+typedef void (*AddNoiseFloat_t)(float *p, const float *pNoise, size_t n, float sigma, float mean);
+typedef void (*AddNoiseInt16_t)(short *p, const float *pNoise, size_t n, float sigma, float mean);
+
+static void	AddNoiseDoubleScalar(double *p, const double *pNoise, size_t n, double sigma, double mean)
+{
+	for (size_t i = 0; i < n; i++)
+		p[i] = p[i] + (pNoise[i] * sigma + mean);
+}
+
+static void	AddNoiseFloatScalar(float *p, const float *pNoise, size_t n, float sigma, float mean)
+{
+	for (size_t i = 0; i < n; i++)
+		p[i] = p[i] + (pNoise[i] * sigma + mean);
+}
+
+static void	AddNoiseInt16Scalar(short *p, const float *pNoise, size_t n, float sigma, float mean)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		float	x = (float) p[i] + (pNoise[i] * sigma + mean);
+
+		// lrintf() rounds in the current rounding mode, nearest-even by default, as _mm*_cvtps_epi32() do.
+		x = (x > 32767.0f) ? 32767.0f : x;
+		x = (x < -32768.0f) ? -32768.0f : x;
+		p[i] = (short) lrintf(x);
+	}
+}
+
+static void	AddNoiseDoubleAVX2(double *p, const double *pNoise, size_t n, double sigma, double mean)
+{
+	const __m256d	vSigma = _mm256_set1_pd(sigma), vMean = _mm256_set1_pd(mean);
+	size_t			i = 0;
+
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256d		g = _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(&pNoise[i]), vSigma), vMean);
+
+		_mm256_storeu_pd(&p[i], _mm256_add_pd(_mm256_loadu_pd(&p[i]), g));
+	}
+	AddNoiseDoubleScalar(p + i, pNoise + i, n - i, sigma, mean);
+}
+
+static void	AddNoiseFloatAVX2(float *p, const float *pNoise, size_t n, float sigma, float mean)
+{
+	const __m256	vSigma = _mm256_set1_ps(sigma), vMean = _mm256_set1_ps(mean);
+	size_t			i = 0;
+
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256		g = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&pNoise[i]), vSigma), vMean);
+
+		_mm256_storeu_ps(&p[i], _mm256_add_ps(_mm256_loadu_ps(&p[i]), g));
+	}
+	AddNoiseFloatScalar(p + i, pNoise + i, n - i, sigma, mean);
+}
+
+// AddNoiseInt16AVX2() widens eight shorts to 32-bit integers and floats, and narrows them back with
+//     _mm_packs_epi32(), whose saturation the clamping has made moot.
+static void	AddNoiseInt16AVX2(short *p, const float *pNoise, size_t n, float sigma, float mean)
+{
+	const __m256	vSigma = _mm256_set1_ps(sigma), vMean = _mm256_set1_ps(mean);
+	const __m256	vMax = _mm256_set1_ps(32767.0f), vMin = _mm256_set1_ps(-32768.0f);
+	size_t			i = 0;
+
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256		x = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) &p[i])));
+		__m256		g = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(&pNoise[i]), vSigma), vMean);
+		__m256i		k;
+
+		x = _mm256_max_ps(_mm256_min_ps(_mm256_add_ps(x, g), vMax), vMin);
+		k = _mm256_cvtps_epi32(x);
+		_mm_storeu_si128((__m128i *) &p[i], _mm_packs_epi32(_mm256_castsi256_si128(k), _mm256_extracti128_si256(k, 1)));
+	}
+	AddNoiseInt16Scalar(p + i, pNoise + i, n - i, sigma, mean);
+}
+
+static void	AddNoiseDoubleAVX512(double *p, const double *pNoise, size_t n, double sigma, double mean)
+{
+	const __m512d	vSigma = _mm512_set1_pd(sigma), vMean = _mm512_set1_pd(mean);
+	size_t			i = 0;
+
+	for (; i + 8 <= n; i += 8)
+	{
+		__m512d		g = _mm512_add_pd(_mm512_mul_pd(_mm512_loadu_pd(&pNoise[i]), vSigma), vMean);
+
+		_mm512_storeu_pd(&p[i], _mm512_add_pd(_mm512_loadu_pd(&p[i]), g));
+	}
+	AddNoiseDoubleScalar(p + i, pNoise + i, n - i, sigma, mean);
+}
+
+static void	AddNoiseFloatAVX512(float *p, const float *pNoise, size_t n, float sigma, float mean)
+{
+	const __m512	vSigma = _mm512_set1_ps(sigma), vMean = _mm512_set1_ps(mean);
+	size_t			i = 0;
+
+	for (; i + 16 <= n; i += 16)
+	{
+		__m512		g = _mm512_add_ps(_mm512_mul_ps(_mm512_loadu_ps(&pNoise[i]), vSigma), vMean);
+
+		_mm512_storeu_ps(&p[i], _mm512_add_ps(_mm512_loadu_ps(&p[i]), g));
+	}
+	AddNoiseFloatScalar(p + i, pNoise + i, n - i, sigma, mean);
+}
+
+// AddNoiseInt16AVX512() narrows with _mm512_cvtepi32_epi16(), which truncates, so the clamping matters here.
+static void	AddNoiseInt16AVX512(short *p, const float *pNoise, size_t n, float sigma, float mean)
+{
+	const __m512	vSigma = _mm512_set1_ps(sigma), vMean = _mm512_set1_ps(mean);
+	const __m512	vMax = _mm512_set1_ps(32767.0f), vMin = _mm512_set1_ps(-32768.0f);
+	size_t			i = 0;
+
+	for (; i + 16 <= n; i += 16)
+	{
+		__m512		x = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i *) &p[i])));
+		__m512		g = _mm512_add_ps(_mm512_mul_ps(_mm512_loadu_ps(&pNoise[i]), vSigma), vMean);
+
+		x = _mm512_max_ps(_mm512_min_ps(_mm512_add_ps(x, g), vMax), vMin);
+		_mm256_storeu_si256((__m256i *) &p[i], _mm512_cvtepi32_epi16(_mm512_cvtps_epi32(x)));
+	}
+	AddNoiseInt16Scalar(p + i, pNoise + i, n - i, sigma, mean);
+}
+
+// SelectGaussianNoiseISA() returns the fastest instruction set we have kernels for on the running CPU.
+static MiscRandISA	SelectGaussianNoiseISA()
+{
+	if (supportAVX512F())
+		return MISCRAND_ISA_AVX512;
+	else if (supportAVX2())
+		return MISCRAND_ISA_AVX2;
+	else
+		return MISCRAND_ISA_SCALAR;
+}
+
+static void	AddNoiseDoubleResolve(double *p, const double *pNoise, size_t n, double sigma, double mean);
+static void	AddNoiseFloatResolve(float *p, const float *pNoise, size_t n, float sigma, float mean);
+static void	AddNoiseInt16Resolve(short *p, const float *pNoise, size_t n, float sigma, float mean);
+
+// The kernel pointers and gaussianNoiseISA are bound at startup the same way as pGaussianRandVecBlock in
+//     GaussianRand.cpp.
+static AddNoiseDouble_t		pAddNoiseDouble = AddNoiseDoubleResolve;
+static AddNoiseFloat_t		pAddNoiseFloat = AddNoiseFloatResolve;
+static AddNoiseInt16_t		pAddNoiseInt16 = AddNoiseInt16Resolve;
+static MiscRandISA			gaussianNoiseISA = MISCRAND_ISA_SCALAR;
+static const bool			bGaussianNoiseBound = GaussianNoiseSetISA(SelectGaussianNoiseISA());
+
+static void	AddNoiseDoubleResolve(double *p, const double *pNoise, size_t n, double sigma, double mean)
+{
+	GaussianNoiseSetISA(SelectGaussianNoiseISA());
+	pAddNoiseDouble(p, pNoise, n, sigma, mean);
+}
+
+static void	AddNoiseFloatResolve(float *p, const float *pNoise, size_t n, float sigma, float mean)
+{
+	GaussianNoiseSetISA(SelectGaussianNoiseISA());
+	pAddNoiseFloat(p, pNoise, n, sigma, mean);
+}
+
+static void	AddNoiseInt16Resolve(short *p, const float *pNoise, size_t n, float sigma, float mean)
+{
+	GaussianNoiseSetISA(SelectGaussianNoiseISA());
+	pAddNoiseInt16(p, pNoise, n, sigma, mean);
+}
+
+// GaussianNoiseISA() returns the instruction set of the kernels AddGaussianNoise() and its siblings use
+//     for the additions; the noise comes from the GaussianRandVec() and GaussianRandVecFloat() kernels.
+MiscRandISA	MISCRAND_CDECL	GaussianNoiseISA()
+{
+	if (pAddNoiseDouble == AddNoiseDoubleResolve)
+		GaussianNoiseSetISA(SelectGaussianNoiseISA());
+	return gaussianNoiseISA;
+}
+
+// GaussianNoiseSetISA() makes AddGaussianNoise() and its siblings use the kernels for isa.  It returns
+//     false and changes nothing if there are no such kernels or the running CPU does not support isa.  It is
+//     not meant to be called while other threads are adding noise.
+bool	MISCRAND_CDECL	GaussianNoiseSetISA(MiscRandISA isa)
+{
+	switch (isa)
+	{
+	case MISCRAND_ISA_AVX512:
+		if (!supportAVX512F())
+			return false;
+		pAddNoiseDouble = AddNoiseDoubleAVX512;
+		pAddNoiseFloat = AddNoiseFloatAVX512;
+		pAddNoiseInt16 = AddNoiseInt16AVX512;
+		break;
+	case MISCRAND_ISA_AVX2:
+		if (!supportAVX2())
+			return false;
+		pAddNoiseDouble = AddNoiseDoubleAVX2;
+		pAddNoiseFloat = AddNoiseFloatAVX2;
+		pAddNoiseInt16 = AddNoiseInt16AVX2;
+		break;
+	case MISCRAND_ISA_SCALAR:
+		pAddNoiseDouble = AddNoiseDoubleScalar;
+		pAddNoiseFloat = AddNoiseFloatScalar;
+		pAddNoiseInt16 = AddNoiseInt16Scalar;
+		break;
+	default:
+		return false;
+	}
+	gaussianNoiseISA = isa;
+	return true;
+}
+
+// AddGaussianNoise() adds mean + sigma * GaussianRandVec() to p[0], ..., p[n - 1], in that order, drawing
+//     from the GaussianRandVec() lanes of the calling thread.  p does not need to be aligned.
+void	MISCRAND_CDECL	AddGaussianNoise(double *p, size_t n, double sigma, double mean)
+{
+	AddGaussianNoise_r(MiscRandDefaultState(), p, n, sigma, mean);
+}
+
+// AddGaussianNoise_r() is AddGaussianNoise() working on *pState.
+void	MISCRAND_CDECL	AddGaussianNoise_r(MiscRandState *pState, double *p, size_t n, double sigma, double mean)
+{
+	alignas(64) double	noise[NUM_NOISE_CHUNK];
+
+	while (n > 0)
+	{
+		size_t	m = (n < NUM_NOISE_CHUNK) ? n : NUM_NOISE_CHUNK;
+
+		GaussianRandVecFill_r(pState, noise, m);
+		pAddNoiseDouble(p, noise, m, sigma, mean);
+		p += m;
+		n -= m;
+	}
+}
+
+// AddGaussianNoiseFloat() is AddGaussianNoise() for floats, with the noise from GaussianRandVecFloat().
+void	MISCRAND_CDECL	AddGaussianNoiseFloat(float *p, size_t n, float sigma, float mean)
+{
+	AddGaussianNoiseFloat_r(MiscRandDefaultState(), p, n, sigma, mean);
+}
+
+// AddGaussianNoiseFloat_r() is AddGaussianNoiseFloat() working on *pState.
+void	MISCRAND_CDECL	AddGaussianNoiseFloat_r(MiscRandState *pState, float *p, size_t n, float sigma, float mean)
+{
+	alignas(64) float	noise[NUM_NOISE_CHUNK];
+
+	while (n > 0)
+	{
+		size_t	m = (n < NUM_NOISE_CHUNK) ? n : NUM_NOISE_CHUNK;
+
+		GaussianRandVecFloatFill_r(pState, noise, m);
+		pAddNoiseFloat(p, noise, m, sigma, mean);
+		p += m;
+		n -= m;
+	}
+}
+
+// AddGaussianNoiseInt16() adds mean + sigma * GaussianRandVecFloat() to the 16-bit samples p[0], ...,
+//     p[n - 1], rounding to nearest-even and saturating at -32768 and 32767.
+void	MISCRAND_CDECL	AddGaussianNoiseInt16(short *p, size_t n, float sigma, float mean)
+{
+	AddGaussianNoiseInt16_r(MiscRandDefaultState(), p, n, sigma, mean);
+}
+
+// AddGaussianNoiseInt16_r() is AddGaussianNoiseInt16() working on *pState.
+void	MISCRAND_CDECL	AddGaussianNoiseInt16_r(MiscRandState *pState, short *p, size_t n, float sigma, float mean)
+{
+	alignas(64) float	noise[NUM_NOISE_CHUNK];
+
+	while (n > 0)
+	{
+		size_t	m = (n < NUM_NOISE_CHUNK) ? n : NUM_NOISE_CHUNK;
+
+		GaussianRandVecFloatFill_r(pState, noise, m);
+		pAddNoiseInt16(p, noise, m, sigma, mean);
+		p += m;
+		n -= m;
+	}
+}
+
+// AddGaussianNoiseComplex() adds circularly-symmetric complex Gaussian noise of power sigma^2 to the n
+//     complex samples in pIQ, stored as interleaved I/Q pairs pIQ[2 * k], pIQ[2 * k + 1]: I and Q each get
+//     independent noise of variance sigma^2 / 2.
+void	MISCRAND_CDECL	AddGaussianNoiseComplex(double *pIQ, size_t n, double sigma)
+{
+	AddGaussianNoiseComplex_r(MiscRandDefaultState(), pIQ, n, sigma);
+}
+
+// AddGaussianNoiseComplex_r() is AddGaussianNoiseComplex() working on *pState.
+void	MISCRAND_CDECL	AddGaussianNoiseComplex_r(MiscRandState *pState, double *pIQ, size_t n, double sigma)
+{
+	AddGaussianNoise_r(pState, pIQ, 2 * n, sigma * sqrt(0.5), 0.0);
+}
+
+// AddGaussianNoiseComplexFloat() is AddGaussianNoiseComplex() for interleaved float I/Q pairs.
+void	MISCRAND_CDECL	AddGaussianNoiseComplexFloat(float *pIQ, size_t n, float sigma)
+{
+	AddGaussianNoiseComplexFloat_r(MiscRandDefaultState(), pIQ, n, sigma);
+}
+
+// AddGaussianNoiseComplexFloat_r() is AddGaussianNoiseComplexFloat() working on *pState.
+void	MISCRAND_CDECL	AddGaussianNoiseComplexFloat_r(MiscRandState *pState, float *pIQ, size_t n, float sigma)
+{
+	AddGaussianNoiseFloat_r(pState, pIQ, 2 * n, (float) (sigma * sqrt(0.5)), 0.0f);
+}
+
+// AddGaussianNoiseComplexInt16() is AddGaussianNoiseComplex() for interleaved 16-bit I/Q pairs, saturating
+//     like AddGaussianNoiseInt16().
+void	MISCRAND_CDECL	AddGaussianNoiseComplexInt16(short *pIQ, size_t n, float sigma)
+{
+	AddGaussianNoiseComplexInt16_r(MiscRandDefaultState(), pIQ, n, sigma);
+}
+
+// AddGaussianNoiseComplexInt16_r() is AddGaussianNoiseComplexInt16() working on *pState.
+void	MISCRAND_CDECL	AddGaussianNoiseComplexInt16_r(MiscRandState *pState, short *pIQ, size_t n, float sigma)
+{
+	AddGaussianNoiseInt16_r(pState, pIQ, 2 * n, (float) (sigma * sqrt(0.5)), 0.0f);
+}
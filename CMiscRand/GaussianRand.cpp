@@ -6,9 +6,16 @@
 #include <math.h>
 #include <immintrin.h>
 #include "MiscRand.h"
+#include "GaussianRandVecKernels.h"
+#include "MiscRandCounters.h"
+#include "cpudetect.h"
+
+static_assert((NUM_GAUSSIANRAND_GENERATED % NUM_GAUSSIANRAND_BLOCK == 0)
+	&& (((NUM_GAUSSIANRAND_GENERATED / NUM_GAUSSIANRAND_BLOCK) & (NUM_GAUSSIANRAND_GENERATED / NUM_GAUSSIANRAND_BLOCK - 1)) == 0),
+	"NUM_GAUSSIANRAND_GENERATED must be NUM_GAUSSIANRAND_BLOCK times a power of two.");
 
 // GaussianRand() returns a Gaussian-distributed double random number with zero mean and unit variance.
-double		__cdecl	GaussianRand()
+double		MISCRAND_CDECL	GaussianRand()
 {
 	double	u, v, s;
 
@@ -25,105 +32,362 @@ double		__cdecl	GaussianRand()
 	return (u*sqrt(-2.0 * log(s)/s));
 }
 
-static __m256i avxRand = _mm256_set_epi32(2000000000, 1000000000, 30000000, 1000000, 30000, 1000, 30, 0);
-                                                                                // We use 0, 30, 1000 and 30000 as random seeds
-                                                                                //     if the user does not call sGaussianRandVec().
-static int	numAvailableResults = 0;
+// sGaussianRandVec() resets the eight random seeds used to generate Gaussian random variables for
+//     GaussianRandVec() in the calling thread.
+void		MISCRAND_CDECL sGaussianRandVec(int s0, int s1, int s2, int s3,
+	                                        int s4, int s5, int s6, int s7)
+{
+	sGaussianRandVec_r(MiscRandDefaultState(), s0, s1, s2, s3, s4, s5, s6, s7);
+}
+
+// sGaussianRandVec_r() resets the eight random seeds in *pState used to generate Gaussian random
+//     variables for GaussianRandVec_r(), GaussianRandVecCompact_r() and GaussianRandZig_r().
+void		MISCRAND_CDECL sGaussianRandVec_r(MiscRandState *pState, int s0, int s1, int s2, int s3,
+	                                          int s4, int s5, int s6, int s7)
+{
+	pState->laneSeeds[0] = s0;
+	pState->laneSeeds[1] = s1;
+	pState->laneSeeds[2] = s2;
+	pState->laneSeeds[3] = s3;
+	pState->laneSeeds[4] = s4;
+	pState->laneSeeds[5] = s5;
+	pState->laneSeeds[6] = s6;
+	pState->laneSeeds[7] = s7;
+	pState->numAvailableResults = 0;
+	pState->numAvailableZigResults = 0;
+	pState->numAvailableCompactResults = 0;
+	pState->numStagedPairs = 0;
+}
+
+// GaussianRandVecJump() moves each of the eight lanes k steps ahead of where it is.  See
+//     GaussianRandVecJump_r().
+void		MISCRAND_CDECL	GaussianRandVecJump(unsigned long long k)
+{
+	GaussianRandVecJump_r(MiscRandDefaultState(), k);
+}
+
+// GaussianRandVecJump_r() moves each of the eight lanes in *pState k linear congruential generator steps
+//     ahead, in O(log k) time, and drops the Gaussian random numbers buffered from the old positions.  A
+//     lane takes two steps per pair of Gaussian random numbers it tries, and rejections make it try more
+//     than once now and then, so k counts steps rather than Gaussian random numbers.
+void		MISCRAND_CDECL	GaussianRandVecJump_r(MiscRandState *pState, unsigned long long k)
+{
+	for (int lane = 0; lane < NUM_GAUSSIANRAND_LANES; lane++)
+		pState->laneSeeds[lane] = (unsigned int) LargerRandJumpSeed(pState->laneSeeds[lane], k);
+	pState->numAvailableResults = 0;
+	pState->numAvailableZigResults = 0;
+	pState->numAvailableCompactResults = 0;
+	pState->numStagedPairs = 0;
+}
+
+// SelectGaussianRandVecISA() returns the fastest instruction set we have a GaussianRandVec() kernel for
+//     on the running CPU.
+static MiscRandISA	SelectGaussianRandVecISA()
+{
+	if (supportAVX512F() && supportAVX512VL())
+		return MISCRAND_ISA_AVX512;
+	else if (supportAVX2())
+		return MISCRAND_ISA_AVX2;
+	else if (supportSSE41())
+		return MISCRAND_ISA_SSE41;
+	else
+		return MISCRAND_ISA_SCALAR;
+}
+
+static void	GaussianRandVecBlockResolve(unsigned int *pLaneSeeds, double *pResults);
+static void	GaussianRandVecFloatBlockResolve(unsigned int *pLaneSeeds, float *pResults);
+static void	GaussianRandVecCompactBlocksResolve(unsigned int *pLaneSeeds, double (*pStaged)[NUM_STAGED_PAIRS],
+	int *pNumStaged, double *pResults, size_t numBlocks);
+
+// pGaussianRandVecBlock points to the GaussianRandVec() kernel in use and gaussianRandVecISA tells which
+//     one it is.  Both are bound by the dynamic initializer of bGaussianRandVecBound at startup, so callers
+//     never run cpudetect.cpp themselves.  pGaussianRandVecBlock is constant-initialized to
+//     GaussianRandVecBlockResolve(), which covers the calls from other static initializers running
+//     before that.
+static GaussianRandVecBlock_t	pGaussianRandVecBlock = GaussianRandVecBlockResolve;
+static GaussianRandVecFloatBlock_t	pGaussianRandVecFloatBlock = GaussianRandVecFloatBlockResolve;
+static GaussianRandVecCompactBlocks_t	pGaussianRandVecCompactBlocks = GaussianRandVecCompactBlocksResolve;
+static MiscRandISA				gaussianRandVecISA = MISCRAND_ISA_SCALAR;
+static const bool				bGaussianRandVecBound = GaussianRandVecSetISA(SelectGaussianRandVecISA());
+
+static void	GaussianRandVecBlockResolve(unsigned int *pLaneSeeds, double *pResults)
+{
+	GaussianRandVecSetISA(SelectGaussianRandVecISA());
+	pGaussianRandVecBlock(pLaneSeeds, pResults);
+}
+
+static void	GaussianRandVecFloatBlockResolve(unsigned int *pLaneSeeds, float *pResults)
+{
+	GaussianRandVecSetISA(SelectGaussianRandVecISA());
+	pGaussianRandVecFloatBlock(pLaneSeeds, pResults);
+}
+
+static void	GaussianRandVecCompactBlocksResolve(unsigned int *pLaneSeeds, double (*pStaged)[NUM_STAGED_PAIRS],
+	int *pNumStaged, double *pResults, size_t numBlocks)
+{
+	GaussianRandVecSetISA(SelectGaussianRandVecISA());
+	pGaussianRandVecCompactBlocks(pLaneSeeds, pStaged, pNumStaged, pResults, numBlocks);
+}
+
+// GaussianRandVecISA() returns the instruction set of the kernel GaussianRandVec() and its siblings use.
+MiscRandISA	MISCRAND_CDECL	GaussianRandVecISA()
+{
+	if (pGaussianRandVecBlock == GaussianRandVecBlockResolve)
+		GaussianRandVecSetISA(SelectGaussianRandVecISA());
+	return gaussianRandVecISA;
+}
 
-// sGaussianRandVec() resets the four random seeds used to generate Gaussian random variables for
-//     GaussianRandVec().
-void		__cdecl sGaussianRandVec(int s0, int s1, int s2, int s3,
-	                                 int s4, int s5, int s6, int s7)
+// GaussianRandVecSetISA() makes GaussianRandVec(), GaussianRandVecFloat(), GaussianRandVecCompact() and their
+//     siblings use the kernels for isa, e.g. for
+//     benchmarking the kernels against each other.  It returns false and changes nothing if the running
+//     CPU does not support isa.  It is not meant to be called while other threads are generating.
+bool	MISCRAND_CDECL	GaussianRandVecSetISA(MiscRandISA isa)
 {
-	avxRand = _mm256_set_epi32(s7, s6, s5, s4, s3, s2, s1, s0);
-	numAvailableResults = 0;
+	switch (isa)
+	{
+	case MISCRAND_ISA_AVX512:
+		if (!supportAVX512F() || !supportAVX512VL())
+			return false;
+		pGaussianRandVecBlock = GaussianRandVecBlockAVX512;
+		pGaussianRandVecFloatBlock = GaussianRandVecFloatBlockAVX512;
+		pGaussianRandVecCompactBlocks = GaussianRandVecCompactBlocksAVX512;
+		break;
+	case MISCRAND_ISA_AVX2:
+		if (!supportAVX2())
+			return false;
+		pGaussianRandVecBlock = GaussianRandVecBlockAVX2;
+		pGaussianRandVecFloatBlock = GaussianRandVecFloatBlockAVX2;
+		pGaussianRandVecCompactBlocks = GaussianRandVecCompactBlocksAVX2;
+		break;
+	case MISCRAND_ISA_SSE41:
+		if (!supportSSE41())
+			return false;
+		pGaussianRandVecBlock = GaussianRandVecBlockSSE41;
+		pGaussianRandVecFloatBlock = GaussianRandVecFloatBlockSSE41;
+		pGaussianRandVecCompactBlocks = GaussianRandVecCompactBlocksScalar;	// Two doubles per __m128d leave little to compact
+		break;
+	case MISCRAND_ISA_SCALAR:
+		pGaussianRandVecBlock = GaussianRandVecBlockScalar;
+		pGaussianRandVecFloatBlock = GaussianRandVecFloatBlockScalar;
+		pGaussianRandVecCompactBlocks = GaussianRandVecCompactBlocksScalar;
+		break;
+	default:
+		return false;
+	}
+	gaussianRandVecISA = isa;
+	return true;
 }
 
 // GaussianRandVec() returns a Gaussian-distributed double random number with zero mean and unit variance.
-double		__cdecl	GaussianRandVec()
+double		MISCRAND_CDECL	GaussianRandVec()
+{
+	return GaussianRandVec_r(MiscRandDefaultState());
+}
+
+// GaussianRandVec_r() is GaussianRandVec() working on *pState.
+double		MISCRAND_CDECL	GaussianRandVec_r(MiscRandState *pState)
+{
+	unsigned long long	tscStart = MISCRAND_TSC(), numRefillCycles = 0;
+
+	if (pState->numAvailableResults == 0)
+	{
+		// We don't have available results in results[]; time to refresh them in parallel, a block of
+		//     NUM_GAUSSIANRAND_BLOCK numbers per kernel run.
+		for (int i = 0; i < NUM_GAUSSIANRAND_GENERATED; i += NUM_GAUSSIANRAND_BLOCK)
+			pGaussianRandVecBlock(pState->laneSeeds, pState->results + i);
+		pState->numAvailableResults = NUM_GAUSSIANRAND_GENERATED;
+		numRefillCycles = MISCRAND_TSC() - tscStart;
+		MISCRAND_COUNT(numRefills, 1);
+		MISCRAND_COUNT(refillCycles, numRefillCycles);
+	}
+	MISCRAND_COUNT(numSamples, 1);
+	MISCRAND_COUNT(serveCycles, MISCRAND_TSC() - tscStart - numRefillCycles);
+
+	// We serve results[] front to back, the same order GaussianRandVecFill() stores whole blocks in, so
+	//     that the sequence does not depend on how it is split between the two functions.  The kernels
+	//     store each block in the order the original GaussianRandVec() served it, from the back.
+	return pState->results[NUM_GAUSSIANRAND_GENERATED - pState->numAvailableResults--];
+}
+
+// GaussianRandVecFill() fills pOut[0], ..., pOut[n - 1] with Gaussian-distributed double random numbers
+//     with zero mean and unit variance.  It writes exactly what n GaussianRandVec() calls would return, so
+//     the two can be mixed freely.  pOut does not need to be aligned.
+void		MISCRAND_CDECL	GaussianRandVecFill(double *pOut, size_t n)
+{
+	GaussianRandVecFill_r(MiscRandDefaultState(), pOut, n);
+}
+
+// GaussianRandVecFill_r() is GaussianRandVecFill() working on *pState.
+void		MISCRAND_CDECL	GaussianRandVecFill_r(MiscRandState *pState, double *pOut, size_t n)
+{
+	unsigned long long	tscBody;
+
+	// The head: whatever is left in results[] from earlier calls comes first.  We cannot skip ahead to a
+	//     64-byte boundary of pOut here without reordering the sequence, so the blocks below may well be
+	//     stored unaligned; unaligned SIMD stores cost little next to the computations anyway.
+	while ((n > 0) && (pState->numAvailableResults > 0))
+	{
+		*pOut++ = GaussianRandVec_r(pState);
+		n--;
+	}
+
+	// The body: the kernel writes straight into pOut without going through results[].  The counters take
+	//     the whole body as kernel time, as reading the time stamp counter around each run would cost a
+	//     good part of the run.
+	tscBody = MISCRAND_TSC();
+	MISCRAND_COUNT(numSamples, n - n % NUM_GAUSSIANRAND_BLOCK);
+	while (n >= NUM_GAUSSIANRAND_BLOCK)
+	{
+		pGaussianRandVecBlock(pState->laneSeeds, pOut);
+		pOut += NUM_GAUSSIANRAND_BLOCK;
+		n -= NUM_GAUSSIANRAND_BLOCK;
+	}
+	MISCRAND_COUNT(refillCycles, MISCRAND_TSC() - tscBody);
+
+	// The tail: fewer than NUM_GAUSSIANRAND_BLOCK numbers are left.  We serve them from results[], and
+	//     whatever remains there is kept for the next GaussianRandVec() or GaussianRandVecFill() call.
+	while (n > 0)
+	{
+		*pOut++ = GaussianRandVec_r(pState);
+		n--;
+	}
+}
+
+// GaussianRandVecCompact() returns a Gaussian-distributed double random number with zero mean and unit
+//     variance, like GaussianRandVec() but with the lane-compacting kernels: rejected (u, v) pairs do not
+//     hold back the other lanes, so fewer rounds are needed per block.  It draws from the same lanes as
+//     GaussianRandVec() but pairs them up differently, so the two return different sequences; mixing the
+//     two on one MiscRandState is allowed but gives yet another sequence.
+double		MISCRAND_CDECL	GaussianRandVecCompact()
+{
+	return GaussianRandVecCompact_r(MiscRandDefaultState());
+}
+
+// GaussianRandVecCompactFill() fills pOut[0], ..., pOut[n - 1] with what n GaussianRandVecCompact() calls
+//     would return.  pOut does not need to be aligned.
+void		MISCRAND_CDECL	GaussianRandVecCompactFill(double *pOut, size_t n)
+{
+	GaussianRandVecCompactFill_r(MiscRandDefaultState(), pOut, n);
+}
+
+// GaussianRandVecCompact_r() is GaussianRandVecCompact() working on *pState.
+double		MISCRAND_CDECL	GaussianRandVecCompact_r(MiscRandState *pState)
+{
+	if (pState->numAvailableCompactResults == 0)
+	{
+		pGaussianRandVecCompactBlocks(pState->laneSeeds, pState->stagedPairs, &pState->numStagedPairs,
+			pState->compactResults, NUM_GAUSSIANRAND_GENERATED / NUM_GAUSSIANRAND_BLOCK);
+		pState->numAvailableCompactResults = NUM_GAUSSIANRAND_GENERATED;
+	}
+
+	return pState->compactResults[NUM_GAUSSIANRAND_GENERATED - pState->numAvailableCompactResults--];
+}
+
+// GaussianRandVecCompactFill_r() is GaussianRandVecCompactFill() working on *pState.  It splits pOut into a
+//     head, a body and a tail the same way GaussianRandVecFill_r() does, handing the whole body to the
+//     kernel in one call.
+void		MISCRAND_CDECL	GaussianRandVecCompactFill_r(MiscRandState *pState, double *pOut, size_t n)
+{
+	size_t	numBlocks;
+
+	while ((n > 0) && (pState->numAvailableCompactResults > 0))
+	{
+		*pOut++ = GaussianRandVecCompact_r(pState);
+		n--;
+	}
+
+	numBlocks = n / NUM_GAUSSIANRAND_BLOCK;
+	if (numBlocks > 0)
+	{
+		pGaussianRandVecCompactBlocks(pState->laneSeeds, pState->stagedPairs, &pState->numStagedPairs, pOut, numBlocks);
+		pOut += numBlocks * NUM_GAUSSIANRAND_BLOCK;
+		n -= numBlocks * NUM_GAUSSIANRAND_BLOCK;
+	}
+
+	while (n > 0)
+	{
+		*pOut++ = GaussianRandVecCompact_r(pState);
+		n--;
+	}
+}
+
+// sGaussianRandVecFloat() resets the sixteen random seeds, pSeeds[0] to pSeeds[15], used to generate Gaussian
+//     random variables for GaussianRandVecFloat().
+void		MISCRAND_CDECL sGaussianRandVecFloat(const unsigned int *pSeeds)
+{
+	sGaussianRandVecFloat_r(MiscRandDefaultState(), pSeeds);
+}
+
+// GaussianRandVecFloat() returns a Gaussian-distributed float random number with zero mean and unit
+//     variance.  It runs the Polar form of Box-Muller transform on sixteen float lanes, twice as many as
+//     GaussianRandVec() runs on doubles; the uniform numbers only have 15 bits anyway.
+float		MISCRAND_CDECL	GaussianRandVecFloat()
+{
+	return GaussianRandVecFloat_r(MiscRandDefaultState());
+}
+
+// GaussianRandVecFloatFill() fills pOut[0], ..., pOut[n - 1] with what n GaussianRandVecFloat() calls
+//     would return.  pOut does not need to be aligned.
+void		MISCRAND_CDECL	GaussianRandVecFloatFill(float *pOut, size_t n)
+{
+	GaussianRandVecFloatFill_r(MiscRandDefaultState(), pOut, n);
+}
+
+// GaussianRandVecFloatJump() moves each of the sixteen lanes k steps ahead, as GaussianRandVecJump() does
+//     for the eight double lanes.
+void		MISCRAND_CDECL	GaussianRandVecFloatJump(unsigned long long k)
 {
-#define NUM_GAUSSIANRAND_GENERATED      16
-	// The computations are based on AVX512, so we want results[] to be aligned on 64-byte.
-	static __declspec(align(64)) double results[NUM_GAUSSIANRAND_GENERATED];
+	GaussianRandVecFloatJump_r(MiscRandDefaultState(), k);
+}
 
-	if (numAvailableResults == 0)
+// sGaussianRandVecFloat_r() is sGaussianRandVecFloat() working on *pState.
+void		MISCRAND_CDECL sGaussianRandVecFloat_r(MiscRandState *pState, const unsigned int *pSeeds)
+{
+	for (int lane = 0; lane < NUM_GAUSSIANRANDFLOAT_LANES; lane++)
+		pState->floatLaneSeeds[lane] = pSeeds[lane];
+	pState->numAvailableFloatResults = 0;
+}
+
+// GaussianRandVecFloat_r() is GaussianRandVecFloat() working on *pState.
+float		MISCRAND_CDECL	GaussianRandVecFloat_r(MiscRandState *pState)
+{
+	if (pState->numAvailableFloatResults == 0)
 	{
-		// We don't have available results in results[]; time to refresh them in parallel.
-		//     The implementation here assumes AVX512 support.  We carry out the computations in
-		//     eight (NUM_GAUSSIANRAND_GENERATED/2) lanes of doubles (64-bit).  We only use 32-bit integers.
-		const __m256i l214013 = _mm256_set_epi32(214013L, 214013L, 214013L, 214013L, 214013L, 214013L, 214013L, 214013L);
-		const __m256i l2531011 = _mm256_set_epi32(2531011L, 2531011L, 2531011L, 2531011L, 2531011L, 2531011L, 2531011L, 2531011L);
-		const __m256i m32767 = _mm256_set_epi32(0x7fff, 0x7fff, 0x7fff, 0x7fff, 0x7fff, 0x7fff, 0x7fff, 0x7fff);
-		const __m512d dTwoOverRANDMAX = _mm512_set1_pd(2.0 / RAND_MAX);
-		const __m512d dOnes = _mm512_set1_pd(1.0);
-		const __m512d dZeros = _mm512_setzero_pd();
-		const __m512d dMTwos = _mm512_set1_pd(-2.0);
-		__m256i prevAvxRand = avxRand;
-		__m512d avxdS = dZeros;
-		__mmask8 dMasks = 0xff;
-		__m512d avxdU, avxdV, dTmp;
-
-		do
-		{
-			// dMasks is the mask for eight 64-bit lanes, while iMasks is the corresponding eight 32-bit lanes.
-			// We use iMasks to choose if we want to update the avxRand lanes.  If the lane is 0x00000000, we
-			//     restore avxRand lane to its prior value, and thus going through the loop just repeats.
-			avxRand = _mm256_mask_blend_epi32(dMasks, prevAvxRand, avxRand);
-			prevAvxRand = avxRand;
-
-			// Evaluate avxRand = avxRand * 214013L + 2531011L and then (avxRand >> 16) & 0x7fff for u.
-			//     Note that avxRand is between 0 and 32767, and avxRand * 214013L + 2531011L can
-			//     overflow 32-bit integers.  However, since rand() internally only used int to keep its
-			//     states, this means we can ignore the carry-outs.
-			avxRand = _mm256_mullo_epi32(avxRand, l214013);				// avxRand in 8 32-bit integer lanes
-			avxRand = _mm256_add_epi32(avxRand, l2531011);
-			__m256i     avxU = _mm256_srli_epi32(avxRand, 16);
-			avxU = _mm256_and_si256(avxU, m32767);
-
-			// Repeating the steps to generate v
-			avxRand = _mm256_mullo_epi32(avxRand, l214013);
-			avxRand = _mm256_add_epi32(avxRand, l2531011);
-			__m256i     avxV = _mm256_srli_epi32(avxRand, 16);
-			avxV = _mm256_and_si256(avxV, m32767);
-
-			// u = 2.0*((double)rand() / RAND_MAX) - 1;
-			// v = 2.0*((double)rand() / RAND_MAX) - 1;
-			// Both avxdU and avxdV are in eight 64-bit double lanes.  Note that we use dMasks to decide if we want
-			//     to update u and v.  Once dMasks shows 0 bit in one lane, the corresponding u and v are no longer
-			//     updated, and this implies s also stops being updated.
-			avxdU = _mm512_cvtepi32_pd(avxU);
-			avxdV = _mm512_cvtepi32_pd(avxV);
-			avxdU = _mm512_fmsub_pd(avxdU, dTwoOverRANDMAX, dOnes);
-			avxdV = _mm512_fmsub_pd(avxdV, dTwoOverRANDMAX, dOnes);
-
-			// s = u*u + v*v;
-			avxdS = _mm512_add_pd(_mm512_mul_pd(avxdU, avxdU), _mm512_mul_pd(avxdV, avxdV));
-
-			// Check if (s >= 1.0) || (s == 0.0).  Note that we evaluate the loop-terminating condition in
-			//     eight lanes.  *ANY* lane with the specified condition means we continue the loop.  dMasks
-			//     started with 0xff.  When one of the lanes hit 0 (represented by a bit in dMasks), it no
-			//     longer needs to keep looping.  If dMasks becomes 0, the loop is broken.  Otherwise the
-			//     loop continues, but the 0-bit lane will stop avxRand from being updated.
-			dMasks = _mm512_cmp_pd_mask(avxdS, dOnes, _CMP_GE_OQ) | _mm512_cmp_pd_mask(avxdS, dZeros, _CMP_EQ_OQ);
-		} while (dMasks);
-
-		// u*sqrt(-2.0 * log(s)/s)
-		// v*sqrt(-2.0 * log(s)/s)
-		// It seems Intel Short Vector Math Library (SVML) has been supported by Microsoft Visual Studio
-		//     2019 since Preview 2, thus we can use _mm256_log_pd() and _mm256_div_pd() here.
-		//     https://devblogs.microsoft.com/cppblog/msvc-backend-updates-in-visual-studio-2019-preview-2/
-		dTmp = _mm512_log_pd(avxdS);	// SVML/AVX
-		dTmp = _mm512_div_pd(dTmp, avxdS);
-		dTmp = _mm512_sqrt_pd(_mm512_mul_pd(dTmp, dMTwos));
-		avxdU = _mm512_mul_pd(avxdU, dTmp);
-		avxdV = _mm512_mul_pd(avxdV, dTmp);
-
-		_mm512_store_pd(results, avxdU);
-		_mm512_store_pd(results + NUM_GAUSSIANRAND_GENERATED/2, avxdV);
-
-		numAvailableResults = NUM_GAUSSIANRAND_GENERATED;
+		pGaussianRandVecFloatBlock(pState->floatLaneSeeds, pState->floatResults);
+		pState->numAvailableFloatResults = NUM_GAUSSIANRANDFLOAT_GENERATED;
 	}
 
-	numAvailableResults--;
-	return results[numAvailableResults];
+	return pState->floatResults[NUM_GAUSSIANRANDFLOAT_GENERATED - pState->numAvailableFloatResults--];
+}
+
+// GaussianRandVecFloatFill_r() is GaussianRandVecFloatFill() working on *pState.  It splits pOut into a
+//     head, a body and a tail the same way GaussianRandVecFill_r() does.
+void		MISCRAND_CDECL	GaussianRandVecFloatFill_r(MiscRandState *pState, float *pOut, size_t n)
+{
+	while ((n > 0) && (pState->numAvailableFloatResults > 0))
+	{
+		*pOut++ = GaussianRandVecFloat_r(pState);
+		n--;
+	}
+
+	while (n >= NUM_GAUSSIANRANDFLOAT_GENERATED)
+	{
+		pGaussianRandVecFloatBlock(pState->floatLaneSeeds, pOut);
+		pOut += NUM_GAUSSIANRANDFLOAT_GENERATED;
+		n -= NUM_GAUSSIANRANDFLOAT_GENERATED;
+	}
+
+	while (n > 0)
+	{
+		*pOut++ = GaussianRandVecFloat_r(pState);
+		n--;
+	}
+}
+
+// GaussianRandVecFloatJump_r() is GaussianRandVecFloatJump() working on *pState.
+void		MISCRAND_CDECL	GaussianRandVecFloatJump_r(MiscRandState *pState, unsigned long long k)
+{
+	for (int lane = 0; lane < NUM_GAUSSIANRANDFLOAT_LANES; lane++)
+		pState->floatLaneSeeds[lane] = (unsigned int) LargerRandJumpSeed(pState->floatLaneSeeds[lane], k);
+	pState->numAvailableFloatResults = 0;
 }
@@ -0,0 +1,205 @@
+// GaussianRandRing.cpp keeps Gaussian random numbers ready ahead of time for consumers that take one number
+// at a time and cannot afford the refill GaussianRandVec() does on every NUM_GAUSSIANRAND_GENERATED-th
+// call.  A producer thread runs the GaussianRandVec() kernel straight into a ring buffer, and
+// GaussianRandRingNext() only dequeues one number from it.
+//
+// The ring is lock-free on both sides: the producer publishes blocks of NUM_GAUSSIANRAND_GENERATED numbers
+// by moving tail, and the consumers take numbers by moving head, each index on its own cache line.  With one
+// consumer, head is only stored; with several, the consumers claim numbers with a compare-and-swap on head.
+// The producer fills the ring up and then sleeps until a consumer takes it down to the low watermark, so
+// the consumers only touch the mutex when they wake it.  A consumer that finds the ring empty does not wait
+// for the producer; it calls GaussianRandVec() on its own thread instead.
+
+#include <stdlib.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <immintrin.h>
+#include "MiscRand.h"
+
+// GaussianRandRing keeps the ring and its producer.  The indexes count numbers since the start and are
+//     masked only to address slots[]; at 64 bits they never wrap.
+struct alignas(64) GaussianRandRing
+{
+	alignas(64) std::atomic<unsigned long long>	head;	// Next number to take
+	alignas(64) unsigned long long	cachedTail;			// Last tail seen by the single consumer
+	alignas(64) std::atomic<unsigned long long>	tail;	// End of the numbers published
+	unsigned long long		cachedHead;							// Last head seen by the producer
+	alignas(64) std::atomic<bool>	bProducerSleeping;
+	std::atomic<bool>		bStop;
+	std::mutex				mutex;
+	std::condition_variable	wakeUp;
+	std::thread				producer;
+	MiscRandState			producerState;
+	double					*pSlots;
+	unsigned long long		mask;								// Number of slots - 1
+	unsigned long long		lowWatermark;
+	bool					bMultiConsumer;
+};
+
+// GaussianRandRingProduce() is the producer thread: it publishes one kernel block at a time while there is
+//     room, and sleeps while the ring holds more than lowWatermark numbers.
+static void	GaussianRandRingProduce(GaussianRandRing *pRing)
+{
+	const unsigned long long	numSlots = pRing->mask + 1;
+	unsigned long long			tail = pRing->tail.load(std::memory_order_relaxed);
+
+	for (;;)
+	{
+		if (tail + NUM_GAUSSIANRAND_GENERATED - pRing->cachedHead > numSlots)
+			pRing->cachedHead = pRing->head.load(std::memory_order_acquire);
+		if (tail + NUM_GAUSSIANRAND_GENERATED - pRing->cachedHead <= numSlots)
+		{
+			// numSlots is a multiple of NUM_GAUSSIANRAND_GENERATED, so a block never wraps around the ring.
+			GaussianRandVecFill_r(&pRing->producerState, &pRing->pSlots[tail & pRing->mask], NUM_GAUSSIANRAND_GENERATED);
+			tail += NUM_GAUSSIANRAND_GENERATED;
+			pRing->tail.store(tail, std::memory_order_release);
+			continue;
+		}
+
+		std::unique_lock<std::mutex>	lock(pRing->mutex);
+
+		// A consumer stores head and then checks bProducerSleeping, and we store bProducerSleeping and then
+		//     check head, with a full fence in between on both sides, so one of us sees the other.
+		pRing->bProducerSleeping.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		pRing->wakeUp.wait(lock, [&] { return pRing->bStop.load(std::memory_order_relaxed)
+			|| (tail - pRing->head.load(std::memory_order_relaxed) <= pRing->lowWatermark); });
+		pRing->bProducerSleeping.store(false, std::memory_order_relaxed);
+		if (pRing->bStop.load(std::memory_order_relaxed))
+			return;
+	}
+}
+
+// WakeProducer() wakes the producer if it sleeps.  The consumers call it once they see lowWatermark or
+//     fewer numbers left.
+static void	WakeProducer(GaussianRandRing *pRing)
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (pRing->bProducerSleeping.load(std::memory_order_relaxed))
+	{
+		std::lock_guard<std::mutex>	lock(pRing->mutex);
+
+		pRing->wakeUp.notify_one();
+	}
+}
+
+// GaussianRandRingCreate() starts a producer thread filling a ring of at least ringSize numbers, rounded up
+//     to a power of two and to at least 2 * NUM_GAUSSIANRAND_GENERATED.  The producer refills the ring once
+//     it holds lowWatermark or fewer numbers; lowWatermark is cut to ringSize - NUM_GAUSSIANRAND_GENERATED
+//     if it is larger.  bMultiConsumer lets several threads call GaussianRandRingNext() on the ring at once,
+//     at the cost of a compare-and-swap per number.  The producer generates the numbers
+//     GaussianRandVec_r() returns on SplitStreams(pState, 1, seed, 0), so a single consumer that never
+//     finds the ring empty gets that sequence.  It returns NULL if it cannot allocate the ring.
+GaussianRandRing *	MISCRAND_CDECL	GaussianRandRingCreate(size_t ringSize, size_t lowWatermark, bool bMultiConsumer,
+	unsigned long seed)
+{
+	unsigned long long	numSlots = 2 * NUM_GAUSSIANRAND_GENERATED;
+	void				*pMemory;
+	GaussianRandRing	*pRing;
+
+	while (numSlots < ringSize)
+		numSlots *= 2;
+	if (lowWatermark > numSlots - NUM_GAUSSIANRAND_GENERATED)
+		lowWatermark = (size_t) (numSlots - NUM_GAUSSIANRAND_GENERATED);
+
+	pMemory = _mm_malloc(sizeof(GaussianRandRing), 64);
+	if (pMemory == NULL)
+		return NULL;
+	pRing = new (pMemory) GaussianRandRing;
+	pRing->pSlots = (double *) _mm_malloc(numSlots * sizeof(double), 64);
+	if (pRing->pSlots == NULL)
+	{
+		pRing->~GaussianRandRing();
+		_mm_free(pMemory);
+		return NULL;
+	}
+
+	pRing->head.store(0, std::memory_order_relaxed);
+	pRing->cachedTail = 0;
+	pRing->tail.store(0, std::memory_order_relaxed);
+	pRing->cachedHead = 0;
+	pRing->bProducerSleeping.store(false, std::memory_order_relaxed);
+	pRing->bStop.store(false, std::memory_order_relaxed);
+	SplitStreams(&pRing->producerState, 1, seed, 0);
+	pRing->mask = numSlots - 1;
+	pRing->lowWatermark = lowWatermark;
+	pRing->bMultiConsumer = bMultiConsumer;
+	pRing->producer = std::thread(GaussianRandRingProduce, pRing);
+
+	return pRing;
+}
+
+// GaussianRandRingDestroy() stops the producer and frees the ring.  No consumer may use pRing any more.
+void	MISCRAND_CDECL	GaussianRandRingDestroy(GaussianRandRing *pRing)
+{
+	if (pRing == NULL)
+		return;
+
+	{
+		std::lock_guard<std::mutex>	lock(pRing->mutex);
+
+		pRing->bStop.store(true, std::memory_order_relaxed);
+	}
+	pRing->wakeUp.notify_one();
+	pRing->producer.join();
+
+	_mm_free(pRing->pSlots);
+	pRing->~GaussianRandRing();
+	_mm_free(pRing);
+}
+
+// GaussianRandRingNext() returns the next Gaussian random number from the ring, or GaussianRandVec() of the
+//     calling thread if the ring is empty.  Unless the ring was created with bMultiConsumer, only one thread
+//     may call it on pRing.
+double	MISCRAND_CDECL	GaussianRandRingNext(GaussianRandRing *pRing)
+{
+	unsigned long long	head, tail;
+	double				result;
+
+	if (!pRing->bMultiConsumer)
+	{
+		head = pRing->head.load(std::memory_order_relaxed);
+		if (head == pRing->cachedTail)
+		{
+			pRing->cachedTail = pRing->tail.load(std::memory_order_acquire);
+			if (head == pRing->cachedTail)
+			{
+				WakeProducer(pRing);
+				return GaussianRandVec();
+			}
+		}
+		result = pRing->pSlots[head & pRing->mask];
+		pRing->head.store(head + 1, std::memory_order_release);
+
+		// The ring may well hold more than cachedTail says, so we look at tail before waking the producer.
+		if (pRing->cachedTail - (head + 1) <= pRing->lowWatermark)
+		{
+			pRing->cachedTail = pRing->tail.load(std::memory_order_acquire);
+			if (pRing->cachedTail - (head + 1) <= pRing->lowWatermark)
+				WakeProducer(pRing);
+		}
+		return result;
+	}
+
+	// With several consumers, we read the slot before claiming it.  If the compare-and-swap succeeds, head
+	//     has not moved past the slot since, so the producer cannot have written it again in between.
+	head = pRing->head.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		tail = pRing->tail.load(std::memory_order_acquire);
+		if (head == tail)
+		{
+			WakeProducer(pRing);
+			return GaussianRandVec();
+		}
+		result = pRing->pSlots[head & pRing->mask];
+		if (pRing->head.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+			break;
+	}
+	if (tail - (head + 1) <= pRing->lowWatermark)
+		WakeProducer(pRing);
+	return result;
+}
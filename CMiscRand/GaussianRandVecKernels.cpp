@@ -0,0 +1,676 @@
+// GaussianRandVecKernels.cpp implements the GaussianRandVec() kernels declared in GaussianRandVecKernels.h,
+// from AVX512 down to plain C.  Each of them carries out the Polar form of Box-Muller transform in eight
+// lanes, each lane running its own copy of the linear congruential generator behind rand().
+
+#include <stdlib.h>
+#include <math.h>
+#include <immintrin.h>
+#include "MiscRand.h"
+#include "GaussianRandVecKernels.h"
+#include "MiscRandVecMath.h"
+#include "MiscRandCounters.h"
+
+// GaussianRandVecBlockAVX512() is the AVX512 kernel.  The stores are aligned ones in disguise whenever
+//     pResults happens to be on a 64-byte boundary.  Note that _mm256_mask_blend_epi32() needs AVX512VL
+//     on top of AVX512F.  Like the other GaussianRandVec() kernels, it counts its rounds, and the lanes
+//     frozen in each, in the MiscRandCounters of the thread when the library is built to count.
+void	GaussianRandVecBlockAVX512(unsigned int *pLaneSeeds, double *pResults)
+{
+	// The implementation here assumes AVX512 support.  We carry out the computations in
+	//     eight (NUM_GAUSSIANRAND_BLOCK/2) lanes of doubles (64-bit).  We only use 32-bit integers.
+	const __m256i l214013 = _mm256_set_epi32(214013L, 214013L, 214013L, 214013L, 214013L, 214013L, 214013L, 214013L);
+	const __m256i l2531011 = _mm256_set_epi32(2531011L, 2531011L, 2531011L, 2531011L, 2531011L, 2531011L, 2531011L, 2531011L);
+	const __m256i m32767 = _mm256_set_epi32(0x7fff, 0x7fff, 0x7fff, 0x7fff, 0x7fff, 0x7fff, 0x7fff, 0x7fff);
+	const __m512d dTwoOverRANDMAX = _mm512_set1_pd(2.0 / LCG_RAND_MAX);
+	const __m512d dOnes = _mm512_set1_pd(1.0);
+	const __m512d dZeros = _mm512_setzero_pd();
+	__m256i avxRand = _mm256_loadu_si256((const __m256i *) pLaneSeeds);
+	__m256i prevAvxRand = avxRand;
+	__m512d avxdS = dZeros;
+	__mmask8 dMasks = 0xff;
+	__m512d avxdU, avxdV, dTmp;
+
+	MISCRAND_COUNT(numBlocks, 1);
+	do
+	{
+		MISCRAND_COUNT(numRejectionRounds, 1);
+		MISCRAND_COUNT(numFrozenLanes, NUM_GAUSSIANRAND_LANES - MiscRandCountLanes(dMasks));
+
+		// dMasks is the mask for eight 64-bit lanes, while iMasks is the corresponding eight 32-bit lanes.
+		// We use iMasks to choose if we want to update the avxRand lanes.  If the lane is 0x00000000, we
+		//     restore avxRand lane to its prior value, and thus going through the loop just repeats.
+		avxRand = _mm256_mask_blend_epi32(dMasks, prevAvxRand, avxRand);
+		prevAvxRand = avxRand;
+
+		// Evaluate avxRand = avxRand * 214013L + 2531011L and then (avxRand >> 16) & 0x7fff for u.
+		//     Note that avxRand is between 0 and 32767, and avxRand * 214013L + 2531011L can
+		//     overflow 32-bit integers.  However, since rand() internally only used int to keep its
+		//     states, this means we can ignore the carry-outs.
+		avxRand = _mm256_mullo_epi32(avxRand, l214013);				// avxRand in 8 32-bit integer lanes
+		avxRand = _mm256_add_epi32(avxRand, l2531011);
+		__m256i     avxU = _mm256_srli_epi32(avxRand, 16);
+		avxU = _mm256_and_si256(avxU, m32767);
+
+		// Repeating the steps to generate v
+		avxRand = _mm256_mullo_epi32(avxRand, l214013);
+		avxRand = _mm256_add_epi32(avxRand, l2531011);
+		__m256i     avxV = _mm256_srli_epi32(avxRand, 16);
+		avxV = _mm256_and_si256(avxV, m32767);
+
+		// u = 2.0*((double)rand() / RAND_MAX) - 1;
+		// v = 2.0*((double)rand() / RAND_MAX) - 1;
+		// Both avxdU and avxdV are in eight 64-bit double lanes.  Note that we use dMasks to decide if we want
+		//     to update u and v.  Once dMasks shows 0 bit in one lane, the corresponding u and v are no longer
+		//     updated, and this implies s also stops being updated.
+		avxdU = _mm512_cvtepi32_pd(avxU);
+		avxdV = _mm512_cvtepi32_pd(avxV);
+		avxdU = _mm512_fmsub_pd(avxdU, dTwoOverRANDMAX, dOnes);
+		avxdV = _mm512_fmsub_pd(avxdV, dTwoOverRANDMAX, dOnes);
+
+		// s = u*u + v*v;
+		avxdS = _mm512_add_pd(_mm512_mul_pd(avxdU, avxdU), _mm512_mul_pd(avxdV, avxdV));
+
+		// Check if (s >= 1.0) || (s == 0.0).  Note that we evaluate the loop-terminating condition in
+		//     eight lanes.  *ANY* lane with the specified condition means we continue the loop.  dMasks
+		//     started with 0xff.  When one of the lanes hit 0 (represented by a bit in dMasks), it no
+		//     longer needs to keep looping.  If dMasks becomes 0, the loop is broken.  Otherwise the
+		//     loop continues, but the 0-bit lane will stop avxRand from being updated.
+		dMasks = _mm512_cmp_pd_mask(avxdS, dOnes, _CMP_GE_OQ) | _mm512_cmp_pd_mask(avxdS, dZeros, _CMP_EQ_OQ);
+	} while (dMasks);
+
+	// u*sqrt(-2.0 * log(s)/s)
+	// v*sqrt(-2.0 * log(s)/s)
+	// We used to call _mm512_log_pd() of Intel Short Vector Math Library (SVML) here, which only MSVC
+	//     and ICC have; PolarFactor512d() in MiscRandVecMath.h builds with any compiler.
+	dTmp = PolarFactor512d(avxdS);
+	avxdU = _mm512_mul_pd(avxdU, dTmp);
+	avxdV = _mm512_mul_pd(avxdV, dTmp);
+
+	// The block is stored in the order GaussianRandVec() has always served it: v of lane 7 down to lane 0,
+	//     then u of lane 7 down to lane 0.
+	const __m512i iReversed = _mm512_set_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+
+	_mm512_storeu_pd(pResults, _mm512_permutexvar_pd(iReversed, avxdV));
+	_mm512_storeu_pd(pResults + NUM_GAUSSIANRAND_BLOCK/2, _mm512_permutexvar_pd(iReversed, avxdU));
+	_mm256_storeu_si256((__m256i *) pLaneSeeds, avxRand);
+}
+
+// GaussianRandVecBlockAVX2() is the AVX2 kernel.  The eight 32-bit lanes fit in one __m256i as in the
+//     AVX512 kernel, but an __m256d only holds four doubles, so the floating-point part runs on the lower
+//     lanes 0-3 and the upper lanes 4-7 separately.  We do not assume FMA here.
+void	GaussianRandVecBlockAVX2(unsigned int *pLaneSeeds, double *pResults)
+{
+	const __m256i l214013 = _mm256_set1_epi32(214013L);
+	const __m256i l2531011 = _mm256_set1_epi32(2531011L);
+	const __m256i m32767 = _mm256_set1_epi32(0x7fff);
+	const __m256i iLaneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	const __m256d dTwoOverRANDMAX = _mm256_set1_pd(2.0 / LCG_RAND_MAX);
+	const __m256d dOnes = _mm256_set1_pd(1.0);
+	const __m256d dZeros = _mm256_setzero_pd();
+	__m256i avxRand = _mm256_loadu_si256((const __m256i *) pLaneSeeds);
+	__m256i prevAvxRand = avxRand;
+	__m256i iMasks = _mm256_set1_epi32(-1);
+	int		dMasks = 0xff;			// The lanes still rejecting, for the counters only before the first round
+	__m256d avxdU[2], avxdV[2], avxdS[2], dTmp;
+
+	MISCRAND_COUNT(numBlocks, 1);
+	do
+	{
+		MISCRAND_COUNT(numRejectionRounds, 1);
+		MISCRAND_COUNT(numFrozenLanes, NUM_GAUSSIANRAND_LANES - MiscRandCountLanes(dMasks));
+
+		// Without AVX512 mask registers, iMasks holds 0xffffffff in the lanes which still need to be
+		//     updated and 0x00000000 in the lanes to be frozen at their prior values.
+		avxRand = _mm256_blendv_epi8(prevAvxRand, avxRand, iMasks);
+		prevAvxRand = avxRand;
+
+		// avxRand = avxRand * 214013L + 2531011L, and then (avxRand >> 16) & 0x7fff for u and v.
+		avxRand = _mm256_mullo_epi32(avxRand, l214013);
+		avxRand = _mm256_add_epi32(avxRand, l2531011);
+		__m256i     avxU = _mm256_and_si256(_mm256_srli_epi32(avxRand, 16), m32767);
+		avxRand = _mm256_mullo_epi32(avxRand, l214013);
+		avxRand = _mm256_add_epi32(avxRand, l2531011);
+		__m256i     avxV = _mm256_and_si256(_mm256_srli_epi32(avxRand, 16), m32767);
+
+		// u = 2.0*((double)rand() / RAND_MAX) - 1, v likewise, and s = u*u + v*v, in lanes 0-3 ([0])
+		//     and lanes 4-7 ([1]).
+		avxdU[0] = _mm256_cvtepi32_pd(_mm256_castsi256_si128(avxU));
+		avxdU[1] = _mm256_cvtepi32_pd(_mm256_extracti128_si256(avxU, 1));
+		avxdV[0] = _mm256_cvtepi32_pd(_mm256_castsi256_si128(avxV));
+		avxdV[1] = _mm256_cvtepi32_pd(_mm256_extracti128_si256(avxV, 1));
+		dMasks = 0;
+		for (int h = 0; h < 2; h++)
+		{
+			avxdU[h] = _mm256_sub_pd(_mm256_mul_pd(avxdU[h], dTwoOverRANDMAX), dOnes);
+			avxdV[h] = _mm256_sub_pd(_mm256_mul_pd(avxdV[h], dTwoOverRANDMAX), dOnes);
+			avxdS[h] = _mm256_add_pd(_mm256_mul_pd(avxdU[h], avxdU[h]), _mm256_mul_pd(avxdV[h], avxdV[h]));
+
+			// (s >= 1.0) || (s == 0.0) in four lanes, collected into bits 4*h to 4*h + 3 of dMasks.
+			dTmp = _mm256_or_pd(_mm256_cmp_pd(avxdS[h], dOnes, _CMP_GE_OQ), _mm256_cmp_pd(avxdS[h], dZeros, _CMP_EQ_OQ));
+			dMasks |= _mm256_movemask_pd(dTmp) << (4 * h);
+		}
+
+		// Spreading the eight bits of dMasks back to the eight 32-bit lanes of iMasks.
+		iMasks = _mm256_and_si256(_mm256_set1_epi32(dMasks), iLaneBits);
+		iMasks = _mm256_cmpeq_epi32(iMasks, iLaneBits);
+	} while (dMasks);
+
+	// u*sqrt(-2.0 * log(s)/s) and v*sqrt(-2.0 * log(s)/s), stored lanes reversed, v first, as in the AVX512
+	//     kernel: lanes 4h to 4h + 3 land 4 - 4h places from the start of their half.
+	for (int h = 0; h < 2; h++)
+	{
+		dTmp = PolarFactor256d(avxdS[h]);
+		_mm256_storeu_pd(pResults + 4 - 4 * h, _mm256_permute4x64_pd(_mm256_mul_pd(avxdV[h], dTmp), 0x1B));
+		_mm256_storeu_pd(pResults + NUM_GAUSSIANRAND_BLOCK/2 + 4 - 4 * h,
+			_mm256_permute4x64_pd(_mm256_mul_pd(avxdU[h], dTmp), 0x1B));
+	}
+	_mm256_storeu_si256((__m256i *) pLaneSeeds, avxRand);
+}
+
+// GaussianRandVecBlockSSE41() is the SSE4.1 kernel, the first instruction set with _mm_mullo_epi32()
+//     and _mm_blendv_epi8().  The eight 32-bit lanes take two __m128i ([0] for lanes 0-3, [1] for lanes
+//     4-7), and the floating-point part runs on four __m128d of two lanes each.
+void	GaussianRandVecBlockSSE41(unsigned int *pLaneSeeds, double *pResults)
+{
+	const __m128i l214013 = _mm_set1_epi32(214013L);
+	const __m128i l2531011 = _mm_set1_epi32(2531011L);
+	const __m128i m32767 = _mm_set1_epi32(0x7fff);
+	const __m128i iLaneBits[2] = { _mm_setr_epi32(1, 2, 4, 8), _mm_setr_epi32(16, 32, 64, 128) };
+	const __m128d dTwoOverRANDMAX = _mm_set1_pd(2.0 / LCG_RAND_MAX);
+	const __m128d dOnes = _mm_set1_pd(1.0);
+	const __m128d dZeros = _mm_setzero_pd();
+	__m128i sseRand[2], prevSseRand[2], iMasks[2];
+	int		dMasks = 0xff;			// The lanes still rejecting, for the counters only before the first round
+	__m128d sseU[4], sseV[4], sseS[4], dTmp;
+
+	for (int h = 0; h < 2; h++)
+	{
+		sseRand[h] = _mm_loadu_si128((const __m128i *) pLaneSeeds + h);
+		prevSseRand[h] = sseRand[h];
+		iMasks[h] = _mm_set1_epi32(-1);
+	}
+
+	MISCRAND_COUNT(numBlocks, 1);
+	do
+	{
+		MISCRAND_COUNT(numRejectionRounds, 1);
+		MISCRAND_COUNT(numFrozenLanes, NUM_GAUSSIANRAND_LANES - MiscRandCountLanes(dMasks));
+
+		dMasks = 0;
+		for (int h = 0; h < 2; h++)
+		{
+			// Freezing the accepted lanes, and then evaluating u and v as in the AVX2 kernel.
+			sseRand[h] = _mm_blendv_epi8(prevSseRand[h], sseRand[h], iMasks[h]);
+			prevSseRand[h] = sseRand[h];
+
+			sseRand[h] = _mm_add_epi32(_mm_mullo_epi32(sseRand[h], l214013), l2531011);
+			__m128i     sseIntU = _mm_and_si128(_mm_srli_epi32(sseRand[h], 16), m32767);
+			sseRand[h] = _mm_add_epi32(_mm_mullo_epi32(sseRand[h], l214013), l2531011);
+			__m128i     sseIntV = _mm_and_si128(_mm_srli_epi32(sseRand[h], 16), m32767);
+
+			// _mm_cvtepi32_pd() only converts the lower two 32-bit lanes, so the upper two are moved down
+			//     for the second conversion.
+			sseU[2 * h] = _mm_cvtepi32_pd(sseIntU);
+			sseU[2 * h + 1] = _mm_cvtepi32_pd(_mm_shuffle_epi32(sseIntU, _MM_SHUFFLE(3, 2, 3, 2)));
+			sseV[2 * h] = _mm_cvtepi32_pd(sseIntV);
+			sseV[2 * h + 1] = _mm_cvtepi32_pd(_mm_shuffle_epi32(sseIntV, _MM_SHUFFLE(3, 2, 3, 2)));
+		}
+
+		for (int q = 0; q < 4; q++)
+		{
+			sseU[q] = _mm_sub_pd(_mm_mul_pd(sseU[q], dTwoOverRANDMAX), dOnes);
+			sseV[q] = _mm_sub_pd(_mm_mul_pd(sseV[q], dTwoOverRANDMAX), dOnes);
+			sseS[q] = _mm_add_pd(_mm_mul_pd(sseU[q], sseU[q]), _mm_mul_pd(sseV[q], sseV[q]));
+
+			// (s >= 1.0) || (s == 0.0) in two lanes, collected into bits 2*q and 2*q + 1 of dMasks.
+			dTmp = _mm_or_pd(_mm_cmpge_pd(sseS[q], dOnes), _mm_cmpeq_pd(sseS[q], dZeros));
+			dMasks |= _mm_movemask_pd(dTmp) << (2 * q);
+		}
+
+		for (int h = 0; h < 2; h++)
+		{
+			iMasks[h] = _mm_and_si128(_mm_set1_epi32(dMasks), iLaneBits[h]);
+			iMasks[h] = _mm_cmpeq_epi32(iMasks[h], iLaneBits[h]);
+		}
+	} while (dMasks);
+
+	// u*sqrt(-2.0 * log(s)/s) and v*sqrt(-2.0 * log(s)/s), stored lanes reversed, v first, as in the AVX512
+	//     kernel: lanes 2q and 2q + 1 land 6 - 2q places from the start of their half.
+	for (int q = 0; q < 4; q++)
+	{
+		__m128d	sseV2, sseU2;
+
+		dTmp = PolarFactor128d(sseS[q]);
+		sseV2 = _mm_mul_pd(sseV[q], dTmp);
+		sseU2 = _mm_mul_pd(sseU[q], dTmp);
+		_mm_storeu_pd(pResults + 6 - 2 * q, _mm_shuffle_pd(sseV2, sseV2, 1));
+		_mm_storeu_pd(pResults + NUM_GAUSSIANRAND_BLOCK/2 + 6 - 2 * q, _mm_shuffle_pd(sseU2, sseU2, 1));
+	}
+	for (int h = 0; h < 2; h++)
+		_mm_storeu_si128((__m128i *) pLaneSeeds + h, sseRand[h]);
+}
+
+// GaussianRandVecBlockScalar() is the plain C kernel for CPUs without SSE4.1.  Freezing a lane in the
+//     SIMD kernels is the same as running each lane on its own until it accepts a pair, which is what we
+//     do here lane by lane.  For the counters, the rounds are those of the longest lane, and each lane is
+//     frozen for the rounds it is shorter by.
+void	GaussianRandVecBlockScalar(unsigned int *pLaneSeeds, double *pResults)
+{
+	int		numTries[NUM_GAUSSIANRAND_LANES], maxTries = 0;
+
+	for (int lane = 0; lane < NUM_GAUSSIANRAND_LANES; lane++)
+	{
+		unsigned int	uSeed = pLaneSeeds[lane];
+		double			u, v, s;
+
+		numTries[lane] = 0;
+		do {
+			numTries[lane]++;
+			uSeed = uSeed * 214013L + 2531011L;
+			u = ((uSeed >> 16) & 0x7fff) * (2.0 / LCG_RAND_MAX) - 1.0;
+			uSeed = uSeed * 214013L + 2531011L;
+			v = ((uSeed >> 16) & 0x7fff) * (2.0 / LCG_RAND_MAX) - 1.0;
+
+			s = u*u + v*v;
+		} while ((s >= 1.0) || (s == 0.0));
+
+		s = sqrt(-2.0 * log(s)/s);
+		pResults[NUM_GAUSSIANRAND_LANES - 1 - lane] = v * s;
+		pResults[NUM_GAUSSIANRAND_BLOCK - 1 - lane] = u * s;
+		pLaneSeeds[lane] = uSeed;
+		maxTries = (numTries[lane] > maxTries) ? numTries[lane] : maxTries;
+	}
+
+	MISCRAND_COUNT(numBlocks, 1);
+	MISCRAND_COUNT(numRejectionRounds, maxTries);
+	for (int lane = 0; lane < NUM_GAUSSIANRAND_LANES; lane++)
+		MISCRAND_COUNT(numFrozenLanes, maxTries - numTries[lane]);
+}
+
+// GaussianRandVecFloatBlockAVX512() is the AVX512 kernel of GaussianRandVecFloat().  It is the double
+//     kernel above with all sixteen 32-bit lanes of a __m512i and a __m512 in use.  u and v are formed
+//     with a multiplication and a subtraction rather than _mm512_fmsub_ps(), so that all the float kernels
+//     round them, and hence accept or reject them, the same way.
+void	GaussianRandVecFloatBlockAVX512(unsigned int *pLaneSeeds, float *pResults)
+{
+	const __m512i l214013 = _mm512_set1_epi32(214013L);
+	const __m512i l2531011 = _mm512_set1_epi32(2531011L);
+	const __m512i m32767 = _mm512_set1_epi32(0x7fff);
+	const __m512 fTwoOverRANDMAX = _mm512_set1_ps(2.0f / LCG_RAND_MAX);
+	const __m512 fOnes = _mm512_set1_ps(1.0f);
+	const __m512 fZeros = _mm512_setzero_ps();
+	__m512i avxRand = _mm512_loadu_si512(pLaneSeeds);
+	__m512i prevAvxRand = avxRand;
+	__mmask16 fMasks = 0xffff;
+	__m512 avxfU, avxfV, avxfS, fTmp;
+
+	do
+	{
+		// Freezing the lanes which already have an accepted pair, as in the double kernel.
+		avxRand = _mm512_mask_blend_epi32(fMasks, prevAvxRand, avxRand);
+		prevAvxRand = avxRand;
+
+		avxRand = _mm512_add_epi32(_mm512_mullo_epi32(avxRand, l214013), l2531011);
+		__m512i     avxU = _mm512_and_si512(_mm512_srli_epi32(avxRand, 16), m32767);
+		avxRand = _mm512_add_epi32(_mm512_mullo_epi32(avxRand, l214013), l2531011);
+		__m512i     avxV = _mm512_and_si512(_mm512_srli_epi32(avxRand, 16), m32767);
+
+		avxfU = _mm512_sub_ps(_mm512_mul_ps(_mm512_cvtepi32_ps(avxU), fTwoOverRANDMAX), fOnes);
+		avxfV = _mm512_sub_ps(_mm512_mul_ps(_mm512_cvtepi32_ps(avxV), fTwoOverRANDMAX), fOnes);
+		avxfS = _mm512_add_ps(_mm512_mul_ps(avxfU, avxfU), _mm512_mul_ps(avxfV, avxfV));
+
+		fMasks = _mm512_cmp_ps_mask(avxfS, fOnes, _CMP_GE_OQ) | _mm512_cmp_ps_mask(avxfS, fZeros, _CMP_EQ_OQ);
+	} while (fMasks);
+
+	// u*sqrt(-2.0 * log(s)/s) and v*sqrt(-2.0 * log(s)/s).
+	fTmp = PolarFactor512f(avxfS);
+
+	_mm512_storeu_ps(pResults, _mm512_mul_ps(avxfU, fTmp));
+	_mm512_storeu_ps(pResults + NUM_GAUSSIANRANDFLOAT_GENERATED/2, _mm512_mul_ps(avxfV, fTmp));
+	_mm512_storeu_si512(pLaneSeeds, avxRand);
+}
+
+// GaussianRandVecFloatBlockAVX2() is the AVX2 kernel of GaussianRandVecFloat().  Eight float lanes fit in
+//     an __m256, so the sixteen lanes take two of everything: [0] for lanes 0-7 and [1] for lanes 8-15.
+void	GaussianRandVecFloatBlockAVX2(unsigned int *pLaneSeeds, float *pResults)
+{
+	const __m256i l214013 = _mm256_set1_epi32(214013L);
+	const __m256i l2531011 = _mm256_set1_epi32(2531011L);
+	const __m256i m32767 = _mm256_set1_epi32(0x7fff);
+	const __m256i iLaneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	const __m256 fTwoOverRANDMAX = _mm256_set1_ps(2.0f / LCG_RAND_MAX);
+	const __m256 fOnes = _mm256_set1_ps(1.0f);
+	const __m256 fZeros = _mm256_setzero_ps();
+	__m256i avxRand[2], prevAvxRand[2], iMasks[2];
+	int		fMasks;
+	__m256 avxfU[2], avxfV[2], avxfS[2], fTmp;
+
+	for (int h = 0; h < 2; h++)
+	{
+		avxRand[h] = _mm256_loadu_si256((const __m256i *) pLaneSeeds + h);
+		prevAvxRand[h] = avxRand[h];
+		iMasks[h] = _mm256_set1_epi32(-1);
+	}
+
+	do
+	{
+		fMasks = 0;
+		for (int h = 0; h < 2; h++)
+		{
+			avxRand[h] = _mm256_blendv_epi8(prevAvxRand[h], avxRand[h], iMasks[h]);
+			prevAvxRand[h] = avxRand[h];
+
+			avxRand[h] = _mm256_add_epi32(_mm256_mullo_epi32(avxRand[h], l214013), l2531011);
+			__m256i     avxU = _mm256_and_si256(_mm256_srli_epi32(avxRand[h], 16), m32767);
+			avxRand[h] = _mm256_add_epi32(_mm256_mullo_epi32(avxRand[h], l214013), l2531011);
+			__m256i     avxV = _mm256_and_si256(_mm256_srli_epi32(avxRand[h], 16), m32767);
+
+			avxfU[h] = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(avxU), fTwoOverRANDMAX), fOnes);
+			avxfV[h] = _mm256_sub_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(avxV), fTwoOverRANDMAX), fOnes);
+			avxfS[h] = _mm256_add_ps(_mm256_mul_ps(avxfU[h], avxfU[h]), _mm256_mul_ps(avxfV[h], avxfV[h]));
+
+			// (s >= 1.0) || (s == 0.0) in eight lanes, spread back to the 32-bit lanes of iMasks[h].
+			fTmp = _mm256_or_ps(_mm256_cmp_ps(avxfS[h], fOnes, _CMP_GE_OQ), _mm256_cmp_ps(avxfS[h], fZeros, _CMP_EQ_OQ));
+			int		hMasks = _mm256_movemask_ps(fTmp);
+			iMasks[h] = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(hMasks), iLaneBits), iLaneBits);
+			fMasks |= hMasks;
+		}
+	} while (fMasks);
+
+	// u*sqrt(-2.0 * log(s)/s) and v*sqrt(-2.0 * log(s)/s).
+	for (int h = 0; h < 2; h++)
+	{
+		fTmp = PolarFactor256f(avxfS[h]);
+		_mm256_storeu_ps(pResults + 8 * h, _mm256_mul_ps(avxfU[h], fTmp));
+		_mm256_storeu_ps(pResults + NUM_GAUSSIANRANDFLOAT_GENERATED/2 + 8 * h, _mm256_mul_ps(avxfV[h], fTmp));
+		_mm256_storeu_si256((__m256i *) pLaneSeeds + h, avxRand[h]);
+	}
+}
+
+// GaussianRandVecFloatBlockSSE41() is the SSE4.1 kernel of GaussianRandVecFloat(), with the sixteen lanes
+//     in four __m128i and four __m128 of four lanes each.
+void	GaussianRandVecFloatBlockSSE41(unsigned int *pLaneSeeds, float *pResults)
+{
+	const __m128i l214013 = _mm_set1_epi32(214013L);
+	const __m128i l2531011 = _mm_set1_epi32(2531011L);
+	const __m128i m32767 = _mm_set1_epi32(0x7fff);
+	const __m128i iLaneBits = _mm_setr_epi32(1, 2, 4, 8);
+	const __m128 fTwoOverRANDMAX = _mm_set1_ps(2.0f / LCG_RAND_MAX);
+	const __m128 fOnes = _mm_set1_ps(1.0f);
+	const __m128 fZeros = _mm_setzero_ps();
+	__m128i sseRand[4], prevSseRand[4], iMasks[4];
+	int		fMasks;
+	__m128 sseU[4], sseV[4], sseS[4], fTmp;
+
+	for (int q = 0; q < 4; q++)
+	{
+		sseRand[q] = _mm_loadu_si128((const __m128i *) pLaneSeeds + q);
+		prevSseRand[q] = sseRand[q];
+		iMasks[q] = _mm_set1_epi32(-1);
+	}
+
+	do
+	{
+		fMasks = 0;
+		for (int q = 0; q < 4; q++)
+		{
+			sseRand[q] = _mm_blendv_epi8(prevSseRand[q], sseRand[q], iMasks[q]);
+			prevSseRand[q] = sseRand[q];
+
+			sseRand[q] = _mm_add_epi32(_mm_mullo_epi32(sseRand[q], l214013), l2531011);
+			__m128i     sseIntU = _mm_and_si128(_mm_srli_epi32(sseRand[q], 16), m32767);
+			sseRand[q] = _mm_add_epi32(_mm_mullo_epi32(sseRand[q], l214013), l2531011);
+			__m128i     sseIntV = _mm_and_si128(_mm_srli_epi32(sseRand[q], 16), m32767);
+
+			sseU[q] = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(sseIntU), fTwoOverRANDMAX), fOnes);
+			sseV[q] = _mm_sub_ps(_mm_mul_ps(_mm_cvtepi32_ps(sseIntV), fTwoOverRANDMAX), fOnes);
+			sseS[q] = _mm_add_ps(_mm_mul_ps(sseU[q], sseU[q]), _mm_mul_ps(sseV[q], sseV[q]));
+
+			fTmp = _mm_or_ps(_mm_cmpge_ps(sseS[q], fOnes), _mm_cmpeq_ps(sseS[q], fZeros));
+			int		qMasks = _mm_movemask_ps(fTmp);
+			iMasks[q] = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(qMasks), iLaneBits), iLaneBits);
+			fMasks |= qMasks;
+		}
+	} while (fMasks);
+
+	// u*sqrt(-2.0 * log(s)/s) and v*sqrt(-2.0 * log(s)/s).
+	for (int q = 0; q < 4; q++)
+	{
+		fTmp = PolarFactor128f(sseS[q]);
+		_mm_storeu_ps(pResults + 4 * q, _mm_mul_ps(sseU[q], fTmp));
+		_mm_storeu_ps(pResults + NUM_GAUSSIANRANDFLOAT_GENERATED/2 + 4 * q, _mm_mul_ps(sseV[q], fTmp));
+		_mm_storeu_si128((__m128i *) pLaneSeeds + q, sseRand[q]);
+	}
+}
+
+// GaussianRandVecFloatBlockScalar() is the plain C kernel of GaussianRandVecFloat().  It keeps u, v and s
+//     in float and evaluates them step by step as the SIMD kernels do.
+void	GaussianRandVecFloatBlockScalar(unsigned int *pLaneSeeds, float *pResults)
+{
+	for (int lane = 0; lane < NUM_GAUSSIANRANDFLOAT_LANES; lane++)
+	{
+		unsigned int	uSeed = pLaneSeeds[lane];
+		float			u, v, uu, vv, s;
+
+		do {
+			uSeed = uSeed * 214013L + 2531011L;
+			u = (float) ((uSeed >> 16) & 0x7fff) * (2.0f / LCG_RAND_MAX) - 1.0f;
+			uSeed = uSeed * 214013L + 2531011L;
+			v = (float) ((uSeed >> 16) & 0x7fff) * (2.0f / LCG_RAND_MAX) - 1.0f;
+
+			uu = u*u;
+			vv = v*v;
+			s = uu + vv;
+		} while ((s >= 1.0f) || (s == 0.0f));
+
+		s = sqrtf(logf(s)/s * -2.0f);
+		pResults[lane] = u * s;
+		pResults[NUM_GAUSSIANRANDFLOAT_GENERATED/2 + lane] = v * s;
+		pLaneSeeds[lane] = uSeed;
+	}
+}
+
+// GaussianRandVecCompactBlocksAVX512() is the AVX512 compacting kernel.  Instead of freezing the accepted
+//     lanes, every iteration draws a fresh (u, v) pair in all eight lanes, compresses the accepted ones to
+//     the bottom and appends them to the pairs staged so far, so no lane ever idles.  The staged pairs
+//     stay in registers; going through memory at a different offset each round costs a failed store
+//     forward per load.  The transform runs whenever eight staged pairs are ready, all of them accepted.
+void	GaussianRandVecCompactBlocksAVX512(unsigned int *pLaneSeeds, double (*pStaged)[NUM_STAGED_PAIRS],
+	int *pNumStaged, double *pResults, size_t numBlocks)
+{
+	const __m256i l214013 = _mm256_set1_epi32(214013L);
+	const __m256i l2531011 = _mm256_set1_epi32(2531011L);
+	const __m256i m32767 = _mm256_set1_epi32(0x7fff);
+	const __m512i iLanes = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m512i iEights = _mm512_set1_epi64(NUM_GAUSSIANRAND_LANES);
+	const __m512d dTwoOverRANDMAX = _mm512_set1_pd(2.0 / LCG_RAND_MAX);
+	const __m512d dOnes = _mm512_set1_pd(1.0);
+	const __m512d dZeros = _mm512_setzero_pd();
+	__m256i avxRand = _mm256_loadu_si256((const __m256i *) pLaneSeeds);
+	__m512d stagedU = _mm512_loadu_pd(pStaged[0]);
+	__m512d stagedV = _mm512_loadu_pd(pStaged[1]);
+	__m512d stagedS = _mm512_loadu_pd(pStaged[2]);
+	int		numStaged = *pNumStaged;
+	size_t	block = 0;
+
+	while (block < numBlocks)
+	{
+		avxRand = _mm256_add_epi32(_mm256_mullo_epi32(avxRand, l214013), l2531011);
+		__m256i     avxU = _mm256_and_si256(_mm256_srli_epi32(avxRand, 16), m32767);
+		avxRand = _mm256_add_epi32(_mm256_mullo_epi32(avxRand, l214013), l2531011);
+		__m256i     avxV = _mm256_and_si256(_mm256_srli_epi32(avxRand, 16), m32767);
+
+		__m512d     avxdU = _mm512_sub_pd(_mm512_mul_pd(_mm512_cvtepi32_pd(avxU), dTwoOverRANDMAX), dOnes);
+		__m512d     avxdV = _mm512_sub_pd(_mm512_mul_pd(_mm512_cvtepi32_pd(avxV), dTwoOverRANDMAX), dOnes);
+		__m512d     avxdS = _mm512_add_pd(_mm512_mul_pd(avxdU, avxdU), _mm512_mul_pd(avxdV, avxdV));
+
+		// The accepted lanes, 0 < s < 1, packed in lane order.
+		__mmask8	dAccepted = _mm512_cmp_pd_mask(avxdS, dOnes, _CMP_LT_OQ) & _mm512_cmp_pd_mask(avxdS, dZeros, _CMP_NEQ_OQ);
+		int			numAccepted = _mm_popcnt_u32(dAccepted);
+		avxdU = _mm512_maskz_compress_pd(dAccepted, avxdU);
+		avxdV = _mm512_maskz_compress_pd(dAccepted, avxdV);
+		avxdS = _mm512_maskz_compress_pd(dAccepted, avxdS);
+
+		// Lane i of the staged pairs keeps staged lane i below numStaged and takes accepted lane
+		//     i - numStaged from there on, which _mm512_permutex2var_pd() reads as index 8 + i - numStaged.
+		__m512i		iStaged = _mm512_set1_epi64(numStaged);
+		__m512i		iMerge = _mm512_mask_blend_epi64(_mm512_cmplt_epi64_mask(iLanes, iStaged),
+						_mm512_add_epi64(_mm512_sub_epi64(iLanes, iStaged), iEights), iLanes);
+		stagedU = _mm512_permutex2var_pd(stagedU, iMerge, avxdU);
+		stagedV = _mm512_permutex2var_pd(stagedV, iMerge, avxdV);
+		stagedS = _mm512_permutex2var_pd(stagedS, iMerge, avxdS);
+
+		if (numStaged + numAccepted < NUM_GAUSSIANRAND_LANES)
+		{
+			numStaged += numAccepted;
+			continue;
+		}
+
+		// u*sqrt(-2.0 * log(s)/s) and v*sqrt(-2.0 * log(s)/s) on the eight staged pairs.
+		__m512d	dTmp = PolarFactor512d(stagedS);
+		_mm512_storeu_pd(pResults, _mm512_mul_pd(stagedU, dTmp));
+		_mm512_storeu_pd(pResults + NUM_GAUSSIANRAND_BLOCK/2, _mm512_mul_pd(stagedV, dTmp));
+		pResults += NUM_GAUSSIANRAND_BLOCK;
+		block++;
+
+		// The accepted pairs which did not fit, from lane 8 - numStaged on, become the staged ones.
+		__m512i		iLeftOver = _mm512_add_epi64(iLanes, _mm512_sub_epi64(iEights, iStaged));
+		stagedU = _mm512_permutexvar_pd(iLeftOver, avxdU);
+		stagedV = _mm512_permutexvar_pd(iLeftOver, avxdV);
+		stagedS = _mm512_permutexvar_pd(iLeftOver, avxdS);
+		numStaged += numAccepted - NUM_GAUSSIANRAND_LANES;
+	}
+
+	_mm256_storeu_si256((__m256i *) pLaneSeeds, avxRand);
+	_mm512_storeu_pd(pStaged[0], stagedU);
+	_mm512_storeu_pd(pStaged[1], stagedV);
+	_mm512_storeu_pd(pStaged[2], stagedS);
+	*pNumStaged = numStaged;
+}
+
+// compactPermutes[m] moves the doubles of an __m256d whose bits are set in m to the front, in order, as
+//     _mm256_permutevar8x32_ps() indices; AVX2 has no compress-store.
+alignas(32) static const int	compactPermutes[16][8] =
+{
+	{ 0, 1, 0, 1, 0, 1, 0, 1 }, { 0, 1, 0, 1, 0, 1, 0, 1 }, { 2, 3, 0, 1, 0, 1, 0, 1 }, { 0, 1, 2, 3, 0, 1, 0, 1 },
+	{ 4, 5, 0, 1, 0, 1, 0, 1 }, { 0, 1, 4, 5, 0, 1, 0, 1 }, { 2, 3, 4, 5, 0, 1, 0, 1 }, { 0, 1, 2, 3, 4, 5, 0, 1 },
+	{ 6, 7, 0, 1, 0, 1, 0, 1 }, { 0, 1, 6, 7, 0, 1, 0, 1 }, { 2, 3, 6, 7, 0, 1, 0, 1 }, { 0, 1, 2, 3, 6, 7, 0, 1 },
+	{ 4, 5, 6, 7, 0, 1, 0, 1 }, { 0, 1, 4, 5, 6, 7, 0, 1 }, { 2, 3, 4, 5, 6, 7, 0, 1 }, { 0, 1, 2, 3, 4, 5, 6, 7 }
+};
+
+// GaussianRandVecCompactBlocksAVX2() is the AVX2 compacting kernel.  Each __m256d half of the eight lanes is
+//     packed through compactPermutes[] and stored whole behind the staged pairs; only the accepted ones
+//     count, and the rest is overwritten later.
+void	GaussianRandVecCompactBlocksAVX2(unsigned int *pLaneSeeds, double (*pStaged)[NUM_STAGED_PAIRS],
+	int *pNumStaged, double *pResults, size_t numBlocks)
+{
+	const __m256i l214013 = _mm256_set1_epi32(214013L);
+	const __m256i l2531011 = _mm256_set1_epi32(2531011L);
+	const __m256i m32767 = _mm256_set1_epi32(0x7fff);
+	const __m256d dTwoOverRANDMAX = _mm256_set1_pd(2.0 / LCG_RAND_MAX);
+	const __m256d dOnes = _mm256_set1_pd(1.0);
+	const __m256d dZeros = _mm256_setzero_pd();
+	__m256i avxRand = _mm256_loadu_si256((const __m256i *) pLaneSeeds);
+	int		numStaged = *pNumStaged;
+
+	for (size_t block = 0; block < numBlocks; block++)
+	{
+		while (numStaged < NUM_GAUSSIANRAND_LANES)
+		{
+			avxRand = _mm256_add_epi32(_mm256_mullo_epi32(avxRand, l214013), l2531011);
+			__m256i     avxU = _mm256_and_si256(_mm256_srli_epi32(avxRand, 16), m32767);
+			avxRand = _mm256_add_epi32(_mm256_mullo_epi32(avxRand, l214013), l2531011);
+			__m256i     avxV = _mm256_and_si256(_mm256_srli_epi32(avxRand, 16), m32767);
+
+			for (int h = 0; h < 2; h++)
+			{
+				__m256d     avxdU = _mm256_cvtepi32_pd(h ? _mm256_extracti128_si256(avxU, 1) : _mm256_castsi256_si128(avxU));
+				__m256d     avxdV = _mm256_cvtepi32_pd(h ? _mm256_extracti128_si256(avxV, 1) : _mm256_castsi256_si128(avxV));
+				avxdU = _mm256_sub_pd(_mm256_mul_pd(avxdU, dTwoOverRANDMAX), dOnes);
+				avxdV = _mm256_sub_pd(_mm256_mul_pd(avxdV, dTwoOverRANDMAX), dOnes);
+				__m256d     avxdS = _mm256_add_pd(_mm256_mul_pd(avxdU, avxdU), _mm256_mul_pd(avxdV, avxdV));
+
+				int         iAccepted = _mm256_movemask_pd(_mm256_and_pd(_mm256_cmp_pd(avxdS, dOnes, _CMP_LT_OQ),
+				                                                         _mm256_cmp_pd(avxdS, dZeros, _CMP_NEQ_OQ)));
+				__m256i     iPermute = _mm256_load_si256((const __m256i *) compactPermutes[iAccepted]);
+				_mm256_storeu_pd(pStaged[0] + numStaged, _mm256_castps_pd(_mm256_permutevar8x32_ps(_mm256_castpd_ps(avxdU), iPermute)));
+				_mm256_storeu_pd(pStaged[1] + numStaged, _mm256_castps_pd(_mm256_permutevar8x32_ps(_mm256_castpd_ps(avxdV), iPermute)));
+				_mm256_storeu_pd(pStaged[2] + numStaged, _mm256_castps_pd(_mm256_permutevar8x32_ps(_mm256_castpd_ps(avxdS), iPermute)));
+				numStaged += _mm_popcnt_u32(iAccepted);
+			}
+		}
+
+		// u*sqrt(-2.0 * log(s)/s) and v*sqrt(-2.0 * log(s)/s) on the first eight staged pairs.
+		for (int h = 0; h < 2; h++)
+		{
+			__m256d	dTmp = PolarFactor256d(_mm256_loadu_pd(pStaged[2] + 4 * h));
+			_mm256_storeu_pd(pResults + 4 * h, _mm256_mul_pd(_mm256_loadu_pd(pStaged[0] + 4 * h), dTmp));
+			_mm256_storeu_pd(pResults + NUM_GAUSSIANRAND_BLOCK/2 + 4 * h, _mm256_mul_pd(_mm256_loadu_pd(pStaged[1] + 4 * h), dTmp));
+		}
+		pResults += NUM_GAUSSIANRAND_BLOCK;
+
+		for (int c = 0; c < 3; c++)
+		{
+			__m256d	dLow = _mm256_loadu_pd(pStaged[c] + NUM_GAUSSIANRAND_LANES);
+			__m256d	dHigh = _mm256_loadu_pd(pStaged[c] + NUM_GAUSSIANRAND_LANES + 4);
+			_mm256_storeu_pd(pStaged[c], dLow);
+			_mm256_storeu_pd(pStaged[c] + 4, dHigh);
+		}
+		numStaged -= NUM_GAUSSIANRAND_LANES;
+	}
+
+	_mm256_storeu_si256((__m256i *) pLaneSeeds, avxRand);
+	*pNumStaged = numStaged;
+}
+
+// GaussianRandVecCompactBlocksScalar() is the plain C compacting kernel.  It draws from the lanes round by
+//     round, lanes 0 to 7 in turn, and stages the accepted pairs in that order, which is the order the
+//     SIMD kernels pack them in.
+void	GaussianRandVecCompactBlocksScalar(unsigned int *pLaneSeeds, double (*pStaged)[NUM_STAGED_PAIRS],
+	int *pNumStaged, double *pResults, size_t numBlocks)
+{
+	int		numStaged = *pNumStaged;
+
+	for (size_t block = 0; block < numBlocks; block++)
+	{
+		while (numStaged < NUM_GAUSSIANRAND_LANES)
+		{
+			for (int lane = 0; lane < NUM_GAUSSIANRAND_LANES; lane++)
+			{
+				unsigned int	uSeed = pLaneSeeds[lane];
+				double			u, v, s;
+
+				uSeed = uSeed * 214013L + 2531011L;
+				u = ((uSeed >> 16) & 0x7fff) * (2.0 / LCG_RAND_MAX) - 1.0;
+				uSeed = uSeed * 214013L + 2531011L;
+				v = ((uSeed >> 16) & 0x7fff) * (2.0 / LCG_RAND_MAX) - 1.0;
+				pLaneSeeds[lane] = uSeed;
+
+				s = u*u + v*v;
+				if ((s < 1.0) && (s != 0.0))
+				{
+					pStaged[0][numStaged] = u;
+					pStaged[1][numStaged] = v;
+					pStaged[2][numStaged] = s;
+					numStaged++;
+				}
+			}
+		}
+
+		for (int lane = 0; lane < NUM_GAUSSIANRAND_LANES; lane++)
+		{
+			double	s = sqrt(-2.0 * log(pStaged[2][lane])/pStaged[2][lane]);
+
+			pResults[lane] = pStaged[0][lane] * s;
+			pResults[NUM_GAUSSIANRAND_BLOCK/2 + lane] = pStaged[1][lane] * s;
+		}
+		pResults += NUM_GAUSSIANRAND_BLOCK;
+
+		numStaged -= NUM_GAUSSIANRAND_LANES;
+		for (int c = 0; c < 3; c++)
+			for (int i = 0; i < numStaged; i++)
+				pStaged[c][i] = pStaged[c][NUM_GAUSSIANRAND_LANES + i];
+	}
+
+	*pNumStaged = numStaged;
+}
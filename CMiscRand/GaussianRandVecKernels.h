@@ -0,0 +1,49 @@
+#pragma once
+// GaussianRandVecKernels.h declares the GaussianRandVec() kernels, one per instruction set.  They are
+// internal to the library; GaussianRand.cpp binds the fastest one the CPU supports.
+//
+// Every kernel advances the NUM_GAUSSIANRAND_LANES lanes in pLaneSeeds[] until each lane has an
+// accepted (u, v) pair, and stores the NUM_GAUSSIANRAND_BLOCK resulting Gaussian random numbers to
+// pResults in the order GaussianRandVec() serves them, which is the order it has always served them in:
+// the v-based ones of lanes 7 down to 0 first, then the u-based ones of lanes 7 down to 0.  All the
+// kernels draw the same uniform numbers from the same lane seeds, so they return the same sequence up to
+// floating-point rounding.  pResults does not need to be aligned.
+
+// The largest number the rand() the lanes copy returns, RAND_MAX of MSVC.  Other C libraries have other
+//     RAND_MAX values (glibc's is 2^31 - 1), so the kernels do not use RAND_MAX.
+#define LCG_RAND_MAX	0x7fff
+
+typedef void (*GaussianRandVecBlock_t)(unsigned int *pLaneSeeds, double *pResults);
+
+void	GaussianRandVecBlockAVX512(unsigned int *pLaneSeeds, double *pResults);
+void	GaussianRandVecBlockAVX2(unsigned int *pLaneSeeds, double *pResults);
+void	GaussianRandVecBlockSSE41(unsigned int *pLaneSeeds, double *pResults);
+void	GaussianRandVecBlockScalar(unsigned int *pLaneSeeds, double *pResults);
+
+// The GaussianRandVecFloat() kernels do the same with NUM_GAUSSIANRANDFLOAT_LANES lanes in float, storing
+// the NUM_GAUSSIANRANDFLOAT_GENERATED results as the u-based ones of lanes 0-15 followed by the v-based
+// ones.
+
+typedef void (*GaussianRandVecFloatBlock_t)(unsigned int *pLaneSeeds, float *pResults);
+
+void	GaussianRandVecFloatBlockAVX512(unsigned int *pLaneSeeds, float *pResults);
+void	GaussianRandVecFloatBlockAVX2(unsigned int *pLaneSeeds, float *pResults);
+void	GaussianRandVecFloatBlockSSE41(unsigned int *pLaneSeeds, float *pResults);
+void	GaussianRandVecFloatBlockScalar(unsigned int *pLaneSeeds, float *pResults);
+
+// The compacting kernels behind GaussianRandVecCompact() share the lanes with the kernels above but never
+// freeze them: each round draws a new (u, v) pair in every lane and stages the accepted ones, with their
+// s, in pStaged[0][], pStaged[1][] and pStaged[2][] behind the *pNumStaged pairs staged before.  Every
+// eight staged pairs make a block of NUM_GAUSSIANRAND_BLOCK results, the u-based ones of the eight pairs
+// first, then the v-based ones.  numBlocks blocks go to pResults, and the fewer than eight pairs left over
+// stay staged for the next call, so the sequence does not depend on how it is split between calls.
+
+typedef void (*GaussianRandVecCompactBlocks_t)(unsigned int *pLaneSeeds, double (*pStaged)[NUM_STAGED_PAIRS],
+	int *pNumStaged, double *pResults, size_t numBlocks);
+
+void	GaussianRandVecCompactBlocksAVX512(unsigned int *pLaneSeeds, double (*pStaged)[NUM_STAGED_PAIRS],
+	int *pNumStaged, double *pResults, size_t numBlocks);
+void	GaussianRandVecCompactBlocksAVX2(unsigned int *pLaneSeeds, double (*pStaged)[NUM_STAGED_PAIRS],
+	int *pNumStaged, double *pResults, size_t numBlocks);
+void	GaussianRandVecCompactBlocksScalar(unsigned int *pLaneSeeds, double (*pStaged)[NUM_STAGED_PAIRS],
+	int *pNumStaged, double *pResults, size_t numBlocks);
@@ -0,0 +1,493 @@
+// GaussianZiggurat.cpp implements the Ziggurat method of Marsaglia and Tsang ("The Ziggurat Method for
+// Generating Random Variables", Journal of Statistical Software, 2000) to generate zero-mean, unit-variance
+// Gaussian-distributed random variables.  The normal density is covered by 128 layers of equal area; a
+// draw picks a layer and a point in it, and about 98.8% of the draws land in the rectangular part of their
+// layer and are accepted with one table lookup and one comparison.  Only the remaining draws take the slow
+// path, which needs exp() or log().
+//
+// The uniform 32-bit random numbers come from the same eight lanes of rand()-style linear congruential
+// generators GaussianRandVec() uses.  Since the low bits of such a generator have short periods, we cannot
+// pick the layer from the lowest seven bits as Marsaglia did; and any other bits of the number that places
+// the point would tie the point to its layer, putting the points of each layer on a comb.  So an LCG draw
+// takes two steps of its lane: the point from the first and the layer from the upper seven bits of the second.
+
+#include <math.h>
+#include <immintrin.h>
+#include "MiscRand.h"
+#include "cpudetect.h"
+
+#define NUM_ZIGGURAT_LAYERS		128
+#define ZIGGURAT_R				3.442619855899			// Start of the right tail
+#define ZIGGURAT_V				9.91256303526217e-3		// Area of each layer
+#define ZIGGURAT_LAYER_SHIFT	25						// iz = the upper seven bits of an LCG step
+
+// knTable[i] and wnTable[i] turn a signed 32-bit random number hz into a point x = hz * wnTable[i] in
+//     layer i, which is in the rectangular part of the layer iff |hz| < knTable[i].  fnTable[i] is the
+//     density at the upper edge of layer i.  knTable[] is kept in doubles so that the SIMD kernels can
+//     gather and compare it without integer conversions.
+alignas(64) static double	knTable[NUM_ZIGGURAT_LAYERS];
+alignas(64) static double	wnTable[NUM_ZIGGURAT_LAYERS];
+alignas(64) static double	fnTable[NUM_ZIGGURAT_LAYERS];
+
+// ZigguratSetTables() fills knTable[], wnTable[] and fnTable[] following zigset() of Marsaglia and Tsang.
+static void	ZigguratSetTables()
+{
+	const double	m1 = 2147483648.0;
+	double			dn = ZIGGURAT_R, tn = dn;
+	double			q = ZIGGURAT_V / exp(-0.5 * dn * dn);
+
+	knTable[0] = (dn / q) * m1;
+	knTable[1] = 0.0;
+	wnTable[0] = q / m1;
+	wnTable[NUM_ZIGGURAT_LAYERS - 1] = dn / m1;
+	fnTable[0] = 1.0;
+	fnTable[NUM_ZIGGURAT_LAYERS - 1] = exp(-0.5 * dn * dn);
+
+	for (int i = NUM_ZIGGURAT_LAYERS - 2; i >= 1; i--)
+	{
+		dn = sqrt(-2.0 * log(ZIGGURAT_V / dn + exp(-0.5 * dn * dn)));
+		knTable[i + 1] = floor((dn / tn) * m1);
+		tn = dn;
+		fnTable[i] = exp(-0.5 * dn * dn);
+		wnTable[i] = dn / m1;
+	}
+	knTable[0] = floor(knTable[0]);
+}
+
+// ZigguratSource is where the slow path draws its further random numbers from: either the LCG lane with
+//     seed *pSeed, or the engine *pEngine when pSeed is NULL.
+typedef struct ZigguratSource
+{
+	unsigned int	*pSeed;
+	MiscRandEngine	*pEngine;
+} ZigguratSource;
+
+// ZigguratNext() advances the lane seed *pSeed once and returns it as the next 32-bit random number.
+static inline unsigned int	ZigguratNext(unsigned int *pSeed)
+{
+	return (*pSeed = *pSeed * 214013L + 2531011L);
+}
+
+// ZigguratDraw() draws the next hz and its layer iz from *pSource.  An LCG lane gives hz = its next 32-bit
+//     random number and iz = the upper seven bits of the one after.  An engine gives hz = the upper half of
+//     its next 64-bit random number and iz = the lowest seven bits, which are as good as any in a 64-bit engine.
+static inline void	ZigguratDraw(ZigguratSource *pSource, int *pHz, int *pIz)
+{
+	if (pSource->pSeed != NULL)
+	{
+		*pHz = (int) ZigguratNext(pSource->pSeed);
+		*pIz = (int) (ZigguratNext(pSource->pSeed) >> ZIGGURAT_LAYER_SHIFT);
+	}
+	else
+	{
+		unsigned long long	r = RandEngineNext64(pSource->pEngine);
+
+		*pHz = (int) (r >> 32);
+		*pIz = (int) (r & (NUM_ZIGGURAT_LAYERS - 1));
+	}
+}
+
+// ZigguratUniform() returns a uniformly distributed random number in the open interval (0, 1) from *pSource,
+//     so log() never sees 0: the upper 31 bits of the next random number of an LCG lane, or the upper 53
+//     bits of the next random number of an engine.
+static inline double	ZigguratUniform(ZigguratSource *pSource)
+{
+	if (pSource->pSeed != NULL)
+		return ((ZigguratNext(pSource->pSeed) >> 1) + 0.5) * (1.0 / 2147483648.0);
+	else
+		return ((RandEngineNext64(pSource->pEngine) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+// ZigguratFix() is the slow path (nfix() of Marsaglia and Tsang) for a draw hz in layer iz which missed
+//     the rectangular part of the layer.  It keeps drawing from *pSource until it returns a Gaussian
+//     random number.
+static double	ZigguratFix(ZigguratSource *pSource, int hz, int iz)
+{
+	double	x, y;
+
+	for (;;)
+	{
+		x = hz * wnTable[iz];
+
+		// Layer 0 is the base strip, whose part beyond ZIGGURAT_R is the tail of the density.  We sample
+		//     the tail with Marsaglia's method for the normal tail.
+		if (iz == 0)
+		{
+			do {
+				x = -log(ZigguratUniform(pSource)) / ZIGGURAT_R;
+				y = -log(ZigguratUniform(pSource));
+			} while (y + y < x * x);
+			return (hz > 0) ? ZIGGURAT_R + x : -ZIGGURAT_R - x;
+		}
+
+		// The wedge of layer iz: accept x if a uniform point between the two layer edges is under the density.
+		if (fnTable[iz] + ZigguratUniform(pSource) * (fnTable[iz - 1] - fnTable[iz]) < exp(-0.5 * x * x))
+			return x;
+
+		// Rejected; drawing again, with the fast path first.
+		ZigguratDraw(pSource, &hz, &iz);
+		if (fabs((double) hz) < knTable[iz])
+			return hz * wnTable[iz];
+	}
+}
+
+// A Ziggurat kernel writes numBlocks blocks of NUM_GAUSSIANRAND_LANES Gaussian random numbers to pResults,
+//     one from each lane of pLaneSeeds[] per block.  Every lane draws exactly two 32-bit random numbers
+//     on the fast path and resolves a miss on its own with ZigguratFix(), so all the kernels return the
+//     same sequence bit for bit.  pResults does not need to be aligned.
+typedef void (*GaussianZigBlocks_t)(unsigned int *pLaneSeeds, double *pResults, size_t numBlocks);
+
+// GaussianZigBlocksScalar() is the plain C kernel.
+static void	GaussianZigBlocksScalar(unsigned int *pLaneSeeds, double *pResults, size_t numBlocks)
+{
+	for (size_t b = 0; b < numBlocks; b++)
+	{
+		for (int lane = 0; lane < NUM_GAUSSIANRAND_LANES; lane++)
+		{
+			ZigguratSource	source = { &pLaneSeeds[lane], NULL };
+			int				hz, iz;
+
+			ZigguratDraw(&source, &hz, &iz);
+			if (fabs((double) hz) < knTable[iz])
+				pResults[lane] = hz * wnTable[iz];
+			else
+				pResults[lane] = ZigguratFix(&source, hz, iz);
+		}
+		pResults += NUM_GAUSSIANRAND_LANES;
+	}
+}
+
+// GaussianZigBlocksAVX2() is the AVX2 kernel.  The eight 32-bit lanes fit in one __m256i, while the
+//     doubles run on lanes 0-3 and lanes 4-7 separately.
+static void	GaussianZigBlocksAVX2(unsigned int *pLaneSeeds, double *pResults, size_t numBlocks)
+{
+	const __m256i l214013 = _mm256_set1_epi32(214013L);
+	const __m256i l2531011 = _mm256_set1_epi32(2531011L);
+	const __m256d dSignBits = _mm256_set1_pd(-0.0);
+	__m256i avxRand = _mm256_loadu_si256((const __m256i *) pLaneSeeds);
+
+	for (size_t b = 0; b < numBlocks; b++)
+	{
+		int		iAccepted = 0;
+
+		// hz = avxRand * 214013L + 2531011L, and iz = the upper seven bits of hz * 214013L + 2531011L, in eight lanes.
+		__m256i     avxHz = _mm256_add_epi32(_mm256_mullo_epi32(avxRand, l214013), l2531011);
+		avxRand = _mm256_add_epi32(_mm256_mullo_epi32(avxHz, l214013), l2531011);
+		__m256i     avxIz = _mm256_srli_epi32(avxRand, ZIGGURAT_LAYER_SHIFT);
+
+		for (int h = 0; h < 2; h++)
+		{
+			__m128i	iHz = (h == 0) ? _mm256_castsi256_si128(avxHz) : _mm256_extracti128_si256(avxHz, 1);
+			__m128i	iIz = (h == 0) ? _mm256_castsi256_si128(avxIz) : _mm256_extracti128_si256(avxIz, 1);
+			__m256d	dHz = _mm256_cvtepi32_pd(iHz);
+			__m256d	dKn = _mm256_i32gather_pd(knTable, iIz, 8);
+			__m256d	dWn = _mm256_i32gather_pd(wnTable, iIz, 8);
+
+			// |hz| < kn[iz] in four lanes, collected into bits 4*h to 4*h + 3 of iAccepted.
+			iAccepted |= _mm256_movemask_pd(_mm256_cmp_pd(_mm256_andnot_pd(dSignBits, dHz), dKn, _CMP_LT_OQ)) << (4 * h);
+			_mm256_storeu_pd(pResults + 4 * h, _mm256_mul_pd(dHz, dWn));
+		}
+
+		// About one block in ten has a lane off the fast path; those lanes are fixed one by one.
+		if (iAccepted != 0xff)
+		{
+			alignas(32) int	hz[NUM_GAUSSIANRAND_LANES];
+
+			_mm256_store_si256((__m256i *) hz, avxHz);
+			_mm256_storeu_si256((__m256i *) pLaneSeeds, avxRand);
+			for (int lane = 0; lane < NUM_GAUSSIANRAND_LANES; lane++)
+			{
+				if (!(iAccepted & (1 << lane)))
+				{
+					ZigguratSource	source = { &pLaneSeeds[lane], NULL };
+
+					pResults[lane] = ZigguratFix(&source, hz[lane], (int) (pLaneSeeds[lane] >> ZIGGURAT_LAYER_SHIFT));
+				}
+			}
+			avxRand = _mm256_loadu_si256((const __m256i *) pLaneSeeds);
+		}
+		pResults += NUM_GAUSSIANRAND_LANES;
+	}
+	_mm256_storeu_si256((__m256i *) pLaneSeeds, avxRand);
+}
+
+// GaussianZigBlocksAVX512() is the AVX512 kernel, which handles the eight lanes of doubles in one __m512d.
+static void	GaussianZigBlocksAVX512(unsigned int *pLaneSeeds, double *pResults, size_t numBlocks)
+{
+	const __m256i l214013 = _mm256_set1_epi32(214013L);
+	const __m256i l2531011 = _mm256_set1_epi32(2531011L);
+	__m256i avxRand = _mm256_loadu_si256((const __m256i *) pLaneSeeds);
+
+	for (size_t b = 0; b < numBlocks; b++)
+	{
+		// hz = avxRand * 214013L + 2531011L, and iz = the upper seven bits of hz * 214013L + 2531011L, in eight lanes.
+		__m256i     avxHz = _mm256_add_epi32(_mm256_mullo_epi32(avxRand, l214013), l2531011);
+		avxRand = _mm256_add_epi32(_mm256_mullo_epi32(avxHz, l214013), l2531011);
+		__m256i     avxIz = _mm256_srli_epi32(avxRand, ZIGGURAT_LAYER_SHIFT);
+		__m512d		dHz = _mm512_cvtepi32_pd(avxHz);
+		__m512d		dKn = _mm512_i32gather_pd(avxIz, knTable, 8);
+		__m512d		dWn = _mm512_i32gather_pd(avxIz, wnTable, 8);
+		__mmask8	dAccepted = _mm512_cmp_pd_mask(_mm512_abs_pd(dHz), dKn, _CMP_LT_OQ);
+
+		_mm512_storeu_pd(pResults, _mm512_mul_pd(dHz, dWn));
+
+		// About one block in ten has a lane off the fast path; those lanes are fixed one by one.
+		if (dAccepted != 0xff)
+		{
+			alignas(32) int	hz[NUM_GAUSSIANRAND_LANES];
+
+			_mm256_store_si256((__m256i *) hz, avxHz);
+			_mm256_storeu_si256((__m256i *) pLaneSeeds, avxRand);
+			for (int lane = 0; lane < NUM_GAUSSIANRAND_LANES; lane++)
+			{
+				if (!(dAccepted & (1 << lane)))
+				{
+					ZigguratSource	source = { &pLaneSeeds[lane], NULL };
+
+					pResults[lane] = ZigguratFix(&source, hz[lane], (int) (pLaneSeeds[lane] >> ZIGGURAT_LAYER_SHIFT));
+				}
+			}
+			avxRand = _mm256_loadu_si256((const __m256i *) pLaneSeeds);
+		}
+		pResults += NUM_GAUSSIANRAND_LANES;
+	}
+	_mm256_storeu_si256((__m256i *) pLaneSeeds, avxRand);
+}
+
+// A Ziggurat transform turns pRaw[0], ..., pRaw[n - 1], 64-bit random numbers from an engine, into Gaussian
+//     random numbers in pResults[] on the fast path.  It returns how many of them missed the fast path and
+//     lists their indices in ascending order in pMissed[]; the caller fixes those up with ZigguratFix().
+//     n is at most NUM_ZIGGURAT_ENGINE_CHUNK.
+typedef size_t (*GaussianZigTransform_t)(const unsigned long long *pRaw, double *pResults, size_t n, unsigned short *pMissed);
+
+#define NUM_ZIGGURAT_ENGINE_CHUNK	256
+
+// GaussianZigTransformScalar() is the plain C transform.
+static size_t	GaussianZigTransformScalar(const unsigned long long *pRaw, double *pResults, size_t n, unsigned short *pMissed)
+{
+	size_t	numMissed = 0;
+
+	for (size_t i = 0; i < n; i++)
+	{
+		int		hz = (int) (pRaw[i] >> 32);
+		int		iz = (int) (pRaw[i] & (NUM_ZIGGURAT_LAYERS - 1));
+
+		pResults[i] = hz * wnTable[iz];
+		if (!(fabs((double) hz) < knTable[iz]))
+			pMissed[numMissed++] = (unsigned short) i;
+	}
+	return numMissed;
+}
+
+// GaussianZigTransformAVX2() is the AVX2 transform, four random numbers at a time.
+static size_t	GaussianZigTransformAVX2(const unsigned long long *pRaw, double *pResults, size_t n, unsigned short *pMissed)
+{
+	const __m256i m127 = _mm256_set1_epi64x(NUM_ZIGGURAT_LAYERS - 1);
+	const __m256i iUpperHalves = _mm256_setr_epi32(1, 3, 5, 7, 1, 3, 5, 7);
+	const __m256i iLowerHalves = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+	const __m256d dSignBits = _mm256_set1_pd(-0.0);
+	size_t	i, numMissed = 0;
+
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		// Packing the upper halves (hz) and the lowest seven bits (iz) of four 64-bit numbers into 32-bit lanes.
+		__m256i	r = _mm256_loadu_si256((const __m256i *) (pRaw + i));
+		__m128i	iHz = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(r, iUpperHalves));
+		__m128i	iIz = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_and_si256(r, m127), iLowerHalves));
+		__m256d	dHz = _mm256_cvtepi32_pd(iHz);
+		__m256d	dKn = _mm256_i32gather_pd(knTable, iIz, 8);
+		__m256d	dWn = _mm256_i32gather_pd(wnTable, iIz, 8);
+		int		iAccepted = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_andnot_pd(dSignBits, dHz), dKn, _CMP_LT_OQ));
+
+		_mm256_storeu_pd(pResults + i, _mm256_mul_pd(dHz, dWn));
+		if (iAccepted != 0xf)
+		{
+			for (int lane = 0; lane < 4; lane++)
+				if (!(iAccepted & (1 << lane)))
+					pMissed[numMissed++] = (unsigned short) (i + lane);
+		}
+	}
+
+	return numMissed + GaussianZigTransformScalar(pRaw + i, pResults + i, n - i, pMissed + numMissed);
+}
+
+// GaussianZigTransformAVX512() is the AVX512 transform, eight random numbers at a time.
+static size_t	GaussianZigTransformAVX512(const unsigned long long *pRaw, double *pResults, size_t n, unsigned short *pMissed)
+{
+	const __m512i m127 = _mm512_set1_epi64(NUM_ZIGGURAT_LAYERS - 1);
+	size_t	i, numMissed = 0;
+
+	for (i = 0; i + 8 <= n; i += 8)
+	{
+		__m512i		r = _mm512_loadu_si512(pRaw + i);
+		__m256i		iHz = _mm512_cvtepi64_epi32(_mm512_srli_epi64(r, 32));
+		__m256i		iIz = _mm512_cvtepi64_epi32(_mm512_and_si512(r, m127));
+		__m512d		dHz = _mm512_cvtepi32_pd(iHz);
+		__m512d		dKn = _mm512_i32gather_pd(iIz, knTable, 8);
+		__m512d		dWn = _mm512_i32gather_pd(iIz, wnTable, 8);
+		__mmask8	dAccepted = _mm512_cmp_pd_mask(_mm512_abs_pd(dHz), dKn, _CMP_LT_OQ);
+
+		_mm512_storeu_pd(pResults + i, _mm512_mul_pd(dHz, dWn));
+		if (dAccepted != 0xff)
+		{
+			for (int lane = 0; lane < 8; lane++)
+				if (!(dAccepted & (1 << lane)))
+					pMissed[numMissed++] = (unsigned short) (i + lane);
+		}
+	}
+
+	return numMissed + GaussianZigTransformScalar(pRaw + i, pResults + i, n - i, pMissed + numMissed);
+}
+
+// SelectGaussianRandZigISA() returns the fastest instruction set we have a Ziggurat kernel for on the
+//     running CPU.  There is no SSE4.1 kernel, since SSE4.1 has no gather instructions.
+static MiscRandISA	SelectGaussianRandZigISA()
+{
+	if (supportAVX512F() && supportAVX2())
+		return MISCRAND_ISA_AVX512;
+	else if (supportAVX2())
+		return MISCRAND_ISA_AVX2;
+	else
+		return MISCRAND_ISA_SCALAR;
+}
+
+static void	GaussianZigBlocksResolve(unsigned int *pLaneSeeds, double *pResults, size_t numBlocks);
+
+// pGaussianZigBlocks and gaussianRandZigISA are bound at startup the same way as their GaussianRandVec()
+//     counterparts in GaussianRand.cpp.  The tables are filled before any kernel is bound.
+static GaussianZigBlocks_t	pGaussianZigBlocks = GaussianZigBlocksResolve;
+static GaussianZigTransform_t	pGaussianZigTransform = GaussianZigTransformScalar;
+static MiscRandISA			gaussianRandZigISA = MISCRAND_ISA_SCALAR;
+static const bool			bGaussianRandZigBound = GaussianRandZigSetISA(SelectGaussianRandZigISA());
+
+static void	GaussianZigBlocksResolve(unsigned int *pLaneSeeds, double *pResults, size_t numBlocks)
+{
+	GaussianRandZigSetISA(SelectGaussianRandZigISA());
+	pGaussianZigBlocks(pLaneSeeds, pResults, numBlocks);
+}
+
+// GaussianRandZigISA() returns the instruction set of the kernel GaussianRandZig() and its siblings use.
+MiscRandISA	MISCRAND_CDECL	GaussianRandZigISA()
+{
+	if (pGaussianZigBlocks == GaussianZigBlocksResolve)
+		GaussianRandZigSetISA(SelectGaussianRandZigISA());
+	return gaussianRandZigISA;
+}
+
+// GaussianRandZigSetISA() makes GaussianRandZig() and its siblings use the kernel for isa.  It returns
+//     false and changes nothing if there is no kernel for isa or the running CPU does not support it.  It
+//     is not meant to be called while other threads are generating.
+bool	MISCRAND_CDECL	GaussianRandZigSetISA(MiscRandISA isa)
+{
+	if (pGaussianZigBlocks == GaussianZigBlocksResolve)
+		ZigguratSetTables();
+
+	switch (isa)
+	{
+	case MISCRAND_ISA_AVX512:
+		if (!supportAVX512F() || !supportAVX2())
+			return false;
+		pGaussianZigBlocks = GaussianZigBlocksAVX512;
+		pGaussianZigTransform = GaussianZigTransformAVX512;
+		break;
+	case MISCRAND_ISA_AVX2:
+		if (!supportAVX2())
+			return false;
+		pGaussianZigBlocks = GaussianZigBlocksAVX2;
+		pGaussianZigTransform = GaussianZigTransformAVX2;
+		break;
+	case MISCRAND_ISA_SCALAR:
+		pGaussianZigBlocks = GaussianZigBlocksScalar;
+		pGaussianZigTransform = GaussianZigTransformScalar;
+		break;
+	default:
+		return false;
+	}
+	gaussianRandZigISA = isa;
+	return true;
+}
+
+// GaussianRandZig() returns a Gaussian-distributed double random number with zero mean and unit variance
+//     by the Ziggurat method.
+double		MISCRAND_CDECL	GaussianRandZig()
+{
+	return GaussianRandZig_r(MiscRandDefaultState());
+}
+
+// GaussianRandZig_r() is GaussianRandZig() working on *pState.
+double		MISCRAND_CDECL	GaussianRandZig_r(MiscRandState *pState)
+{
+	if (pState->numAvailableZigResults == 0)
+	{
+		pGaussianZigBlocks(pState->laneSeeds, pState->zigResults, 1);
+		pState->numAvailableZigResults = NUM_GAUSSIANRAND_LANES;
+	}
+
+	return pState->zigResults[NUM_GAUSSIANRAND_LANES - pState->numAvailableZigResults--];
+}
+
+// GaussianRandZigFill() fills pOut[0], ..., pOut[n - 1] with what n GaussianRandZig() calls would return.
+//     pOut does not need to be aligned.
+void		MISCRAND_CDECL	GaussianRandZigFill(double *pOut, size_t n)
+{
+	GaussianRandZigFill_r(MiscRandDefaultState(), pOut, n);
+}
+
+// GaussianRandZigFill_r() is GaussianRandZigFill() working on *pState.
+void		MISCRAND_CDECL	GaussianRandZigFill_r(MiscRandState *pState, double *pOut, size_t n)
+{
+	size_t	numBlocks;
+
+	// The head comes from zigResults[], the body straight from the kernel, and the tail from zigResults[]
+	//     again, as in GaussianRandVecFill_r().
+	while ((n > 0) && (pState->numAvailableZigResults > 0))
+	{
+		*pOut++ = GaussianRandZig_r(pState);
+		n--;
+	}
+
+	numBlocks = n / NUM_GAUSSIANRAND_LANES;
+	if (numBlocks > 0)
+	{
+		pGaussianZigBlocks(pState->laneSeeds, pOut, numBlocks);
+		pOut += numBlocks * NUM_GAUSSIANRAND_LANES;
+		n -= numBlocks * NUM_GAUSSIANRAND_LANES;
+	}
+
+	while (n > 0)
+	{
+		*pOut++ = GaussianRandZig_r(pState);
+		n--;
+	}
+}
+
+// GaussianRandZigEngineFill() fills pOut[0], ..., pOut[n - 1] with Gaussian-distributed random numbers with
+//     zero mean and unit variance by the Ziggurat method, driven by *pEngine instead of the LCG lanes.  Each
+//     64-bit random number gives hz from its upper half and the layer from its lowest seven bits; the few
+//     that miss the fast path draw more from *pEngine in turn.  pOut does not need to be aligned.
+void		MISCRAND_CDECL	GaussianRandZigEngineFill(MiscRandEngine *pEngine, double *pOut, size_t n)
+{
+	unsigned long long	raw[NUM_ZIGGURAT_ENGINE_CHUNK];
+	unsigned short		missed[NUM_ZIGGURAT_ENGINE_CHUNK];
+	ZigguratSource		source = { NULL, pEngine };
+
+	if (pGaussianZigBlocks == GaussianZigBlocksResolve)
+		GaussianRandZigSetISA(SelectGaussianRandZigISA());
+
+	while (n > 0)
+	{
+		size_t	numRaw = (n < NUM_ZIGGURAT_ENGINE_CHUNK) ? n : NUM_ZIGGURAT_ENGINE_CHUNK;
+		size_t	numMissed;
+
+		RandEngineFill64(pEngine, raw, numRaw);
+		numMissed = pGaussianZigTransform(raw, pOut, numRaw, missed);
+		for (size_t k = 0; k < numMissed; k++)
+		{
+			unsigned long long	r = raw[missed[k]];
+
+			pOut[missed[k]] = ZigguratFix(&source, (int) (r >> 32), (int) (r & (NUM_ZIGGURAT_LAYERS - 1)));
+		}
+		pOut += numRaw;
+		n -= numRaw;
+	}
+}
@@ -1,10 +1,306 @@
+#pragma once
+#include <stddef.h>
+#include "MiscRandPortability.h"
+
+#define NUM_GAUSSIANRAND_LANES          8       // GaussianRandVec() runs this many lanes, and a kernel run
+#define NUM_GAUSSIANRAND_BLOCK          (2 * NUM_GAUSSIANRAND_LANES)    //     makes two numbers in each.
+
+// GaussianRandVec() refills its buffer with NUM_GAUSSIANRAND_GENERATED numbers, from that many over
+//     NUM_GAUSSIANRAND_BLOCK kernel runs.  It is a tunable: it may be defined on the compiler command line,
+//     to NUM_GAUSSIANRAND_BLOCK times a power of two, for the library and every program including this
+//     header alike, since the layout of MiscRandState depends on it.  The sequences do not depend on it,
+//     only how often the refills happen; the counters of MiscRandCounters.cpp tell how they go.
+#ifndef NUM_GAUSSIANRAND_GENERATED
+#define NUM_GAUSSIANRAND_GENERATED      16
+#endif
+
+#define NUM_GAUSSIANRANDFLOAT_GENERATED 32      // GaussianRandVecFloat() generates this many numbers per refill,
+#define NUM_GAUSSIANRANDFLOAT_LANES     16      //     two from each of these many lanes.
+
+// GaussianRandVecCompact() stages up to this many accepted (u, v, s) triples between transforms: fewer than
+//     eight left over, plus the eight lanes of one more round.
+#define NUM_STAGED_PAIRS                (2 * NUM_GAUSSIANRAND_LANES)
+
+// SplitStreams() cuts the period of the LCG into one slice for LargerRand() and one for each lane.
+#define NUM_SPLIT_SLICES                (1 + NUM_GAUSSIANRAND_LANES + NUM_GAUSSIANRANDFLOAT_LANES)
+
+// MiscRandISA names the instruction sets the vectorized generators have kernels for.
+typedef enum MiscRandISA
+{
+	MISCRAND_ISA_SCALAR = 0,
+	MISCRAND_ISA_SSE41,
+	MISCRAND_ISA_AVX2,
+	MISCRAND_ISA_AVX512
+} MiscRandISA;
+
+// MiscRandState keeps all the states of the generators in this library.  The functions ending with _r
+//     work on the MiscRandState passed in, so different threads can generate random numbers at the same
+//     time without locks as long as each of them owns its MiscRandState.  The functions without _r work on
+//     a thread-local MiscRandState (see MiscRandDefaultState()).  MiscRandState is aligned on 64-byte
+//     and its size is a multiple of 64 bytes, so two of them never share a cache line.
+typedef struct alignas(64) MiscRandState
+{
+	double			results[NUM_GAUSSIANRAND_GENERATED];	// Gaussian random numbers not served yet
+	double			zigResults[NUM_GAUSSIANRAND_LANES];		// Ziggurat Gaussian random numbers not served yet
+	double			compactResults[NUM_GAUSSIANRAND_GENERATED];	// GaussianRandVecCompact() numbers not served yet
+	double			stagedPairs[3][NUM_STAGED_PAIRS];		// Accepted u, v and s not transformed yet
+	float			floatResults[NUM_GAUSSIANRANDFLOAT_GENERATED];	// Float Gaussian random numbers not served yet
+	unsigned int	laneSeeds[NUM_GAUSSIANRAND_LANES];		// States of the GaussianRandVec() and
+															//     GaussianRandZig() lanes
+	unsigned int	floatLaneSeeds[NUM_GAUSSIANRANDFLOAT_LANES];	// States of the GaussianRandVecFloat() lanes
+	unsigned long	uLargerRandSeed;						// State of LargerRand()
+	int				numAvailableResults;					// Number of entries left in results[]
+	int				numAvailableZigResults;					// Number of entries left in zigResults[]
+	int				numAvailableFloatResults;				// Number of entries left in floatResults[]
+	int				numAvailableCompactResults;				// Number of entries left in compactResults[]
+	int				numStagedPairs;							// Number of entries in each of stagedPairs[]
+} MiscRandState;
+
+#define NUM_ENGINE_LANES                8       // The random number engines run this many lanes,
+#define NUM_ENGINE_BLOCK                16      //     and generate this many 64-bit numbers per kernel call.
+
+// MiscRandEngineType names the 64-bit random number engines in RandEngines.cpp.
+typedef enum MiscRandEngineType
+{
+	MISCRAND_ENGINE_XOSHIRO256SS = 0,
+	MISCRAND_ENGINE_PCG64,
+	MISCRAND_ENGINE_PHILOX4X32,
+	NUM_MISCRAND_ENGINES
+} MiscRandEngineType;
+
+// MiscRandEngine keeps the state of one random number engine.  Like MiscRandState, each thread should own
+//     the MiscRandEngine it generates from.
+typedef struct alignas(64) MiscRandEngine
+{
+	unsigned long long	lanes[4][NUM_ENGINE_LANES];		// Per-lane states; see RandEngineKernels.cpp
+	unsigned long long	results[NUM_ENGINE_BLOCK];		// 64-bit random numbers not served yet
+	MiscRandEngineType	type;
+	int					numAvailableResults;			// Number of entries left in results[]
+	unsigned int		uPendingHalf;					// Upper half of the last 64-bit number
+	int					bHasPendingHalf;				//     RandEngineNext32() split
+} MiscRandEngine;
+
+// GaussianRandRing is a ring buffer a producer thread keeps filled with Gaussian random numbers; see
+//     GaussianRandRing.cpp.
+typedef struct GaussianRandRing GaussianRandRing;
+
+// MiscRandStreamType names the generators a stream file can hold; see RandStream.cpp.
+typedef enum MiscRandStreamType
+{
+	MISCRAND_STREAM_GAUSSIANRANDVEC = 0,		// GaussianRandVecFill() doubles
+	MISCRAND_STREAM_GAUSSIANRANDVECFLOAT,		// GaussianRandVecFloatFill() floats
+	MISCRAND_STREAM_UNIFORMRAND,				// UniformRandFill() doubles in [0, 1)
+	MISCRAND_STREAM_UNIFORMRANDFLOAT,			// UniformRandFillFloat() floats in [0, 1)
+	NUM_MISCRAND_STREAMS
+} MiscRandStreamType;
+
+// RandStream is a stream file mapped for replay; see RandStream.cpp.
+typedef struct RandStream RandStream;
+
+#define SOBOL_MAX_DIMENSION             3667    // SobolRandCreate() has direction numbers for this many dimensions
+
+// MiscRandSobolScramble names the ways SobolRandCreate() can randomize a Sobol sequence; see SobolRand.cpp.
+typedef enum MiscRandSobolScramble
+{
+	MISCRAND_SOBOL_UNSCRAMBLED = 0,			// The plain sequence of Joe and Kuo
+	MISCRAND_SOBOL_DIGITAL_SHIFT,			// Each dimension XORed with a random number
+	MISCRAND_SOBOL_LINEAR_MATRIX			// Matousek's random linear scrambling plus the digital shift
+} MiscRandSobolScramble;
+
+// SobolRand is a Sobol low-discrepancy sequence; see SobolRand.cpp.
+typedef struct SobolRand SobolRand;
+
+// MiscRandCounters holds what the instrumented GaussianRandVec() paths counted on one thread.  They only count
+//     if the library is built with MISCRAND_INSTRUMENTATION defined; see MiscRandCounters.cpp.
+typedef struct MiscRandCounters
+{
+	unsigned long long	numRefills;				// Refills of results[] by GaussianRandVec()
+	unsigned long long	numBlocks;				// Kernel runs, for the refills and for GaussianRandVecFill()
+	unsigned long long	numRejectionRounds;		// Rounds of the rejection loops of those kernel runs
+	unsigned long long	numFrozenLanes;			// Lanes that sat those rounds out, having accepted already
+	unsigned long long	numSamples;				// Numbers GaussianRandVec() and GaussianRandVecFill() returned
+	unsigned long long	refillCycles;			// TSC cycles spent in the kernels
+	unsigned long long	serveCycles;			// TSC cycles spent in GaussianRandVec() and GaussianRandVecFill()
+												//     outside the kernels
+} MiscRandCounters;
+
+// Header files from MiscRandState.cpp
+
+void	MISCRAND_CDECL	MiscRandStateInit(MiscRandState *pState);
+MiscRandState *	MISCRAND_CDECL	MiscRandDefaultState();
+bool	MISCRAND_CDECL	SplitStreams(MiscRandState *pStates, int n, unsigned long seed,
+	unsigned long long streamLength);
+void	MISCRAND_CDECL	SplitStreamAt(MiscRandState *pState, unsigned long seed, unsigned long long streamIndex,
+	unsigned long long streamLength);
+
 // Header files from UniformRand.cpp
 
-void	__cdecl	sLargerRand(unsigned long _Seed);
-long	__cdecl	LargerRand();
+void	MISCRAND_CDECL	sLargerRand(unsigned long _Seed);
+long	MISCRAND_CDECL	LargerRand();
+void	MISCRAND_CDECL	sLargerRand_r(MiscRandState *pState, unsigned long _Seed);
+long	MISCRAND_CDECL	LargerRand_r(MiscRandState *pState);
+unsigned long	MISCRAND_CDECL	LargerRandJumpSeed(unsigned long _Seed, unsigned long long k);
+void	MISCRAND_CDECL	LargerRandJump(unsigned long long k);
+void	MISCRAND_CDECL	LargerRandJump_r(MiscRandState *pState, unsigned long long k);
+double	MISCRAND_CDECL	UniformRand();
+double	MISCRAND_CDECL	UniformRand_r(MiscRandState *pState);
+void	MISCRAND_CDECL	UniformRandFill(double *pOut, size_t n, double lo, double hi);
+void	MISCRAND_CDECL	UniformRandFillOpen(double *pOut, size_t n, double lo, double hi);
+void	MISCRAND_CDECL	UniformRandFillFloat(float *pOut, size_t n, float lo, float hi);
+void	MISCRAND_CDECL	UniformRandFillFloatOpen(float *pOut, size_t n, float lo, float hi);
+void	MISCRAND_CDECL	UniformRandFill_r(MiscRandState *pState, double *pOut, size_t n, double lo, double hi);
+void	MISCRAND_CDECL	UniformRandFillOpen_r(MiscRandState *pState, double *pOut, size_t n, double lo, double hi);
+void	MISCRAND_CDECL	UniformRandFillFloat_r(MiscRandState *pState, float *pOut, size_t n, float lo, float hi);
+void	MISCRAND_CDECL	UniformRandFillFloatOpen_r(MiscRandState *pState, float *pOut, size_t n, float lo, float hi);
+MiscRandISA	MISCRAND_CDECL	UniformRandISA();
+bool	MISCRAND_CDECL	UniformRandSetISA(MiscRandISA isa);
 
 // Header files from GaussianRand.cpp
 
-double	__cdecl	GaussianRand();
-void	__cdecl sGaussianRandVec(int s0, int s1, int s2, int s3);
-double	__cdecl	GaussianRandVec();
+double	MISCRAND_CDECL	GaussianRand();
+void	MISCRAND_CDECL sGaussianRandVec(int s0, int s1, int s2, int s3, int s4, int s5, int s6, int s7);
+double	MISCRAND_CDECL	GaussianRandVec();
+void	MISCRAND_CDECL	GaussianRandVecFill(double *pOut, size_t n);
+void	MISCRAND_CDECL sGaussianRandVec_r(MiscRandState *pState, int s0, int s1, int s2, int s3,
+	int s4, int s5, int s6, int s7);
+double	MISCRAND_CDECL	GaussianRandVec_r(MiscRandState *pState);
+void	MISCRAND_CDECL	GaussianRandVecFill_r(MiscRandState *pState, double *pOut, size_t n);
+double	MISCRAND_CDECL	GaussianRandVecCompact();
+void	MISCRAND_CDECL	GaussianRandVecCompactFill(double *pOut, size_t n);
+double	MISCRAND_CDECL	GaussianRandVecCompact_r(MiscRandState *pState);
+void	MISCRAND_CDECL	GaussianRandVecCompactFill_r(MiscRandState *pState, double *pOut, size_t n);
+void	MISCRAND_CDECL	GaussianRandVecJump(unsigned long long k);
+void	MISCRAND_CDECL	GaussianRandVecJump_r(MiscRandState *pState, unsigned long long k);
+void	MISCRAND_CDECL sGaussianRandVecFloat(const unsigned int *pSeeds);
+float	MISCRAND_CDECL	GaussianRandVecFloat();
+void	MISCRAND_CDECL	GaussianRandVecFloatFill(float *pOut, size_t n);
+void	MISCRAND_CDECL	GaussianRandVecFloatJump(unsigned long long k);
+void	MISCRAND_CDECL sGaussianRandVecFloat_r(MiscRandState *pState, const unsigned int *pSeeds);
+float	MISCRAND_CDECL	GaussianRandVecFloat_r(MiscRandState *pState);
+void	MISCRAND_CDECL	GaussianRandVecFloatFill_r(MiscRandState *pState, float *pOut, size_t n);
+void	MISCRAND_CDECL	GaussianRandVecFloatJump_r(MiscRandState *pState, unsigned long long k);
+MiscRandISA	MISCRAND_CDECL	GaussianRandVecISA();
+bool	MISCRAND_CDECL	GaussianRandVecSetISA(MiscRandISA isa);
+
+// Header files from RandEngines.cpp
+
+void	MISCRAND_CDECL	RandEngineInit(MiscRandEngine *pEngine, MiscRandEngineType type, unsigned long long seed);
+unsigned long long	MISCRAND_CDECL	RandEngineNext64(MiscRandEngine *pEngine);
+unsigned int	MISCRAND_CDECL	RandEngineNext32(MiscRandEngine *pEngine);
+double	MISCRAND_CDECL	RandEngineNextDouble(MiscRandEngine *pEngine);
+void	MISCRAND_CDECL	RandEngineFill64(MiscRandEngine *pEngine, unsigned long long *pOut, size_t n);
+void	MISCRAND_CDECL	RandEngineFill32(MiscRandEngine *pEngine, unsigned int *pOut, size_t n);
+void	MISCRAND_CDECL	RandEngineFillDouble(MiscRandEngine *pEngine, double *pOut, size_t n);
+MiscRandISA	MISCRAND_CDECL	RandEngineISA();
+bool	MISCRAND_CDECL	RandEngineSetISA(MiscRandISA isa);
+
+// Header files from GaussianZiggurat.cpp
+
+double	MISCRAND_CDECL	GaussianRandZig();
+void	MISCRAND_CDECL	GaussianRandZigFill(double *pOut, size_t n);
+double	MISCRAND_CDECL	GaussianRandZig_r(MiscRandState *pState);
+void	MISCRAND_CDECL	GaussianRandZigFill_r(MiscRandState *pState, double *pOut, size_t n);
+MiscRandISA	MISCRAND_CDECL	GaussianRandZigISA();
+bool	MISCRAND_CDECL	GaussianRandZigSetISA(MiscRandISA isa);
+void	MISCRAND_CDECL	GaussianRandZigEngineFill(MiscRandEngine *pEngine, double *pOut, size_t n);
+
+// Header files from ParallelFill.cpp
+
+void	MISCRAND_CDECL	ParallelGaussianFill(double *pOut, size_t n, unsigned long seed, int numThreads);
+void	MISCRAND_CDECL	ParallelUniformFill(double *pOut, size_t n, unsigned long seed, int numThreads);
+
+// Header files from GaussianRandRing.cpp
+
+GaussianRandRing *	MISCRAND_CDECL	GaussianRandRingCreate(size_t ringSize, size_t lowWatermark, bool bMultiConsumer,
+	unsigned long seed);
+void	MISCRAND_CDECL	GaussianRandRingDestroy(GaussianRandRing *pRing);
+double	MISCRAND_CDECL	GaussianRandRingNext(GaussianRandRing *pRing);
+
+// Header files from EntropyPool.cpp
+
+unsigned long long	MISCRAND_CDECL	EntropyPoolNext();
+void	MISCRAND_CDECL	EntropyPoolFill(unsigned long long *pOut, size_t n);
+void	MISCRAND_CDECL	EntropyPoolStats(unsigned long long *pNumRDSEEDWords, unsigned long long *pNumRDRANDWords,
+	unsigned long long *pNumFallbackWords);
+void	MISCRAND_CDECL	EntropySeed();
+void	MISCRAND_CDECL	EntropySeed_r(MiscRandState *pState);
+void	MISCRAND_CDECL	EntropySeedStates(MiscRandState *pStates, int n);
+void	MISCRAND_CDECL	EntropySeedEngine(MiscRandEngine *pEngine, MiscRandEngineType type);
+
+// Header files from RandDistributions.cpp
+
+void	MISCRAND_CDECL	ExponentialRandFill(double *pOut, size_t n, double lambda);
+void	MISCRAND_CDECL	ExponentialRandFill_r(MiscRandState *pState, double *pOut, size_t n, double lambda);
+void	MISCRAND_CDECL	GammaRandFill(double *pOut, size_t n, double shape, double scale);
+void	MISCRAND_CDECL	GammaRandFill_r(MiscRandState *pState, double *pOut, size_t n, double shape, double scale);
+bool	MISCRAND_CDECL	PoissonRandFill(unsigned int *pOut, size_t n, double lambda);
+bool	MISCRAND_CDECL	PoissonRandFill_r(MiscRandState *pState, unsigned int *pOut, size_t n, double lambda);
+void	MISCRAND_CDECL	TruncatedGaussianFill(double *pOut, size_t n, double a, double b);
+void	MISCRAND_CDECL	TruncatedGaussianFill_r(MiscRandState *pState, double *pOut, size_t n, double a, double b);
+MiscRandISA	MISCRAND_CDECL	RandDistributionsISA();
+bool	MISCRAND_CDECL	RandDistributionsSetISA(MiscRandISA isa);
+
+// Header files from MultivariateGaussian.cpp
+
+bool	MISCRAND_CDECL	MultivariateGaussianFill(const double *pL, int dim, size_t count, double *pOut);
+bool	MISCRAND_CDECL	MultivariateGaussianFill_r(MiscRandState *pState, const double *pL, int dim, size_t count,
+	double *pOut);
+bool	MISCRAND_CDECL	MultivariateGaussianFillSoA(const double *pL, int dim, size_t count, double *pOut);
+bool	MISCRAND_CDECL	MultivariateGaussianFillSoA_r(MiscRandState *pState, const double *pL, int dim, size_t count,
+	double *pOut);
+MiscRandISA	MISCRAND_CDECL	MultivariateGaussianISA();
+bool	MISCRAND_CDECL	MultivariateGaussianSetISA(MiscRandISA isa);
+
+// Header files from GaussianNoise.cpp
+
+void	MISCRAND_CDECL	AddGaussianNoise(double *p, size_t n, double sigma, double mean);
+void	MISCRAND_CDECL	AddGaussianNoise_r(MiscRandState *pState, double *p, size_t n, double sigma, double mean);
+void	MISCRAND_CDECL	AddGaussianNoiseFloat(float *p, size_t n, float sigma, float mean);
+void	MISCRAND_CDECL	AddGaussianNoiseFloat_r(MiscRandState *pState, float *p, size_t n, float sigma, float mean);
+void	MISCRAND_CDECL	AddGaussianNoiseInt16(short *p, size_t n, float sigma, float mean);
+void	MISCRAND_CDECL	AddGaussianNoiseInt16_r(MiscRandState *pState, short *p, size_t n, float sigma, float mean);
+void	MISCRAND_CDECL	AddGaussianNoiseComplex(double *pIQ, size_t n, double sigma);
+void	MISCRAND_CDECL	AddGaussianNoiseComplex_r(MiscRandState *pState, double *pIQ, size_t n, double sigma);
+void	MISCRAND_CDECL	AddGaussianNoiseComplexFloat(float *pIQ, size_t n, float sigma);
+void	MISCRAND_CDECL	AddGaussianNoiseComplexFloat_r(MiscRandState *pState, float *pIQ, size_t n, float sigma);
+void	MISCRAND_CDECL	AddGaussianNoiseComplexInt16(short *pIQ, size_t n, float sigma);
+void	MISCRAND_CDECL	AddGaussianNoiseComplexInt16_r(MiscRandState *pState, short *pIQ, size_t n, float sigma);
+MiscRandISA	MISCRAND_CDECL	GaussianNoiseISA();
+bool	MISCRAND_CDECL	GaussianNoiseSetISA(MiscRandISA isa);
+
+// Header files from RandStream.cpp
+
+bool	MISCRAND_CDECL	RandStreamWriteFile(const char *pPath, MiscRandStreamType type, unsigned long seed,
+	unsigned long long count);
+RandStream *	MISCRAND_CDECL	RandStreamOpen(const char *pPath, bool bHugePages);
+void	MISCRAND_CDECL	RandStreamClose(RandStream *pStream);
+void	MISCRAND_CDECL	RandStreamInfo(const RandStream *pStream, MiscRandStreamType *pType, unsigned long *pSeed,
+	unsigned long long *pCount);
+const void *	MISCRAND_CDECL	RandStreamView(RandStream *pStream, size_t n, size_t *pNumViewed);
+void	MISCRAND_CDECL	RandStreamFill(RandStream *pStream, void *pOut, size_t n);
+
+// Header files from GaussianInverseCDF.cpp
+
+void	MISCRAND_CDECL	UniformToGaussian(const double *pIn, double *pOut, size_t n);
+double	MISCRAND_CDECL	GaussianRandInv();
+double	MISCRAND_CDECL	GaussianRandInv_r(MiscRandState *pState);
+void	MISCRAND_CDECL	GaussianRandInvFill(double *pOut, size_t n);
+void	MISCRAND_CDECL	GaussianRandInvFill_r(MiscRandState *pState, double *pOut, size_t n);
+MiscRandISA	MISCRAND_CDECL	GaussianRandInvISA();
+bool	MISCRAND_CDECL	GaussianRandInvSetISA(MiscRandISA isa);
+
+// Header files from SobolRand.cpp
+
+SobolRand *	MISCRAND_CDECL	SobolRandCreate(int dim, MiscRandSobolScramble scramble, unsigned long long seed);
+void	MISCRAND_CDECL	SobolRandDestroy(SobolRand *pSobol);
+void	MISCRAND_CDECL	SobolRandSeek(SobolRand *pSobol, unsigned long long index);
+void	MISCRAND_CDECL	SobolRandFill(SobolRand *pSobol, double *pOut, size_t numPoints);
+void	MISCRAND_CDECL	SobolGaussianFill(SobolRand *pSobol, double *pOut, size_t numPoints);
+MiscRandISA	MISCRAND_CDECL	SobolRandISA();
+bool	MISCRAND_CDECL	SobolRandSetISA(MiscRandISA isa);
+
+// Header files from MiscRandCounters.cpp
+
+bool	MISCRAND_CDECL	MiscRandCountersEnabled();
+void	MISCRAND_CDECL	MiscRandCountersSnapshot(MiscRandCounters *pCounters);
+void	MISCRAND_CDECL	MiscRandCountersReset();
@@ -0,0 +1,47 @@
+// MiscRandCounters.cpp keeps the per-thread counters of the instrumented GaussianRandVec() paths, for finding
+// out why the generator is slower on one host than on another: how often results[] is refilled, how many
+// rounds the rejection loops of the kernels take, how many lanes sit those rounds out frozen by the masks of
+// the SIMD kernels, and how the cycles split between the kernels and serving the numbers.
+//
+// The counting is compiled in only with MISCRAND_INSTRUMENTATION defined, e.g. with /D MISCRAND_INSTRUMENTATION
+// in the library project; otherwise the counters stay 0 and the hot paths are what they would be without
+// them.  The time stamp counter reads around every GaussianRandVec() call do cost a few dozen cycles when
+// counting, so serveCycles overstates what an uninstrumented call takes.
+
+#include <string.h>
+#include "MiscRand.h"
+#include "MiscRandCounters.h"
+
+#ifdef MISCRAND_INSTRUMENTATION
+// miscRandCounters is constant-initialized, like defaultState in MiscRandState.cpp.
+thread_local MiscRandCounters	miscRandCounters = { 0, 0, 0, 0, 0, 0, 0 };
+#endif
+
+// MiscRandCountersEnabled() returns true if the library counts, i.e. was built with MISCRAND_INSTRUMENTATION.
+bool	MISCRAND_CDECL	MiscRandCountersEnabled()
+{
+#ifdef MISCRAND_INSTRUMENTATION
+	return true;
+#else
+	return false;
+#endif
+}
+
+// MiscRandCountersSnapshot() copies the counters of the calling thread to *pCounters; all 0 if the library
+//     does not count.  The counters keep running.
+void	MISCRAND_CDECL	MiscRandCountersSnapshot(MiscRandCounters *pCounters)
+{
+#ifdef MISCRAND_INSTRUMENTATION
+	*pCounters = miscRandCounters;
+#else
+	memset(pCounters, 0, sizeof(*pCounters));
+#endif
+}
+
+// MiscRandCountersReset() sets the counters of the calling thread to 0.
+void	MISCRAND_CDECL	MiscRandCountersReset()
+{
+#ifdef MISCRAND_INSTRUMENTATION
+	memset(&miscRandCounters, 0, sizeof(miscRandCounters));
+#endif
+}
@@ -0,0 +1,33 @@
+#pragma once
+// MiscRandCounters.h has the macros the instrumented code paths count with.  It is internal to the library.
+//
+// With MISCRAND_INSTRUMENTATION defined, MISCRAND_COUNT(field, n) adds n to the field of the MiscRandCounters of
+// the calling thread and MISCRAND_TSC() reads the time stamp counter.  Without it, MISCRAND_COUNT() compiles
+// to nothing, its n unevaluated, and MISCRAND_TSC() is 0, so the counting costs nothing.
+
+#include "MiscRand.h"
+
+#ifdef MISCRAND_INSTRUMENTATION
+
+extern thread_local MiscRandCounters	miscRandCounters;
+
+#define MISCRAND_COUNT(field, n)	(miscRandCounters.field += (unsigned long long) (n))
+#define MISCRAND_TSC()				__rdtsc()
+
+#else
+
+#define MISCRAND_COUNT(field, n)	((void) sizeof(n))
+#define MISCRAND_TSC()				0ULL
+
+#endif
+
+// MiscRandCountLanes() returns the number of bits set in the lane mask, without POPCNT, which CPUs with only
+//     SSE4.1 lack.
+static inline int	MiscRandCountLanes(unsigned int mask)
+{
+	int		n = 0;
+
+	for (; mask != 0; mask &= mask - 1)
+		n++;
+	return n;
+}
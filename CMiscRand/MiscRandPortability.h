@@ -0,0 +1,16 @@
+#pragma once
+// MiscRandPortability.h hides what MSVC spells its own way, so the library and its tools also build with
+// GCC and Clang.  MiscRand.h includes it, so every file of the library has it.
+//
+// MISCRAND_CDECL is the calling convention of the API functions: __cdecl with MSVC, which may be told to
+// default to another one, and the only one there is elsewhere.  Alignments are written with the standard
+// alignas, which has to come before static, const and the type.  The intrinsics come from <intrin.h> with
+// MSVC and from <immintrin.h> elsewhere, which has __rdtsc() and RDRAND and RDSEED as well.
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define MISCRAND_CDECL		__cdecl
+#else
+#include <immintrin.h>
+#define MISCRAND_CDECL
+#endif
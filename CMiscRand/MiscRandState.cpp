@@ -0,0 +1,99 @@
+// MiscRandState.cpp initializes MiscRandState and keeps the thread-local MiscRandState used by the
+// functions without the _r suffix.
+
+#include <string.h>
+#include "MiscRand.h"
+
+// The seeds GaussianRandVec() lanes start with if the user does not call sGaussianRandVec().  We used to
+//     keep them in avxRand = _mm256_set_epi32(2000000000, 1000000000, 30000000, 1000000, 30000, 1000, 30, 0).
+static const unsigned int	defaultLaneSeeds[NUM_GAUSSIANRAND_LANES] =
+	{ 0, 30, 1000, 30000, 1000000, 30000000, 1000000000, 2000000000 };
+
+// The seeds GaussianRandVecFloat() lanes start with: the ones above, then the ones above plus 15.
+static const unsigned int	defaultFloatLaneSeeds[NUM_GAUSSIANRANDFLOAT_LANES] =
+	{ 0, 30, 1000, 30000, 1000000, 30000000, 1000000000, 2000000000,
+	  15, 45, 1015, 30015, 1000015, 30000015, 1000000015, 2000000015 };
+
+// defaultState is constant-initialized, so each thread gets its own copy without any run-time
+//     initialization or guard check.  It must match what MiscRandStateInit() sets up.
+static thread_local MiscRandState	defaultState =
+	{ { 0.0 }, { 0.0 }, { 0.0 }, { { 0.0 } }, { 0.0f }, { 0, 30, 1000, 30000, 1000000, 30000000, 1000000000, 2000000000 },
+	  { 0, 30, 1000, 30000, 1000000, 30000000, 1000000000, 2000000000,
+	    15, 45, 1015, 30015, 1000015, 30000015, 1000000015, 2000000015 }, 0, 0, 0, 0, 0, 0 };
+
+// MiscRandStateInit() puts *pState to the same state a thread starts with: LargerRand() seeded with 0,
+//     the GaussianRandVec(), GaussianRandZig() and GaussianRandVecFloat() lanes seeded with the default
+//     seeds and no Gaussian random numbers buffered.
+void	MISCRAND_CDECL	MiscRandStateInit(MiscRandState *pState)
+{
+	memset(pState->results, 0, sizeof(pState->results));
+	memset(pState->zigResults, 0, sizeof(pState->zigResults));
+	memset(pState->compactResults, 0, sizeof(pState->compactResults));
+	memset(pState->stagedPairs, 0, sizeof(pState->stagedPairs));
+	memset(pState->floatResults, 0, sizeof(pState->floatResults));
+	memcpy(pState->laneSeeds, defaultLaneSeeds, sizeof(pState->laneSeeds));
+	memcpy(pState->floatLaneSeeds, defaultFloatLaneSeeds, sizeof(pState->floatLaneSeeds));
+	pState->uLargerRandSeed = 0;
+	pState->numAvailableResults = 0;
+	pState->numAvailableZigResults = 0;
+	pState->numAvailableFloatResults = 0;
+	pState->numAvailableCompactResults = 0;
+	pState->numStagedPairs = 0;
+}
+
+// MiscRandDefaultState() returns the MiscRandState of the calling thread.  It is the state sLargerRand(),
+//     LargerRand(), sGaussianRandVec(), GaussianRandVec(), GaussianRandZig() and their Fill variants work on.
+MiscRandState *	MISCRAND_CDECL	MiscRandDefaultState()
+{
+	return &defaultState;
+}
+
+// SplitStreams() sets up pStates[0], ..., pStates[n - 1] as n streams cut out of one global sequence
+//     starting from seed, for n threads to run one job together.  The period of the linear congruential
+//     generator, 2^32 steps from seed, is cut into NUM_SPLIT_SLICES slices of equal length: LargerRand()
+//     runs in the first slice, the GaussianRandVec() lane i in slice i + 1 and the GaussianRandVecFloat()
+//     lane i in slice NUM_GAUSSIANRAND_LANES + i + 1.  Stream j takes steps j * streamLength, ...,
+//     (j + 1) * streamLength - 1 of every slice, so the streams and the lanes never overlap as long as
+//     none of them takes more than streamLength steps and n * streamLength does not exceed the slice
+//     length.  A streamLength of 0 divides each slice evenly among the n streams.
+//
+//     Calling LargerRand_r() streamLength times on pStates[0], then pStates[1], and so on returns the same
+//     numbers as calling it on pStates[0] of SplitStreams(pStates, 1, seed, 0) throughout, so the same
+//     global sequence comes out no matter how many threads share the job.  The same holds for the steps
+//     each lane takes.  It returns false and changes nothing if n is not positive or the streams would not
+//     fit in a slice.
+bool	MISCRAND_CDECL	SplitStreams(MiscRandState *pStates, int n, unsigned long seed,
+	unsigned long long streamLength)
+{
+	const unsigned long long	sliceLength = (1ULL << 32) / NUM_SPLIT_SLICES;
+
+	if (n <= 0)
+		return false;
+	if (streamLength == 0)
+		streamLength = sliceLength / n;
+	if ((streamLength == 0) || (streamLength > sliceLength / n))
+		return false;
+
+	for (int j = 0; j < n; j++)
+		SplitStreamAt(&pStates[j], seed, j, streamLength);
+	return true;
+}
+
+// SplitStreamAt() sets up *pState as stream streamIndex of the global sequence starting from seed, the same
+//     state SplitStreams() gives pStates[streamIndex], without setting up the streams before it.  It does
+//     not check that the stream fits in a slice: past (2^32 / NUM_SPLIT_SLICES) / streamLength streams, a
+//     stream runs into the slice of the next lane, and the numbers repeat those of an earlier stream there.
+void	MISCRAND_CDECL	SplitStreamAt(MiscRandState *pState, unsigned long seed, unsigned long long streamIndex,
+	unsigned long long streamLength)
+{
+	const unsigned long long	sliceLength = (1ULL << 32) / NUM_SPLIT_SLICES;
+	unsigned long long			uOffset = streamIndex * streamLength;
+
+	MiscRandStateInit(pState);
+	pState->uLargerRandSeed = LargerRandJumpSeed(seed, uOffset);
+	for (int lane = 0; lane < NUM_GAUSSIANRAND_LANES; lane++)
+		pState->laneSeeds[lane] = (unsigned int) LargerRandJumpSeed(seed, (lane + 1) * sliceLength + uOffset);
+	for (int lane = 0; lane < NUM_GAUSSIANRANDFLOAT_LANES; lane++)
+		pState->floatLaneSeeds[lane] = (unsigned int) LargerRandJumpSeed(seed,
+			(NUM_GAUSSIANRAND_LANES + lane + 1) * sliceLength + uOffset);
+}
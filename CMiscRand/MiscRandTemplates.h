@@ -0,0 +1,293 @@
+#pragma once
+// MiscRandTemplates.h is a header-only C++ layer over the generators of this library, for callers that want
+// the hot path inlined into their own code or want to plug the generators into the standard <random>
+// distributions and templated code.
+//
+// Engine<Params, Lanes> runs the linear congruential generator Params describes in Lanes interleaved lanes:
+// lane i holds output i of every group of Lanes consecutive outputs, and all the lanes take Lanes steps at
+// once with the jump constants LcgJumpMap() works out at compile time.  So the sequence does not depend on
+// Lanes; Engine<MsvcLcgParams, Lanes> returns exactly what LargerRand() returns after sLargerRand() with
+// the same seed, whatever Lanes is, and Lanes only decides how wide the loop the compiler unrolls and
+// vectorizes is.  Engine satisfies the UniformRandomBitGenerator requirements, so it works with
+// std::normal_distribution and the like.
+//
+// UniformDistribution<Engine, T> and GaussianDistribution<Engine, T> turn the outputs into numbers the way
+// the C functions do: UniformDistribution<Engine, double> returns what UniformRand() and UniformRandFill()
+// return for the same LargerRand() outputs, and GaussianDistribution runs the Polar form of Box-Muller
+// transform on such uniform numbers.  The C functions in UniformRand.cpp use the functions here for their
+// scalar paths.
+
+#include <math.h>
+#include <string.h>
+#include <stddef.h>
+
+namespace MiscRand
+{
+
+// LcgParams describes the generator x -> Multiplier * x + Increment mod 2^32.
+template <unsigned int Multiplier, unsigned int Increment>
+struct LcgParams
+{
+	static constexpr unsigned int	multiplier() { return Multiplier; }
+	static constexpr unsigned int	increment() { return Increment; }
+};
+
+// MsvcLcgParams is the generator behind rand() of MSVC, LargerRand() and the lanes of GaussianRandVec().
+typedef LcgParams<214013U, 2531011U>	MsvcLcgParams;
+
+// LcgAffine is the affine map x -> multiplier * x + increment mod 2^32.
+struct LcgAffine
+{
+	unsigned int	multiplier;
+	unsigned int	increment;
+};
+
+// LcgJumpMap() returns the map x -> multiplier * x + increment applied k times, by O(log k) squarings as
+//     LargerRandJumpSeed() explains.  It is constexpr, so constant k costs nothing at run time.
+constexpr LcgAffine	LcgJumpMap(unsigned int multiplier, unsigned int increment, unsigned long long k)
+{
+	LcgAffine	acc = { 1U, 0U };				// The map for the steps taken so far
+
+	while (k > 0)
+	{
+		if (k & 1)
+		{
+			acc.multiplier *= multiplier;
+			acc.increment = acc.increment * multiplier + increment;
+		}
+		increment *= multiplier + 1;
+		multiplier *= multiplier;
+		k >>= 1;
+	}
+	return acc;
+}
+
+// LcgStep() returns the state after x for the generator Params.
+template <class Params>
+constexpr unsigned int	LcgStep(unsigned int x)
+{
+	return x * Params::multiplier() + Params::increment();
+}
+
+// UniformDoubleBits() and UniformFloatBits() build x in [1, 2) from generator outputs the way the
+//     UniformRandFill() kernels do: a double takes the upper 26 bits of two outputs as its mantissa, and
+//     a float the upper 23 bits of one.
+inline double	UniformDoubleBits(unsigned int u0, unsigned int u1)
+{
+	unsigned long long	bits = 0x3FF0000000000000ULL | ((unsigned long long) (u0 >> 6) << 26) | (u1 >> 6);
+	double				x;
+
+	memcpy(&x, &bits, sizeof(x));
+	return x;
+}
+
+inline float	UniformFloatBits(unsigned int u)
+{
+	unsigned int	bits = 0x3F800000U | (u >> 9);
+	float			x;
+
+	memcpy(&x, &bits, sizeof(x));
+	return x;
+}
+
+// Engine is the generator Params in Lanes interleaved lanes; see above.  Like MiscRandState, each thread
+//     should own the Engine it generates from.
+template <class Params, int Lanes>
+class Engine
+{
+	static_assert(Lanes > 0, "An Engine needs at least one lane.");
+
+public:
+	typedef unsigned int	result_type;
+
+	static constexpr int			lanes() { return Lanes; }
+	static constexpr result_type	min() { return 0U; }
+	static constexpr result_type	max() { return 0xFFFFFFFFU; }
+
+	// The default seed is 0, the seed MiscRandStateInit() gives LargerRand(), so a default Engine returns
+	//     what LargerRand() returns on a fresh MiscRandState.
+	explicit Engine(result_type s = 0U) { seed(s); }
+
+	// seed() starts the sequence over from s, as sLargerRand(s) does.
+	void	seed(result_type s)
+	{
+		for (int lane = 0; lane < Lanes; lane++)
+		{
+			s = LcgStep<Params>(s);
+			m_lanes[lane] = s;
+		}
+		m_numUsed = 0;
+	}
+
+	// operator() returns the next output, as LargerRand() does.
+	result_type	operator()()
+	{
+		if (m_numUsed == Lanes)
+			Advance();
+		return m_lanes[m_numUsed++];
+	}
+
+	// fill() writes the next n outputs to pOut.  Whole groups of Lanes outputs come straight from the
+	//     unrolled lanes.
+	void	fill(result_type *pOut, size_t n)
+	{
+		while ((n > 0) && (m_numUsed < Lanes))
+		{
+			*pOut++ = m_lanes[m_numUsed++];
+			n--;
+		}
+		while (n >= (size_t) Lanes)
+		{
+			Advance();
+			for (int lane = 0; lane < Lanes; lane++)
+				pOut[lane] = m_lanes[lane];
+			m_numUsed = Lanes;
+			pOut += Lanes;
+			n -= Lanes;
+		}
+		while (n > 0)
+		{
+			*pOut++ = (*this)();
+			n--;
+		}
+	}
+
+	// discard() skips k outputs in O(log k) steps.
+	void	discard(unsigned long long k)
+	{
+		unsigned long long	numLeft = (unsigned long long) (Lanes - m_numUsed);
+		LcgAffine			jump;
+
+		if (k <= numLeft)
+		{
+			m_numUsed += (int) k;
+			return;
+		}
+		// The last output of the group is the state the next group starts from; seed() from that state
+		//     k - numLeft steps on makes the next output the one after the k skipped.
+		jump = LcgJumpMap(Params::multiplier(), Params::increment(), k - numLeft);
+		seed(jump.multiplier * m_lanes[Lanes - 1] + jump.increment);
+	}
+
+	// Two engines are equal if they return the same sequence from now on.  The generator is a bijection,
+	//     so it takes only the next output to tell.
+	bool	operator==(const Engine &other) const { return Next() == other.Next(); }
+	bool	operator!=(const Engine &other) const { return Next() != other.Next(); }
+
+private:
+	// Advance() moves every lane Lanes steps on.  The jump constants are folded at compile time.
+	void	Advance()
+	{
+		constexpr LcgAffine	jump = LcgJumpMap(Params::multiplier(), Params::increment(), (unsigned long long) Lanes);
+
+		for (int lane = 0; lane < Lanes; lane++)
+			m_lanes[lane] = m_lanes[lane] * jump.multiplier + jump.increment;
+		m_numUsed = 0;
+	}
+
+	// Next() returns the next output without taking it.
+	result_type	Next() const
+	{
+		return (m_numUsed < Lanes) ? m_lanes[m_numUsed] : LcgStep<Params>(m_lanes[Lanes - 1]);
+	}
+
+	result_type	m_lanes[Lanes];			// The current group of outputs
+	int			m_numUsed;				// Outputs of the group handed out so far
+};
+
+// UniformDistribution returns T uniformly distributed in [a, b), from the outputs of Engine as
+//     UniformRandFill() builds them: (x - 1) * (b - a) + a with x from UniformDoubleBits() or
+//     UniformFloatBits().  It is specialized for double and float.
+template <class Engine, class T>
+class UniformDistribution;
+
+template <class Engine>
+class UniformDistribution<Engine, double>
+{
+public:
+	typedef double	result_type;
+
+	explicit UniformDistribution(double a = 0.0, double b = 1.0) : m_a(a), m_b(b) {}
+
+	void	reset() {}
+	double	a() const { return m_a; }
+	double	b() const { return m_b; }
+
+	double	operator()(Engine &engine)
+	{
+		unsigned int	u0 = engine();
+		unsigned int	u1 = engine();
+
+		return (UniformDoubleBits(u0, u1) - 1.0) * (m_b - m_a) + m_a;
+	}
+
+private:
+	double	m_a, m_b;
+};
+
+template <class Engine>
+class UniformDistribution<Engine, float>
+{
+public:
+	typedef float	result_type;
+
+	explicit UniformDistribution(float a = 0.0f, float b = 1.0f) : m_a(a), m_b(b) {}
+
+	void	reset() {}
+	float	a() const { return m_a; }
+	float	b() const { return m_b; }
+
+	float	operator()(Engine &engine)
+	{
+		return (UniformFloatBits(engine()) - 1.0f) * (m_b - m_a) + m_a;
+	}
+
+private:
+	float	m_a, m_b;
+};
+
+// GaussianDistribution returns T Gaussian-distributed with the given mean and standard deviation, by the
+//     Polar form of Box-Muller transform on u and v uniform in [-1, 1) from UniformDistribution<Engine, T>.
+//     Each accepted (u, v) pair gives two numbers; the second is kept for the next call until reset().
+template <class Engine, class T>
+class GaussianDistribution
+{
+public:
+	typedef T	result_type;
+
+	explicit GaussianDistribution(T mean = T(0), T stddev = T(1)) : m_mean(mean), m_stddev(stddev), m_bHasNext(false),
+		m_next(T(0)), m_uniform(T(-1), T(1)) {}
+
+	void	reset() { m_bHasNext = false; }
+	T		mean() const { return m_mean; }
+	T		stddev() const { return m_stddev; }
+
+	T		operator()(Engine &engine)
+	{
+		T	u, v, s;
+
+		if (m_bHasNext)
+		{
+			m_bHasNext = false;
+			return m_next * m_stddev + m_mean;
+		}
+		do {
+			u = m_uniform(engine);
+			v = m_uniform(engine);
+			s = u * u + v * v;
+		} while ((s >= T(1)) || (s == T(0)));
+
+		s = (T) sqrt(T(-2) * (T) log(s) / s);
+		m_next = v * s;
+		m_bHasNext = true;
+		return u * s * m_stddev + m_mean;
+	}
+
+private:
+	T		m_mean, m_stddev;
+	bool	m_bHasNext;
+	T		m_next;
+	UniformDistribution<Engine, T>	m_uniform;
+};
+
+}	// namespace MiscRand
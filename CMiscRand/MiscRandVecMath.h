@@ -0,0 +1,345 @@
+#pragma once
+// MiscRandVecMath.h has the library's own SIMD natural logarithm, so that the vectorized generators do not
+// need the Short Vector Math Library (SVML) intrinsics such as _mm512_log_pd(), which only MSVC and ICC
+// ship.  Everything here is static inline and uses nothing beyond the instruction set in its name: AVX512F
+// for the 512-bit functions, AVX2 for the 256-bit ones and SSE2 for the 128-bit ones.
+//
+// The method is the one of fdlibm's __ieee754_log(): x = 2^k * (1 + f) with 1 + f in [sqrt(2)/2, sqrt(2)),
+// s = f / (2 + f), and log(1 + f) = f - f*f/2 + s * (f*f/2 + R(s*s)) with R a minimax polynomial, the
+// degree 7 one of fdlibm for doubles and the degree 4 one of its logf() for floats.  We write no FMA, so all
+// the widths of a type return the same bits.  Measured over 2^24 random inputs in (0, 1), 2^24 random
+// positive normal numbers and the s values the Polar form of Box-Muller transform produces, against a long
+// double reference:
+//
+//     Log512d(), Log256d(), Log128d()                      at most 0.86 ULP
+//     Log512f(), Log256f(), Log128f()                      at most 0.85 ULP
+//     PolarFactor512d(), PolarFactor256d(), ...128d()      at most 2.13 ULP, for s in (0, 1)
+//     PolarFactor512f(), PolarFactor256f(), ...128f()      at most 2.03 ULP, for s in (0, 1)
+//
+// PolarFactor*() trades about one ULP for one division less than sqrt(-2.0 * Log*(s)/s); see
+// PolarFactor512d().  The inputs must be positive, finite and normal; zeros, negatives, infinities, NaNs
+// and subnormals get no special treatment.  The Polar form of Box-Muller transform never produces any of
+// them: its s is at least 1 / 32767^2.
+
+#include <immintrin.h>
+
+// The constants of the double logarithm, from fdlibm.
+#define LOG_LN2_HI				6.93147180369123816490e-01		// The upper bits of log(2), exact times any k
+#define LOG_LN2_LO				1.90821492927058770002e-10		// log(2) - LOG_LN2_HI
+#define LOG_LG1					6.666666666666735130e-01
+#define LOG_LG2					3.999999999940941908e-01
+#define LOG_LG3					2.857142874366239149e-01
+#define LOG_LG4					2.222219843214978396e-01
+#define LOG_LG5					1.818357216161805012e-01
+#define LOG_LG6					1.531383769920937332e-01
+#define LOG_LG7					1.479819860511658591e-01
+#define LOG_SQRTHALF_BITS		0x3fe6a09e00000000LL			// The upper bits of sqrt(2)/2
+#define LOG_REDUCE_SHIFT		(0x3ff0000000000000LL - LOG_SQRTHALF_BITS)
+#define LOG_MANTISSA_MASK		0x000fffffffffffffLL
+#define LOG_TWO52_BITS			0x4330000000000000LL			// 2^52
+#define LOG_TWO52_PLUS_BIAS		(4503599627370496.0 + 1023.0)
+
+// The constants of the float logarithm, from fdlibm's logf().
+#define LOGF_LN2_HI				6.9313812256e-01f
+#define LOGF_LN2_LO				9.0580006145e-06f
+#define LOGF_LG1				0.66666662693f
+#define LOGF_LG2				0.40000972152f
+#define LOGF_LG3				0.28498786688f
+#define LOGF_LG4				0.24279078841f
+#define LOGF_SQRTHALF_BITS		0x3f3504f3						// sqrt(2)/2
+#define LOGF_REDUCE_SHIFT		(0x3f800000 - LOGF_SQRTHALF_BITS)
+#define LOGF_MANTISSA_MASK		0x007fffff
+
+// LogReduce512d() splits x = 2^k * (1 + f) with 1 + f in [sqrt(2)/2, sqrt(2)), returning f and storing k,
+//     as a double, to *pK.
+static inline __m512d	LogReduce512d(__m512d x, __m512d *pK)
+{
+	__m512i	iBits = _mm512_add_epi64(_mm512_castpd_si512(x), _mm512_set1_epi64(LOG_REDUCE_SHIFT));
+	__m512i	iK = _mm512_srli_epi64(iBits, 52);
+
+	// k is small and non-negative here, so it goes to double by planting it in the mantissa of 2^52.
+	*pK = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(iK, _mm512_set1_epi64(LOG_TWO52_BITS))), _mm512_set1_pd(LOG_TWO52_PLUS_BIAS));
+	iBits = _mm512_add_epi64(_mm512_and_si512(iBits, _mm512_set1_epi64(LOG_MANTISSA_MASK)), _mm512_set1_epi64(LOG_SQRTHALF_BITS));
+	return _mm512_sub_pd(_mm512_castsi512_pd(iBits), _mm512_set1_pd(1.0));
+}
+
+// LogFinish512d() returns log(2^k * (1 + f)) given f, k and r = 1 / (2 + f).
+static inline __m512d	LogFinish512d(__m512d f, __m512d k, __m512d r)
+{
+	__m512d	hfsq = _mm512_mul_pd(_mm512_mul_pd(_mm512_set1_pd(0.5), f), f);
+	__m512d	s = _mm512_mul_pd(f, r);
+	__m512d	z = _mm512_mul_pd(s, s);
+	__m512d	w = _mm512_mul_pd(z, z);
+	__m512d	t1 = _mm512_mul_pd(w, _mm512_add_pd(_mm512_set1_pd(LOG_LG2), _mm512_mul_pd(w, _mm512_add_pd(_mm512_set1_pd(LOG_LG4), _mm512_mul_pd(w, _mm512_set1_pd(LOG_LG6))))));
+	__m512d	t2 = _mm512_mul_pd(z, _mm512_add_pd(_mm512_set1_pd(LOG_LG1), _mm512_mul_pd(w, _mm512_add_pd(_mm512_set1_pd(LOG_LG3),
+					_mm512_mul_pd(w, _mm512_add_pd(_mm512_set1_pd(LOG_LG5), _mm512_mul_pd(w, _mm512_set1_pd(LOG_LG7))))))));
+	__m512d	y = _mm512_mul_pd(s, _mm512_add_pd(hfsq, _mm512_add_pd(t2, t1)));
+
+	y = _mm512_add_pd(y, _mm512_mul_pd(k, _mm512_set1_pd(LOG_LN2_LO)));
+	y = _mm512_sub_pd(y, hfsq);
+	y = _mm512_add_pd(y, f);
+	return _mm512_add_pd(y, _mm512_mul_pd(k, _mm512_set1_pd(LOG_LN2_HI)));
+}
+
+// Log512d() returns the natural logarithm of each of the eight doubles in x, all positive, finite and normal.
+static inline __m512d	Log512d(__m512d x)
+{
+	__m512d	k, f = LogReduce512d(x, &k);
+
+	return LogFinish512d(f, k, _mm512_div_pd(_mm512_set1_pd(1.0), _mm512_add_pd(_mm512_set1_pd(2.0), f)));
+}
+
+// PolarFactor512d() returns sqrt(-2.0 * log(s)/s) for each of the eight doubles in s, all in (0, 1).  The two
+//     divisions, 1 / (2 + f) inside the logarithm and 1 / s, share a single one: q = 1 / ((2 + f) * s),
+//     1 / (2 + f) = s * q and 1 / s = (2 + f) * q.
+static inline __m512d	PolarFactor512d(__m512d s)
+{
+	__m512d	k, f = LogReduce512d(s, &k);
+	__m512d	twoPlusF = _mm512_add_pd(_mm512_set1_pd(2.0), f);
+	__m512d	q = _mm512_div_pd(_mm512_set1_pd(1.0), _mm512_mul_pd(twoPlusF, s));
+	__m512d	logS = LogFinish512d(f, k, _mm512_mul_pd(s, q));
+
+	return _mm512_sqrt_pd(_mm512_mul_pd(_mm512_mul_pd(logS, _mm512_mul_pd(twoPlusF, q)), _mm512_set1_pd(-2.0)));
+}
+
+// LogReduce256d() splits x = 2^k * (1 + f) with 1 + f in [sqrt(2)/2, sqrt(2)), returning f and storing k,
+//     as a double, to *pK.
+static inline __m256d	LogReduce256d(__m256d x, __m256d *pK)
+{
+	__m256i	iBits = _mm256_add_epi64(_mm256_castpd_si256(x), _mm256_set1_epi64x(LOG_REDUCE_SHIFT));
+	__m256i	iK = _mm256_srli_epi64(iBits, 52);
+
+	// k is small and non-negative here, so it goes to double by planting it in the mantissa of 2^52.
+	*pK = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(iK, _mm256_set1_epi64x(LOG_TWO52_BITS))), _mm256_set1_pd(LOG_TWO52_PLUS_BIAS));
+	iBits = _mm256_add_epi64(_mm256_and_si256(iBits, _mm256_set1_epi64x(LOG_MANTISSA_MASK)), _mm256_set1_epi64x(LOG_SQRTHALF_BITS));
+	return _mm256_sub_pd(_mm256_castsi256_pd(iBits), _mm256_set1_pd(1.0));
+}
+
+// LogFinish256d() returns log(2^k * (1 + f)) given f, k and r = 1 / (2 + f).
+static inline __m256d	LogFinish256d(__m256d f, __m256d k, __m256d r)
+{
+	__m256d	hfsq = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), f), f);
+	__m256d	s = _mm256_mul_pd(f, r);
+	__m256d	z = _mm256_mul_pd(s, s);
+	__m256d	w = _mm256_mul_pd(z, z);
+	__m256d	t1 = _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LOG_LG2), _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LOG_LG4), _mm256_mul_pd(w, _mm256_set1_pd(LOG_LG6))))));
+	__m256d	t2 = _mm256_mul_pd(z, _mm256_add_pd(_mm256_set1_pd(LOG_LG1), _mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LOG_LG3),
+					_mm256_mul_pd(w, _mm256_add_pd(_mm256_set1_pd(LOG_LG5), _mm256_mul_pd(w, _mm256_set1_pd(LOG_LG7))))))));
+	__m256d	y = _mm256_mul_pd(s, _mm256_add_pd(hfsq, _mm256_add_pd(t2, t1)));
+
+	y = _mm256_add_pd(y, _mm256_mul_pd(k, _mm256_set1_pd(LOG_LN2_LO)));
+	y = _mm256_sub_pd(y, hfsq);
+	y = _mm256_add_pd(y, f);
+	return _mm256_add_pd(y, _mm256_mul_pd(k, _mm256_set1_pd(LOG_LN2_HI)));
+}
+
+// Log256d() returns the natural logarithm of each of the four doubles in x, all positive, finite and normal.
+static inline __m256d	Log256d(__m256d x)
+{
+	__m256d	k, f = LogReduce256d(x, &k);
+
+	return LogFinish256d(f, k, _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_add_pd(_mm256_set1_pd(2.0), f)));
+}
+
+// PolarFactor256d() returns sqrt(-2.0 * log(s)/s) for each of the four doubles in s, all in (0, 1).  The two
+//     divisions, 1 / (2 + f) inside the logarithm and 1 / s, share a single one: q = 1 / ((2 + f) * s),
+//     1 / (2 + f) = s * q and 1 / s = (2 + f) * q.
+static inline __m256d	PolarFactor256d(__m256d s)
+{
+	__m256d	k, f = LogReduce256d(s, &k);
+	__m256d	twoPlusF = _mm256_add_pd(_mm256_set1_pd(2.0), f);
+	__m256d	q = _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_mul_pd(twoPlusF, s));
+	__m256d	logS = LogFinish256d(f, k, _mm256_mul_pd(s, q));
+
+	return _mm256_sqrt_pd(_mm256_mul_pd(_mm256_mul_pd(logS, _mm256_mul_pd(twoPlusF, q)), _mm256_set1_pd(-2.0)));
+}
+
+// LogReduce128d() splits x = 2^k * (1 + f) with 1 + f in [sqrt(2)/2, sqrt(2)), returning f and storing k,
+//     as a double, to *pK.
+static inline __m128d	LogReduce128d(__m128d x, __m128d *pK)
+{
+	__m128i	iBits = _mm_add_epi64(_mm_castpd_si128(x), _mm_set1_epi64x(LOG_REDUCE_SHIFT));
+	__m128i	iK = _mm_srli_epi64(iBits, 52);
+
+	// k is small and non-negative here, so it goes to double by planting it in the mantissa of 2^52.
+	*pK = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(iK, _mm_set1_epi64x(LOG_TWO52_BITS))), _mm_set1_pd(LOG_TWO52_PLUS_BIAS));
+	iBits = _mm_add_epi64(_mm_and_si128(iBits, _mm_set1_epi64x(LOG_MANTISSA_MASK)), _mm_set1_epi64x(LOG_SQRTHALF_BITS));
+	return _mm_sub_pd(_mm_castsi128_pd(iBits), _mm_set1_pd(1.0));
+}
+
+// LogFinish128d() returns log(2^k * (1 + f)) given f, k and r = 1 / (2 + f).
+static inline __m128d	LogFinish128d(__m128d f, __m128d k, __m128d r)
+{
+	__m128d	hfsq = _mm_mul_pd(_mm_mul_pd(_mm_set1_pd(0.5), f), f);
+	__m128d	s = _mm_mul_pd(f, r);
+	__m128d	z = _mm_mul_pd(s, s);
+	__m128d	w = _mm_mul_pd(z, z);
+	__m128d	t1 = _mm_mul_pd(w, _mm_add_pd(_mm_set1_pd(LOG_LG2), _mm_mul_pd(w, _mm_add_pd(_mm_set1_pd(LOG_LG4), _mm_mul_pd(w, _mm_set1_pd(LOG_LG6))))));
+	__m128d	t2 = _mm_mul_pd(z, _mm_add_pd(_mm_set1_pd(LOG_LG1), _mm_mul_pd(w, _mm_add_pd(_mm_set1_pd(LOG_LG3),
+					_mm_mul_pd(w, _mm_add_pd(_mm_set1_pd(LOG_LG5), _mm_mul_pd(w, _mm_set1_pd(LOG_LG7))))))));
+	__m128d	y = _mm_mul_pd(s, _mm_add_pd(hfsq, _mm_add_pd(t2, t1)));
+
+	y = _mm_add_pd(y, _mm_mul_pd(k, _mm_set1_pd(LOG_LN2_LO)));
+	y = _mm_sub_pd(y, hfsq);
+	y = _mm_add_pd(y, f);
+	return _mm_add_pd(y, _mm_mul_pd(k, _mm_set1_pd(LOG_LN2_HI)));
+}
+
+// Log128d() returns the natural logarithm of each of the two doubles in x, all positive, finite and normal.
+static inline __m128d	Log128d(__m128d x)
+{
+	__m128d	k, f = LogReduce128d(x, &k);
+
+	return LogFinish128d(f, k, _mm_div_pd(_mm_set1_pd(1.0), _mm_add_pd(_mm_set1_pd(2.0), f)));
+}
+
+// PolarFactor128d() returns sqrt(-2.0 * log(s)/s) for each of the two doubles in s, all in (0, 1).  The two
+//     divisions, 1 / (2 + f) inside the logarithm and 1 / s, share a single one: q = 1 / ((2 + f) * s),
+//     1 / (2 + f) = s * q and 1 / s = (2 + f) * q.
+static inline __m128d	PolarFactor128d(__m128d s)
+{
+	__m128d	k, f = LogReduce128d(s, &k);
+	__m128d	twoPlusF = _mm_add_pd(_mm_set1_pd(2.0), f);
+	__m128d	q = _mm_div_pd(_mm_set1_pd(1.0), _mm_mul_pd(twoPlusF, s));
+	__m128d	logS = LogFinish128d(f, k, _mm_mul_pd(s, q));
+
+	return _mm_sqrt_pd(_mm_mul_pd(_mm_mul_pd(logS, _mm_mul_pd(twoPlusF, q)), _mm_set1_pd(-2.0)));
+}
+
+// LogReduce512f() is LogReduce512d() for floats.
+static inline __m512	LogReduce512f(__m512 x, __m512 *pK)
+{
+	__m512i	iBits = _mm512_add_epi32(_mm512_castps_si512(x), _mm512_set1_epi32(LOGF_REDUCE_SHIFT));
+
+	*pK = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(iBits, 23), _mm512_set1_epi32(0x7f)));
+	iBits = _mm512_add_epi32(_mm512_and_si512(iBits, _mm512_set1_epi32(LOGF_MANTISSA_MASK)), _mm512_set1_epi32(LOGF_SQRTHALF_BITS));
+	return _mm512_sub_ps(_mm512_castsi512_ps(iBits), _mm512_set1_ps(1.0f));
+}
+
+// LogFinish512f() is LogFinish512d() for floats, with a shorter polynomial.
+static inline __m512	LogFinish512f(__m512 f, __m512 k, __m512 r)
+{
+	__m512	hfsq = _mm512_mul_ps(_mm512_mul_ps(_mm512_set1_ps(0.5f), f), f);
+	__m512	s = _mm512_mul_ps(f, r);
+	__m512	z = _mm512_mul_ps(s, s);
+	__m512	w = _mm512_mul_ps(z, z);
+	__m512	t1 = _mm512_mul_ps(w, _mm512_add_ps(_mm512_set1_ps(LOGF_LG2), _mm512_mul_ps(w, _mm512_set1_ps(LOGF_LG4))));
+	__m512	t2 = _mm512_mul_ps(z, _mm512_add_ps(_mm512_set1_ps(LOGF_LG1), _mm512_mul_ps(w, _mm512_set1_ps(LOGF_LG3))));
+	__m512	y = _mm512_mul_ps(s, _mm512_add_ps(hfsq, _mm512_add_ps(t2, t1)));
+
+	y = _mm512_add_ps(y, _mm512_mul_ps(k, _mm512_set1_ps(LOGF_LN2_LO)));
+	y = _mm512_sub_ps(y, hfsq);
+	y = _mm512_add_ps(y, f);
+	return _mm512_add_ps(y, _mm512_mul_ps(k, _mm512_set1_ps(LOGF_LN2_HI)));
+}
+
+// Log512f() returns the natural logarithm of each of the sixteen floats in x, all positive, finite and normal.
+static inline __m512	Log512f(__m512 x)
+{
+	__m512	k, f = LogReduce512f(x, &k);
+
+	return LogFinish512f(f, k, _mm512_div_ps(_mm512_set1_ps(1.0f), _mm512_add_ps(_mm512_set1_ps(2.0f), f)));
+}
+
+// PolarFactor512f() is PolarFactor512d() for floats.
+static inline __m512	PolarFactor512f(__m512 s)
+{
+	__m512	k, f = LogReduce512f(s, &k);
+	__m512	twoPlusF = _mm512_add_ps(_mm512_set1_ps(2.0f), f);
+	__m512	q = _mm512_div_ps(_mm512_set1_ps(1.0f), _mm512_mul_ps(twoPlusF, s));
+	__m512	logS = LogFinish512f(f, k, _mm512_mul_ps(s, q));
+
+	return _mm512_sqrt_ps(_mm512_mul_ps(_mm512_mul_ps(logS, _mm512_mul_ps(twoPlusF, q)), _mm512_set1_ps(-2.0f)));
+}
+
+// LogReduce256f() is LogReduce256d() for floats.
+static inline __m256	LogReduce256f(__m256 x, __m256 *pK)
+{
+	__m256i	iBits = _mm256_add_epi32(_mm256_castps_si256(x), _mm256_set1_epi32(LOGF_REDUCE_SHIFT));
+
+	*pK = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(iBits, 23), _mm256_set1_epi32(0x7f)));
+	iBits = _mm256_add_epi32(_mm256_and_si256(iBits, _mm256_set1_epi32(LOGF_MANTISSA_MASK)), _mm256_set1_epi32(LOGF_SQRTHALF_BITS));
+	return _mm256_sub_ps(_mm256_castsi256_ps(iBits), _mm256_set1_ps(1.0f));
+}
+
+// LogFinish256f() is LogFinish256d() for floats, with a shorter polynomial.
+static inline __m256	LogFinish256f(__m256 f, __m256 k, __m256 r)
+{
+	__m256	hfsq = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), f), f);
+	__m256	s = _mm256_mul_ps(f, r);
+	__m256	z = _mm256_mul_ps(s, s);
+	__m256	w = _mm256_mul_ps(z, z);
+	__m256	t1 = _mm256_mul_ps(w, _mm256_add_ps(_mm256_set1_ps(LOGF_LG2), _mm256_mul_ps(w, _mm256_set1_ps(LOGF_LG4))));
+	__m256	t2 = _mm256_mul_ps(z, _mm256_add_ps(_mm256_set1_ps(LOGF_LG1), _mm256_mul_ps(w, _mm256_set1_ps(LOGF_LG3))));
+	__m256	y = _mm256_mul_ps(s, _mm256_add_ps(hfsq, _mm256_add_ps(t2, t1)));
+
+	y = _mm256_add_ps(y, _mm256_mul_ps(k, _mm256_set1_ps(LOGF_LN2_LO)));
+	y = _mm256_sub_ps(y, hfsq);
+	y = _mm256_add_ps(y, f);
+	return _mm256_add_ps(y, _mm256_mul_ps(k, _mm256_set1_ps(LOGF_LN2_HI)));
+}
+
+// Log256f() returns the natural logarithm of each of the eight floats in x, all positive, finite and normal.
+static inline __m256	Log256f(__m256 x)
+{
+	__m256	k, f = LogReduce256f(x, &k);
+
+	return LogFinish256f(f, k, _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_add_ps(_mm256_set1_ps(2.0f), f)));
+}
+
+// PolarFactor256f() is PolarFactor256d() for floats.
+static inline __m256	PolarFactor256f(__m256 s)
+{
+	__m256	k, f = LogReduce256f(s, &k);
+	__m256	twoPlusF = _mm256_add_ps(_mm256_set1_ps(2.0f), f);
+	__m256	q = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(twoPlusF, s));
+	__m256	logS = LogFinish256f(f, k, _mm256_mul_ps(s, q));
+
+	return _mm256_sqrt_ps(_mm256_mul_ps(_mm256_mul_ps(logS, _mm256_mul_ps(twoPlusF, q)), _mm256_set1_ps(-2.0f)));
+}
+
+// LogReduce128f() is LogReduce128d() for floats.
+static inline __m128	LogReduce128f(__m128 x, __m128 *pK)
+{
+	__m128i	iBits = _mm_add_epi32(_mm_castps_si128(x), _mm_set1_epi32(LOGF_REDUCE_SHIFT));
+
+	*pK = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(iBits, 23), _mm_set1_epi32(0x7f)));
+	iBits = _mm_add_epi32(_mm_and_si128(iBits, _mm_set1_epi32(LOGF_MANTISSA_MASK)), _mm_set1_epi32(LOGF_SQRTHALF_BITS));
+	return _mm_sub_ps(_mm_castsi128_ps(iBits), _mm_set1_ps(1.0f));
+}
+
+// LogFinish128f() is LogFinish128d() for floats, with a shorter polynomial.
+static inline __m128	LogFinish128f(__m128 f, __m128 k, __m128 r)
+{
+	__m128	hfsq = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), f), f);
+	__m128	s = _mm_mul_ps(f, r);
+	__m128	z = _mm_mul_ps(s, s);
+	__m128	w = _mm_mul_ps(z, z);
+	__m128	t1 = _mm_mul_ps(w, _mm_add_ps(_mm_set1_ps(LOGF_LG2), _mm_mul_ps(w, _mm_set1_ps(LOGF_LG4))));
+	__m128	t2 = _mm_mul_ps(z, _mm_add_ps(_mm_set1_ps(LOGF_LG1), _mm_mul_ps(w, _mm_set1_ps(LOGF_LG3))));
+	__m128	y = _mm_mul_ps(s, _mm_add_ps(hfsq, _mm_add_ps(t2, t1)));
+
+	y = _mm_add_ps(y, _mm_mul_ps(k, _mm_set1_ps(LOGF_LN2_LO)));
+	y = _mm_sub_ps(y, hfsq);
+	y = _mm_add_ps(y, f);
+	return _mm_add_ps(y, _mm_mul_ps(k, _mm_set1_ps(LOGF_LN2_HI)));
+}
+
+// Log128f() returns the natural logarithm of each of the four floats in x, all positive, finite and normal.
+static inline __m128	Log128f(__m128 x)
+{
+	__m128	k, f = LogReduce128f(x, &k);
+
+	return LogFinish128f(f, k, _mm_div_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_set1_ps(2.0f), f)));
+}
+
+// PolarFactor128f() is PolarFactor128d() for floats.
+static inline __m128	PolarFactor128f(__m128 s)
+{
+	__m128	k, f = LogReduce128f(s, &k);
+	__m128	twoPlusF = _mm_add_ps(_mm_set1_ps(2.0f), f);
+	__m128	q = _mm_div_ps(_mm_set1_ps(1.0f), _mm_mul_ps(twoPlusF, s));
+	__m128	logS = LogFinish128f(f, k, _mm_mul_ps(s, q));
+
+	return _mm_sqrt_ps(_mm_mul_ps(_mm_mul_ps(logS, _mm_mul_ps(twoPlusF, q)), _mm_set1_ps(-2.0f)));
+}
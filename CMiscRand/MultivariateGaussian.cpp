@@ -0,0 +1,322 @@
+// MultivariateGaussian.cpp generates correlated Gaussian random vectors: y = L z, where L is the lower
+// triangular Cholesky factor of the wanted covariance matrix and z is a vector of independent Gaussian
+// random numbers from GaussianRandVecFill_r().
+//
+// The vectors are made in batches of NUM_MULTIVARIATE_BATCH.  A batch keeps its normals in a buffer of dim
+// rows of NUM_MULTIVARIATE_BATCH numbers, z[j][v] being coordinate j of vector v, so a SIMD register holds
+// one coordinate of several vectors and the product needs no horizontal sums.  The kernels go through the
+// rows of L a tile at a time and load each z[j] once for all the rows of the tile.  They go from the last
+// row up and write row i of the product over z[i], which no row above it reads, so the batch needs no
+// other buffer.  Up to NUM_MULTIVARIATE_STACK_DIM dimensions the buffer lives on the stack, so a call
+// allocates nothing; only larger ones take it from the heap.  The kernels sum in the same order without
+// fused multiply-adds and return the same numbers bit for bit.
+
+#include <string.h>
+#include <immintrin.h>
+#include "MiscRand.h"
+#include "cpudetect.h"
+
+#define NUM_MULTIVARIATE_BATCH		16			// Vectors generated at a time
+#define NUM_MULTIVARIATE_STACK_DIM	64			// Largest dim whose batch buffer is kept on the stack
+
+// MultivariateGaussianBatch_t replaces pZ[i * NUM_MULTIVARIATE_BATCH + v] by the sum over j <= i of
+//     pL[i * dim + j] * pZ[j * NUM_MULTIVARIATE_BATCH + v].  pZ is aligned on 64 bytes.
+typedef void (*MultivariateGaussianBatch_t)(const double *pL, int dim, double *pZ);
+
+static void	MultivariateGaussianBatchScalar(const double *pL, int dim, double *pZ)
+{
+	for (int i = dim - 1; i >= 0; i--)
+	{
+		const double	*pRow = pL + (size_t) i * dim;
+		double			y[NUM_MULTIVARIATE_BATCH] = { 0 };
+
+		for (int j = 0; j <= i; j++)
+			for (int v = 0; v < NUM_MULTIVARIATE_BATCH; v++)
+				y[v] += pRow[j] * pZ[j * NUM_MULTIVARIATE_BATCH + v];
+		memcpy(&pZ[i * NUM_MULTIVARIATE_BATCH], y, sizeof(y));
+	}
+}
+
+// MultivariateGaussianBatchAVX2() takes tiles of two rows: 2 rows x 4 registers of 4 vectors each.
+static void	MultivariateGaussianBatchAVX2(const double *pL, int dim, double *pZ)
+{
+	int		i1 = dim;
+
+	for (; i1 >= 2; i1 -= 2)
+	{
+		const int		i0 = i1 - 2;
+		const double	*pRow0 = pL + (size_t) i0 * dim, *pRow1 = pRow0 + dim;
+		__m256d			y00 = _mm256_setzero_pd(), y01 = y00, y02 = y00, y03 = y00;
+		__m256d			y10 = y00, y11 = y00, y12 = y00, y13 = y00;
+		int				j;
+
+		for (j = 0; j <= i0; j++)
+		{
+			const double	*pZj = &pZ[j * NUM_MULTIVARIATE_BATCH];
+			__m256d			z0 = _mm256_load_pd(pZj), z1 = _mm256_load_pd(pZj + 4);
+			__m256d			z2 = _mm256_load_pd(pZj + 8), z3 = _mm256_load_pd(pZj + 12);
+			__m256d			l0 = _mm256_broadcast_sd(&pRow0[j]), l1 = _mm256_broadcast_sd(&pRow1[j]);
+
+			y00 = _mm256_add_pd(y00, _mm256_mul_pd(l0, z0));
+			y01 = _mm256_add_pd(y01, _mm256_mul_pd(l0, z1));
+			y02 = _mm256_add_pd(y02, _mm256_mul_pd(l0, z2));
+			y03 = _mm256_add_pd(y03, _mm256_mul_pd(l0, z3));
+			y10 = _mm256_add_pd(y10, _mm256_mul_pd(l1, z0));
+			y11 = _mm256_add_pd(y11, _mm256_mul_pd(l1, z1));
+			y12 = _mm256_add_pd(y12, _mm256_mul_pd(l1, z2));
+			y13 = _mm256_add_pd(y13, _mm256_mul_pd(l1, z3));
+		}
+		// j = i0 + 1 is on the diagonal of the second row only.
+		{
+			const double	*pZj = &pZ[j * NUM_MULTIVARIATE_BATCH];
+			__m256d			l1 = _mm256_broadcast_sd(&pRow1[j]);
+
+			y10 = _mm256_add_pd(y10, _mm256_mul_pd(l1, _mm256_load_pd(pZj)));
+			y11 = _mm256_add_pd(y11, _mm256_mul_pd(l1, _mm256_load_pd(pZj + 4)));
+			y12 = _mm256_add_pd(y12, _mm256_mul_pd(l1, _mm256_load_pd(pZj + 8)));
+			y13 = _mm256_add_pd(y13, _mm256_mul_pd(l1, _mm256_load_pd(pZj + 12)));
+		}
+
+		_mm256_store_pd(&pZ[i0 * NUM_MULTIVARIATE_BATCH], y00);
+		_mm256_store_pd(&pZ[i0 * NUM_MULTIVARIATE_BATCH + 4], y01);
+		_mm256_store_pd(&pZ[i0 * NUM_MULTIVARIATE_BATCH + 8], y02);
+		_mm256_store_pd(&pZ[i0 * NUM_MULTIVARIATE_BATCH + 12], y03);
+		_mm256_store_pd(&pZ[(i0 + 1) * NUM_MULTIVARIATE_BATCH], y10);
+		_mm256_store_pd(&pZ[(i0 + 1) * NUM_MULTIVARIATE_BATCH + 4], y11);
+		_mm256_store_pd(&pZ[(i0 + 1) * NUM_MULTIVARIATE_BATCH + 8], y12);
+		_mm256_store_pd(&pZ[(i0 + 1) * NUM_MULTIVARIATE_BATCH + 12], y13);
+	}
+	// An odd dim leaves row 0, which only has the diagonal.
+	if (i1 == 1)
+	{
+		__m256d		l = _mm256_broadcast_sd(&pL[0]);
+
+		for (int v = 0; v < NUM_MULTIVARIATE_BATCH; v += 4)
+			_mm256_store_pd(&pZ[v], _mm256_add_pd(_mm256_setzero_pd(), _mm256_mul_pd(l, _mm256_load_pd(&pZ[v]))));
+	}
+}
+
+// MultivariateGaussianBatchAVX512() takes tiles of four rows: 4 rows x 2 registers of 8 vectors each.
+static void	MultivariateGaussianBatchAVX512(const double *pL, int dim, double *pZ)
+{
+	int		i1 = dim;
+
+	for (; i1 >= 4; i1 -= 4)
+	{
+		const int		i0 = i1 - 4;
+		const double	*pRow0 = pL + (size_t) i0 * dim, *pRow1 = pRow0 + dim;
+		const double	*pRow2 = pRow1 + dim, *pRow3 = pRow2 + dim;
+		__m512d			y00 = _mm512_setzero_pd(), y01 = y00, y10 = y00, y11 = y00;
+		__m512d			y20 = y00, y21 = y00, y30 = y00, y31 = y00;
+		int				j;
+
+		for (j = 0; j <= i0; j++)
+		{
+			const double	*pZj = &pZ[j * NUM_MULTIVARIATE_BATCH];
+			__m512d			z0 = _mm512_load_pd(pZj), z1 = _mm512_load_pd(pZj + 8);
+			__m512d			l0 = _mm512_set1_pd(pRow0[j]), l1 = _mm512_set1_pd(pRow1[j]);
+			__m512d			l2 = _mm512_set1_pd(pRow2[j]), l3 = _mm512_set1_pd(pRow3[j]);
+
+			y00 = _mm512_add_pd(y00, _mm512_mul_pd(l0, z0));
+			y01 = _mm512_add_pd(y01, _mm512_mul_pd(l0, z1));
+			y10 = _mm512_add_pd(y10, _mm512_mul_pd(l1, z0));
+			y11 = _mm512_add_pd(y11, _mm512_mul_pd(l1, z1));
+			y20 = _mm512_add_pd(y20, _mm512_mul_pd(l2, z0));
+			y21 = _mm512_add_pd(y21, _mm512_mul_pd(l2, z1));
+			y30 = _mm512_add_pd(y30, _mm512_mul_pd(l3, z0));
+			y31 = _mm512_add_pd(y31, _mm512_mul_pd(l3, z1));
+		}
+		// j = i0 + 1, ..., i0 + 3 is the triangle below the diagonal of the tile.
+		for (; j < i1; j++)
+		{
+			const double	*pZj = &pZ[j * NUM_MULTIVARIATE_BATCH];
+			__m512d			z0 = _mm512_load_pd(pZj), z1 = _mm512_load_pd(pZj + 8);
+			__m512d			l3 = _mm512_set1_pd(pRow3[j]);
+
+			if (j <= i0 + 1)
+			{
+				__m512d		l1 = _mm512_set1_pd(pRow1[j]);
+
+				y10 = _mm512_add_pd(y10, _mm512_mul_pd(l1, z0));
+				y11 = _mm512_add_pd(y11, _mm512_mul_pd(l1, z1));
+			}
+			if (j <= i0 + 2)
+			{
+				__m512d		l2 = _mm512_set1_pd(pRow2[j]);
+
+				y20 = _mm512_add_pd(y20, _mm512_mul_pd(l2, z0));
+				y21 = _mm512_add_pd(y21, _mm512_mul_pd(l2, z1));
+			}
+			y30 = _mm512_add_pd(y30, _mm512_mul_pd(l3, z0));
+			y31 = _mm512_add_pd(y31, _mm512_mul_pd(l3, z1));
+		}
+
+		_mm512_store_pd(&pZ[i0 * NUM_MULTIVARIATE_BATCH], y00);
+		_mm512_store_pd(&pZ[i0 * NUM_MULTIVARIATE_BATCH + 8], y01);
+		_mm512_store_pd(&pZ[(i0 + 1) * NUM_MULTIVARIATE_BATCH], y10);
+		_mm512_store_pd(&pZ[(i0 + 1) * NUM_MULTIVARIATE_BATCH + 8], y11);
+		_mm512_store_pd(&pZ[(i0 + 2) * NUM_MULTIVARIATE_BATCH], y20);
+		_mm512_store_pd(&pZ[(i0 + 2) * NUM_MULTIVARIATE_BATCH + 8], y21);
+		_mm512_store_pd(&pZ[(i0 + 3) * NUM_MULTIVARIATE_BATCH], y30);
+		_mm512_store_pd(&pZ[(i0 + 3) * NUM_MULTIVARIATE_BATCH + 8], y31);
+	}
+	// The rows left over at the top, one at a time.
+	for (int i = i1 - 1; i >= 0; i--)
+	{
+		const double	*pRow = pL + (size_t) i * dim;
+		__m512d			y0 = _mm512_setzero_pd(), y1 = y0;
+
+		for (int j = 0; j <= i; j++)
+		{
+			__m512d		l = _mm512_set1_pd(pRow[j]);
+
+			y0 = _mm512_add_pd(y0, _mm512_mul_pd(l, _mm512_load_pd(&pZ[j * NUM_MULTIVARIATE_BATCH])));
+			y1 = _mm512_add_pd(y1, _mm512_mul_pd(l, _mm512_load_pd(&pZ[j * NUM_MULTIVARIATE_BATCH + 8])));
+		}
+		_mm512_store_pd(&pZ[i * NUM_MULTIVARIATE_BATCH], y0);
+		_mm512_store_pd(&pZ[i * NUM_MULTIVARIATE_BATCH + 8], y1);
+	}
+}
+
+// SelectMultivariateGaussianISA() returns the fastest instruction set we have kernels for on the running CPU.
+static MiscRandISA	SelectMultivariateGaussianISA()
+{
+	if (supportAVX512F())
+		return MISCRAND_ISA_AVX512;
+	else if (supportAVX2())
+		return MISCRAND_ISA_AVX2;
+	else
+		return MISCRAND_ISA_SCALAR;
+}
+
+static void	MultivariateGaussianBatchResolve(const double *pL, int dim, double *pZ);
+
+// pMultivariateGaussianBatch and multivariateGaussianISA are bound at startup the same way as
+//     pGaussianRandVecBlock in GaussianRand.cpp.
+static MultivariateGaussianBatch_t	pMultivariateGaussianBatch = MultivariateGaussianBatchResolve;
+static MiscRandISA					multivariateGaussianISA = MISCRAND_ISA_SCALAR;
+static const bool					bMultivariateGaussianBound = MultivariateGaussianSetISA(SelectMultivariateGaussianISA());
+
+static void	MultivariateGaussianBatchResolve(const double *pL, int dim, double *pZ)
+{
+	MultivariateGaussianSetISA(SelectMultivariateGaussianISA());
+	pMultivariateGaussianBatch(pL, dim, pZ);
+}
+
+// MultivariateGaussianISA() returns the instruction set of the kernels MultivariateGaussianFill() uses for
+//     the matrix-vector products; the normals come from the GaussianRandVec() kernels.
+MiscRandISA	MISCRAND_CDECL	MultivariateGaussianISA()
+{
+	if (pMultivariateGaussianBatch == MultivariateGaussianBatchResolve)
+		MultivariateGaussianSetISA(SelectMultivariateGaussianISA());
+	return multivariateGaussianISA;
+}
+
+// MultivariateGaussianSetISA() makes MultivariateGaussianFill() use the kernels for isa.  It returns false
+//     and changes nothing if there are no such kernels or the running CPU does not support isa.  It is not
+//     meant to be called while other threads are generating.
+bool	MISCRAND_CDECL	MultivariateGaussianSetISA(MiscRandISA isa)
+{
+	switch (isa)
+	{
+	case MISCRAND_ISA_AVX512:
+		if (!supportAVX512F())
+			return false;
+		pMultivariateGaussianBatch = MultivariateGaussianBatchAVX512;
+		break;
+	case MISCRAND_ISA_AVX2:
+		if (!supportAVX2())
+			return false;
+		pMultivariateGaussianBatch = MultivariateGaussianBatchAVX2;
+		break;
+	case MISCRAND_ISA_SCALAR:
+		pMultivariateGaussianBatch = MultivariateGaussianBatchScalar;
+		break;
+	default:
+		return false;
+	}
+	multivariateGaussianISA = isa;
+	return true;
+}
+
+// MultivariateGaussianGenerate() makes count vectors and stores coordinate i of vector v at
+//     pOut[v * vectorStride + i * coordStride].  It returns false, leaving pOut as it was, if dim is not
+//     positive or the batch buffer of a dim above NUM_MULTIVARIATE_STACK_DIM cannot be allocated.
+static bool	MultivariateGaussianGenerate(MiscRandState *pState, const double *pL, int dim, size_t count,
+	double *pOut, size_t vectorStride, size_t coordStride)
+{
+	alignas(64) double	stackZ[NUM_MULTIVARIATE_STACK_DIM * NUM_MULTIVARIATE_BATCH];
+	double							*pZ = stackZ;
+
+	if (dim <= 0)
+		return false;
+	if (count == 0)
+		return true;
+	if (dim > NUM_MULTIVARIATE_STACK_DIM)
+	{
+		pZ = (double *) _mm_malloc((size_t) dim * NUM_MULTIVARIATE_BATCH * sizeof(double), 64);
+		if (pZ == NULL)
+			return false;
+	}
+
+	for (size_t v0 = 0; v0 < count; v0 += NUM_MULTIVARIATE_BATCH)
+	{
+		size_t	numVectors = (count - v0 < NUM_MULTIVARIATE_BATCH) ? count - v0 : NUM_MULTIVARIATE_BATCH;
+
+		// The normals of a batch are drawn in the order of z[j][v].  A last, short batch draws only the
+		//     ones it uses and spreads them out to the rows of the buffer, last row first.
+		GaussianRandVecFill_r(pState, pZ, (size_t) dim * numVectors);
+		if (numVectors < NUM_MULTIVARIATE_BATCH)
+			for (int j = dim - 1; j >= 0; j--)
+			{
+				memmove(&pZ[j * NUM_MULTIVARIATE_BATCH], &pZ[j * numVectors], numVectors * sizeof(double));
+				memset(&pZ[j * NUM_MULTIVARIATE_BATCH + numVectors], 0,
+					(NUM_MULTIVARIATE_BATCH - numVectors) * sizeof(double));
+			}
+
+		pMultivariateGaussianBatch(pL, dim, pZ);
+
+		if (vectorStride == 1)
+			for (int i = 0; i < dim; i++)
+				memcpy(&pOut[v0 + i * coordStride], &pZ[i * NUM_MULTIVARIATE_BATCH], numVectors * sizeof(double));
+		else
+			for (size_t v = 0; v < numVectors; v++)
+				for (int i = 0; i < dim; i++)
+					pOut[(v0 + v) * vectorStride + i] = pZ[i * NUM_MULTIVARIATE_BATCH + v];
+	}
+
+	if (pZ != stackZ)
+		_mm_free(pZ);
+	return true;
+}
+
+// MultivariateGaussianFill() fills pOut with count Gaussian random vectors of dimension dim with mean 0 and
+//     covariance L L^T, row-major: coordinate i of vector v is pOut[v * dim + i].  pL is the dim x dim
+//     Cholesky factor, row-major; only the entries on and below the diagonal are read.  The normals are
+//     drawn from the GaussianRandVec() lanes of the calling thread.  It returns false and writes nothing if
+//     dim is not positive or, for dim above NUM_MULTIVARIATE_STACK_DIM, the batch buffer cannot be allocated.
+bool	MISCRAND_CDECL	MultivariateGaussianFill(const double *pL, int dim, size_t count, double *pOut)
+{
+	return MultivariateGaussianFill_r(MiscRandDefaultState(), pL, dim, count, pOut);
+}
+
+// MultivariateGaussianFill_r() is MultivariateGaussianFill() working on *pState.
+bool	MISCRAND_CDECL	MultivariateGaussianFill_r(MiscRandState *pState, const double *pL, int dim, size_t count,
+	double *pOut)
+{
+	return MultivariateGaussianGenerate(pState, pL, dim, count, pOut, dim, 1);
+}
+
+// MultivariateGaussianFillSoA() is MultivariateGaussianFill() storing the vectors as a structure of arrays:
+//     coordinate i of vector v is pOut[i * count + v].  It returns the same vectors, and fails the same way.
+bool	MISCRAND_CDECL	MultivariateGaussianFillSoA(const double *pL, int dim, size_t count, double *pOut)
+{
+	return MultivariateGaussianFillSoA_r(MiscRandDefaultState(), pL, dim, count, pOut);
+}
+
+// MultivariateGaussianFillSoA_r() is MultivariateGaussianFillSoA() working on *pState.
+bool	MISCRAND_CDECL	MultivariateGaussianFillSoA_r(MiscRandState *pState, const double *pL, int dim, size_t count,
+	double *pOut)
+{
+	return MultivariateGaussianGenerate(pState, pL, dim, count, pOut, 1, count);
+}
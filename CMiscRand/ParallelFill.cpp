@@ -0,0 +1,281 @@
+// ParallelFill.cpp fills large arrays with random numbers on several threads at once.  The output is cut
+// into blocks of NUM_PARALLEL_FILL_BLOCK numbers, and block b is generated from its own MiscRandState,
+// stream b of SplitStreamAt() with the given seed.  Since a block depends only on the seed and its index,
+// the array comes out the same no matter how many threads fill it or which thread fills which block.
+//
+// The blocks are handed out by a small work-stealing pool: each thread starts with an even share of
+// consecutive blocks and takes them from the front; a thread that runs out steals the back half of the
+// share of the busiest other thread.  The pool threads are started on first use and kept for later calls.
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "MiscRand.h"
+
+#define NUM_PARALLEL_FILL_BLOCK		65536		// Numbers per block; a multiple of NUM_GAUSSIANRAND_GENERATED
+#define MAX_PARALLEL_FILL_THREADS	256
+
+// ParallelFillBlock_t fills pOut[0], ..., pOut[n - 1] as the first n numbers of block blockIndex.
+typedef void (*ParallelFillBlock_t)(double *pOut, size_t n, unsigned long seed, size_t blockIndex);
+
+// ParallelFillShare keeps the blocks a thread has left, [first, end), packed into one 64-bit word so that
+//     the owner and the thieves can both update it with one compare-and-swap.  A block index never comes
+//     back once taken, so a share cannot go from one value to another and back (no ABA problem).
+typedef struct alignas(64) ParallelFillShare
+{
+	std::atomic<unsigned long long>	range;
+} ParallelFillShare;
+
+// ParallelFillJob describes one ParallelGaussianFill() or ParallelUniformFill() call to the pool.
+typedef struct ParallelFillJob
+{
+	ParallelFillBlock_t	pFillBlock;
+	double				*pOut;
+	size_t				n;
+	unsigned long		seed;
+	int					numThreads;
+	ParallelFillShare	shares[MAX_PARALLEL_FILL_THREADS];
+} ParallelFillJob;
+
+static inline unsigned long long	PackRange(unsigned long long first, unsigned long long end)
+{
+	return first | (end << 32);
+}
+
+// TakeOwnBlock() takes the first block left in *pShare into *pBlock.  It returns false if none is left.
+static bool	TakeOwnBlock(ParallelFillShare *pShare, size_t *pBlock)
+{
+	unsigned long long	range = pShare->range.load(std::memory_order_relaxed);
+
+	for (;;)
+	{
+		unsigned long long	first = range & 0xffffffffULL, end = range >> 32;
+
+		if (first >= end)
+			return false;
+		if (pShare->range.compare_exchange_weak(range, PackRange(first + 1, end), std::memory_order_acq_rel))
+		{
+			*pBlock = (size_t) first;
+			return true;
+		}
+	}
+}
+
+// StealBlocks() moves the back half of the largest share left in the job into pJob->shares[thief].  It
+//     returns false if no share has two blocks left: the owner of a last block is already about to take
+//     it, and stealing nothing would only keep the thief retrying on the owner's cache line.
+static bool	StealBlocks(ParallelFillJob *pJob, int thief)
+{
+	for (;;)
+	{
+		int					victim = -1;
+		unsigned long long	victimRange = 0, victimLeft = 0;
+
+		for (int t = 0; t < pJob->numThreads; t++)
+		{
+			unsigned long long	range = pJob->shares[t].range.load(std::memory_order_acquire);
+			unsigned long long	left = (range >> 32) - (range & 0xffffffffULL);
+
+			if ((t != thief) && ((range >> 32) >= (range & 0xffffffffULL) + 2) && (left > victimLeft))
+			{
+				victim = t;
+				victimRange = range;
+				victimLeft = left;
+			}
+		}
+		if (victim < 0)
+			return false;
+
+		// The victim keeps the front half, including the block it takes next.
+		unsigned long long	first = victimRange & 0xffffffffULL, end = victimRange >> 32;
+		unsigned long long	middle = first + (victimLeft + 1) / 2;
+
+		if (pJob->shares[victim].range.compare_exchange_strong(victimRange, PackRange(first, middle),
+			std::memory_order_acq_rel))
+		{
+			// Our share is empty, so no other thread writes it until we put the stolen blocks there.
+			pJob->shares[thief].range.store(PackRange(middle, end), std::memory_order_release);
+			return true;
+		}
+	}
+}
+
+// RunParallelFillJob() is what each thread of the job runs: its own blocks first, then stolen ones.
+static void	RunParallelFillJob(ParallelFillJob *pJob, int thread)
+{
+	size_t	block;
+
+	do
+	{
+		while (TakeOwnBlock(&pJob->shares[thread], &block))
+		{
+			size_t	first = block * NUM_PARALLEL_FILL_BLOCK;
+			size_t	n = (pJob->n - first < NUM_PARALLEL_FILL_BLOCK) ? pJob->n - first : NUM_PARALLEL_FILL_BLOCK;
+
+			pJob->pFillBlock(pJob->pOut + first, n, pJob->seed, block);
+		}
+	} while (StealBlocks(pJob, thread));
+}
+
+// ParallelFillPool keeps the pool threads.  Thread 0 of a job is always the calling thread, and pool thread
+//     i - 1 runs as thread i.  jobMutex lets one job run at a time; stateMutex guards the rest.
+static struct ParallelFillPool
+{
+	std::mutex					jobMutex;
+	std::mutex					stateMutex;
+	std::condition_variable		wakeUp;
+	std::condition_variable		jobDone;
+	std::vector<std::thread>	threads;
+	ParallelFillJob				*pJob;
+	unsigned long long			generation;
+	int							numRunning;
+	bool						bShutDown;
+
+	~ParallelFillPool()
+	{
+		{
+			std::lock_guard<std::mutex>	lock(stateMutex);
+
+			bShutDown = true;
+		}
+		wakeUp.notify_all();
+		for (std::thread &thread : threads)
+			thread.join();
+	}
+} parallelFillPool;
+
+static void	ParallelFillPoolThread(int thread)
+{
+	unsigned long long	seenGeneration = 0;
+
+	for (;;)
+	{
+		ParallelFillJob	*pJob;
+		int				numThreads;
+
+		{
+			std::unique_lock<std::mutex>	lock(parallelFillPool.stateMutex);
+
+			parallelFillPool.wakeUp.wait(lock, [&] {
+				return parallelFillPool.bShutDown || (parallelFillPool.generation != seenGeneration); });
+			if (parallelFillPool.bShutDown)
+				return;
+			seenGeneration = parallelFillPool.generation;
+			pJob = parallelFillPool.pJob;
+			numThreads = pJob->numThreads;
+		}
+
+		// The threads the job does not need go back to sleep without touching it again.
+		if (thread < numThreads)
+		{
+			RunParallelFillJob(pJob, thread);
+
+			std::lock_guard<std::mutex>	lock(parallelFillPool.stateMutex);
+
+			if (--parallelFillPool.numRunning == 0)
+				parallelFillPool.jobDone.notify_one();
+		}
+	}
+}
+
+// RunParallelFill() cuts pOut into blocks, shares them among numThreads threads and waits for all of them.
+static void	RunParallelFill(ParallelFillBlock_t pFillBlock, double *pOut, size_t n, unsigned long seed, int numThreads)
+{
+	static ParallelFillJob	job;
+	size_t					numBlocks = (n + NUM_PARALLEL_FILL_BLOCK - 1) / NUM_PARALLEL_FILL_BLOCK;
+
+	if (numThreads <= 0)
+		numThreads = (int) std::thread::hardware_concurrency();
+	if (numThreads <= 0)
+		numThreads = 1;
+	if (numThreads > MAX_PARALLEL_FILL_THREADS)
+		numThreads = MAX_PARALLEL_FILL_THREADS;
+	if ((size_t) numThreads > numBlocks)
+		numThreads = (int) numBlocks;
+	if (numThreads <= 1)
+	{
+		for (size_t block = 0; block < numBlocks; block++)
+		{
+			size_t	first = block * NUM_PARALLEL_FILL_BLOCK;
+
+			pFillBlock(pOut + first, (n - first < NUM_PARALLEL_FILL_BLOCK) ? n - first : NUM_PARALLEL_FILL_BLOCK,
+				seed, block);
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex>	jobLock(parallelFillPool.jobMutex);
+
+	{
+		// Pool threads the last job did not need may still be reading job, so we set it up under the lock.
+		std::lock_guard<std::mutex>	lock(parallelFillPool.stateMutex);
+
+		job.pFillBlock = pFillBlock;
+		job.pOut = pOut;
+		job.n = n;
+		job.seed = seed;
+		job.numThreads = numThreads;
+		for (int t = 0; t < numThreads; t++)
+			job.shares[t].range.store(PackRange(numBlocks * t / numThreads, numBlocks * (t + 1) / numThreads),
+				std::memory_order_relaxed);
+		while ((int) parallelFillPool.threads.size() < numThreads - 1)
+			parallelFillPool.threads.emplace_back(ParallelFillPoolThread, (int) parallelFillPool.threads.size() + 1);
+		parallelFillPool.pJob = &job;
+		parallelFillPool.numRunning = numThreads - 1;
+		parallelFillPool.generation++;
+	}
+	parallelFillPool.wakeUp.notify_all();
+
+	RunParallelFillJob(&job, 0);
+
+	std::unique_lock<std::mutex>	lock(parallelFillPool.stateMutex);
+
+	parallelFillPool.jobDone.wait(lock, [] { return parallelFillPool.numRunning == 0; });
+}
+
+// GaussianFillBlock() runs GaussianRandVecFill_r() on the MiscRandState of block blockIndex.  Its lanes take
+//     about 2.6 linear congruential steps per pair of numbers, about a sixth of the NUM_PARALLEL_FILL_BLOCK
+//     steps each stream has.
+static void	GaussianFillBlock(double *pOut, size_t n, unsigned long seed, size_t blockIndex)
+{
+	MiscRandState	state;
+
+	SplitStreamAt(&state, seed, blockIndex, NUM_PARALLEL_FILL_BLOCK);
+	GaussianRandVecFill_r(&state, pOut, n);
+}
+
+// UniformFillBlock() turns the LargerRand_r() outputs of block blockIndex into doubles in [0, 1), one step
+//     per number.
+static void	UniformFillBlock(double *pOut, size_t n, unsigned long seed, size_t blockIndex)
+{
+	MiscRandState	state;
+
+	SplitStreamAt(&state, seed, blockIndex, NUM_PARALLEL_FILL_BLOCK);
+	for (size_t i = 0; i < n; i++)
+		pOut[i] = (unsigned int) LargerRand_r(&state) * (1.0 / 4294967296.0);
+}
+
+// ParallelGaussianFill() fills pOut[0], ..., pOut[n - 1] with Gaussian-distributed random numbers with zero
+//     mean and unit variance, using numThreads threads, or one per logical processor if numThreads is not
+//     positive.  The numbers depend only on seed and n, not on numThreads, and pOut[0], ..., pOut[m - 1]
+//     do not depend on n either for m <= n.  The blocks draw from disjoint parts of the lanes of
+//     GaussianRandVec() for the first (2^32 / NUM_SPLIT_SLICES) / NUM_PARALLEL_FILL_BLOCK blocks, about
+//     1.7e8 numbers; past that, they start repeating parts of the sequences of other lanes.  It leaves the
+//     MiscRandState of the calling thread alone.  Several threads may call it at once, but the pool runs
+//     one job at a time, so calls that need more than one thread take turns.
+void	MISCRAND_CDECL	ParallelGaussianFill(double *pOut, size_t n, unsigned long seed, int numThreads)
+{
+	RunParallelFill(GaussianFillBlock, pOut, n, seed, numThreads);
+}
+
+// ParallelUniformFill() is ParallelGaussianFill() for uniformly distributed random numbers in [0, 1), drawn
+//     from the linear congruential generator behind LargerRand().  Block b returns the LargerRand() outputs
+//     number b * NUM_PARALLEL_FILL_BLOCK onwards of the sequence starting from seed, divided by 2^32, so
+//     the whole array is the first n outputs of sLargerRand(seed) followed by LargerRand() calls, until
+//     it runs out of the first slice of SplitStreams() after about 1.7e8 numbers.
+void	MISCRAND_CDECL	ParallelUniformFill(double *pOut, size_t n, unsigned long seed, int numThreads)
+{
+	RunParallelFill(UniformFillBlock, pOut, n, seed, numThreads);
+}
@@ -0,0 +1,448 @@
+// RandDistributions.cpp generates exponential, gamma and Poisson random numbers in bulk on top of the
+// vectorized generators: the uniform numbers come from UniformRandFillOpen_r() and the Gaussian ones from
+// GaussianRandVecFill_r(), a chunk at a time, and the distributions are computed from the chunks.
+//
+// ExponentialRandFill() is -log(u) / lambda, with the logarithm in the SIMD kernels below.  GammaRandFill()
+// is the method of Marsaglia and Tsang ("A Simple Method for Generating Gamma Variables", ACM Transactions
+// on Mathematical Software, 2000), which accepts more than 95% of its candidates with the squeeze alone.
+// PoissonRandFill() inverts the distribution function for small means and uses the transformed rejection
+// method PTRS of Hoermann ("The transformed rejection method for generating Poisson random variables",
+// Insurance: Mathematics and Economics, 1993) for the others.  TruncatedGaussianFill() picks, for each
+// interval, the proposal of Robert ("Simulation of truncated normal variables", Statistics and Computing,
+// 1995) that accepts the most: the Gaussian numbers themselves, an exponential tail or a uniform number.
+
+#include <math.h>
+#include <immintrin.h>
+#include "MiscRand.h"
+#include "MiscRandVecMath.h"
+#include "cpudetect.h"
+
+#define NUM_DISTRIBUTION_CHUNK		256			// Numbers generated at a time from the uniform and Gaussian generators
+#define POISSON_INVERSION_MAX_MEAN	10.0		// PoissonRandFill() inverts below this mean and runs PTRS above
+#define NUM_POISSON_CDF_TABLE		64			// Enough entries for the distribution function below that mean
+#define POISSON_MAX_MEAN			4.0e9		// Thousands of standard deviations below UINT_MAX
+#define MILLS_RATIO_ASYMPTOTIC		26.0		// MillsRatio() takes the asymptotic series from here on
+
+// NegLogTransform_t replaces p[i] by -log(p[i]) * scale for i < n.  The p[i] are in (0, 1).
+typedef void (*NegLogTransform_t)(double *p, size_t n, double scale);
+
+static void	NegLogTransformScalar(double *p, size_t n, double scale)
+{
+	for (size_t i = 0; i < n; i++)
+		p[i] = -log(p[i]) * scale;
+}
+
+static void	NegLogTransformAVX2(double *p, size_t n, double scale)
+{
+	const __m256d	negScale = _mm256_set1_pd(-scale);
+	size_t			i = 0;
+
+	for (; i + 4 <= n; i += 4)
+		_mm256_storeu_pd(&p[i], _mm256_mul_pd(Log256d(_mm256_loadu_pd(&p[i])), negScale));
+	NegLogTransformScalar(p + i, n - i, scale);
+}
+
+static void	NegLogTransformAVX512(double *p, size_t n, double scale)
+{
+	const __m512d	negScale = _mm512_set1_pd(-scale);
+	size_t			i = 0;
+
+	for (; i + 8 <= n; i += 8)
+		_mm512_storeu_pd(&p[i], _mm512_mul_pd(Log512d(_mm512_loadu_pd(&p[i])), negScale));
+	NegLogTransformScalar(p + i, n - i, scale);
+}
+
+// SelectRandDistributionsISA() returns the fastest instruction set we have kernels for on the running CPU.
+static MiscRandISA	SelectRandDistributionsISA()
+{
+	if (supportAVX512F())
+		return MISCRAND_ISA_AVX512;
+	else if (supportAVX2())
+		return MISCRAND_ISA_AVX2;
+	else
+		return MISCRAND_ISA_SCALAR;
+}
+
+static void	NegLogTransformResolve(double *p, size_t n, double scale);
+
+// pNegLogTransform and randDistributionsISA are bound at startup the same way as pGaussianRandVecBlock in
+//     GaussianRand.cpp.
+static NegLogTransform_t	pNegLogTransform = NegLogTransformResolve;
+static MiscRandISA			randDistributionsISA = MISCRAND_ISA_SCALAR;
+static const bool			bRandDistributionsBound = RandDistributionsSetISA(SelectRandDistributionsISA());
+
+static void	NegLogTransformResolve(double *p, size_t n, double scale)
+{
+	RandDistributionsSetISA(SelectRandDistributionsISA());
+	pNegLogTransform(p, n, scale);
+}
+
+// RandDistributionsISA() returns the instruction set of the kernels ExponentialRandFill() and its siblings
+//     use for themselves; the uniform and Gaussian numbers come from kernels with their own settings.
+MiscRandISA	MISCRAND_CDECL	RandDistributionsISA()
+{
+	if (pNegLogTransform == NegLogTransformResolve)
+		RandDistributionsSetISA(SelectRandDistributionsISA());
+	return randDistributionsISA;
+}
+
+// RandDistributionsSetISA() makes ExponentialRandFill() and its siblings use the kernels for isa.  It
+//     returns false and changes nothing if there are no such kernels or the running CPU does not support
+//     isa.  It is not meant to be called while other threads are generating.
+bool	MISCRAND_CDECL	RandDistributionsSetISA(MiscRandISA isa)
+{
+	switch (isa)
+	{
+	case MISCRAND_ISA_AVX512:
+		if (!supportAVX512F())
+			return false;
+		pNegLogTransform = NegLogTransformAVX512;
+		break;
+	case MISCRAND_ISA_AVX2:
+		if (!supportAVX2())
+			return false;
+		pNegLogTransform = NegLogTransformAVX2;
+		break;
+	case MISCRAND_ISA_SCALAR:
+		pNegLogTransform = NegLogTransformScalar;
+		break;
+	default:
+		return false;
+	}
+	randDistributionsISA = isa;
+	return true;
+}
+
+// ExponentialRandFill() fills pOut[0], ..., pOut[n - 1] with exponentially distributed random numbers with
+//     rate lambda, i.e. mean 1 / lambda, drawing from the LargerRand() generator of the calling thread.
+//     lambda must be positive.  pOut does not need to be aligned.
+void	MISCRAND_CDECL	ExponentialRandFill(double *pOut, size_t n, double lambda)
+{
+	ExponentialRandFill_r(MiscRandDefaultState(), pOut, n, lambda);
+}
+
+// ExponentialRandFill_r() is ExponentialRandFill() working on *pState.  The uniform numbers are written
+//     straight into pOut and transformed in place, a chunk at a time so that they are still in cache.
+void	MISCRAND_CDECL	ExponentialRandFill_r(MiscRandState *pState, double *pOut, size_t n, double lambda)
+{
+	while (n > 0)
+	{
+		size_t	m = (n < NUM_DISTRIBUTION_CHUNK) ? n : NUM_DISTRIBUTION_CHUNK;
+
+		UniformRandFillOpen_r(pState, pOut, m, 0.0, 1.0);
+		pNegLogTransform(pOut, m, 1.0 / lambda);
+		pOut += m;
+		n -= m;
+	}
+}
+
+// GammaRandFill() fills pOut[0], ..., pOut[n - 1] with gamma-distributed random numbers with the given
+//     shape and scale, i.e. mean shape * scale, drawing from the GaussianRandVec() lanes and the LargerRand()
+//     generator of the calling thread.  shape and scale must be positive.  For shape < 1, a gamma number
+//     of shape + 1 is multiplied by u^(1 / shape) with u uniform, as Marsaglia and Tsang suggest.
+void	MISCRAND_CDECL	GammaRandFill(double *pOut, size_t n, double shape, double scale)
+{
+	GammaRandFill_r(MiscRandDefaultState(), pOut, n, shape, scale);
+}
+
+// GammaRandFill_r() is GammaRandFill() working on *pState.  Each round draws one Gaussian and one uniform
+//     number per number still missing, up to NUM_DISTRIBUTION_CHUNK, and keeps the accepted candidates in
+//     order.
+void	MISCRAND_CDECL	GammaRandFill_r(MiscRandState *pState, double *pOut, size_t n, double shape, double scale)
+{
+	alignas(64) double	x[NUM_DISTRIBUTION_CHUNK];
+	alignas(64) double	u[NUM_DISTRIBUTION_CHUNK];
+	const double	alpha = (shape < 1.0) ? shape + 1.0 : shape;
+	const double	d = alpha - 1.0 / 3.0;
+	const double	c = 1.0 / sqrt(9.0 * d);
+	double			*pNext = pOut;
+	size_t			numLeft = n;
+
+	while (numLeft > 0)
+	{
+		size_t	m = (numLeft < NUM_DISTRIBUTION_CHUNK) ? numLeft : NUM_DISTRIBUTION_CHUNK;
+
+		GaussianRandVecFill_r(pState, x, m);
+		UniformRandFillOpen_r(pState, u, m, 0.0, 1.0);
+		for (size_t i = 0; i < m; i++)
+		{
+			double	t = 1.0 + c * x[i];
+			double	v, xx;
+
+			if (t <= 0.0)
+				continue;
+			v = t * t * t;
+			xx = x[i] * x[i];
+			// The squeeze accepts most candidates without a logarithm.
+			if ((u[i] < 1.0 - 0.0331 * xx * xx) || (log(u[i]) < 0.5 * xx + d * (1.0 - v + log(v))))
+			{
+				*pNext++ = d * v * scale;
+				numLeft--;
+			}
+		}
+	}
+
+	if (shape < 1.0)
+	{
+		for (size_t done = 0; done < n; done += NUM_DISTRIBUTION_CHUNK)
+		{
+			size_t	m = (n - done < NUM_DISTRIBUTION_CHUNK) ? n - done : NUM_DISTRIBUTION_CHUNK;
+
+			// u^(1 / shape) = exp(-(-log(u)) / shape).
+			UniformRandFillOpen_r(pState, u, m, 0.0, 1.0);
+			pNegLogTransform(u, m, 1.0 / shape);
+			for (size_t i = 0; i < m; i++)
+				pOut[done + i] *= exp(-u[i]);
+		}
+	}
+}
+
+// PoissonRandFill() fills pOut[0], ..., pOut[n - 1] with Poisson-distributed random numbers with mean
+//     lambda, drawing from the LargerRand() generator of the calling thread.  It returns false and writes
+//     nothing unless 0 <= lambda <= POISSON_MAX_MEAN, past which the numbers could overflow an unsigned int;
+//     a NaN lambda would make PTRS reject every try.  Below a mean of POISSON_INVERSION_MAX_MEAN, each
+//     number takes one uniform number and a search of a table of the distribution function from 0; above
+//     it, PTRS takes two uniform numbers per try and accepts about 90% of its tries without computing
+//     lgamma().
+bool	MISCRAND_CDECL	PoissonRandFill(unsigned int *pOut, size_t n, double lambda)
+{
+	return PoissonRandFill_r(MiscRandDefaultState(), pOut, n, lambda);
+}
+
+// PoissonRandFill_r() is PoissonRandFill() working on *pState.
+bool	MISCRAND_CDECL	PoissonRandFill_r(MiscRandState *pState, unsigned int *pOut, size_t n, double lambda)
+{
+	alignas(64) double	u[NUM_DISTRIBUTION_CHUNK];
+
+	if (!((lambda >= 0.0) && (lambda <= POISSON_MAX_MEAN)))
+		return false;
+
+	if (lambda < POISSON_INVERSION_MAX_MEAN)
+	{
+		double	cdf[NUM_POISSON_CDF_TABLE];
+		double	p = exp(-lambda);
+		int		numEntries = 1;
+
+		// cdf[k] is P(X <= k).  The terms shrink fast past lambda, and the table ends where they no longer
+		//     change the sum; rounding has left it a hair below 1 then, and a u in that hair gets the last k.
+		cdf[0] = p;
+		while ((numEntries < NUM_POISSON_CDF_TABLE)
+			&& (cdf[numEntries - 1] + p * lambda / numEntries > cdf[numEntries - 1]))
+		{
+			p *= lambda / numEntries;
+			cdf[numEntries] = cdf[numEntries - 1] + p;
+			numEntries++;
+		}
+
+		while (n > 0)
+		{
+			size_t	m = (n < NUM_DISTRIBUTION_CHUNK) ? n : NUM_DISTRIBUTION_CHUNK;
+
+			UniformRandFill_r(pState, u, m, 0.0, 1.0);
+			for (size_t i = 0; i < m; i++)
+			{
+				int	k = 0;
+
+				while ((k < numEntries - 1) && (u[i] >= cdf[k]))
+					k++;
+				*pOut++ = (unsigned int) k;
+			}
+			n -= m;
+		}
+		return true;
+	}
+
+	// The constants of PTRS, from the paper.
+	const double	sqrtLambda = sqrt(lambda), logLambda = log(lambda);
+	const double	b = 0.931 + 2.53 * sqrtLambda;
+	const double	a = -0.059 + 0.02483 * b;
+	const double	logInvAlpha = log(1.1239 + 1.1328 / (b - 3.4));
+	const double	vr = 0.9277 - 3.6224 / (b - 2.0);
+
+	while (n > 0)
+	{
+		// Each try takes u[2 * i] as U + 1/2 and u[2 * i + 1] as V.
+		size_t	numTries = (2 * n < NUM_DISTRIBUTION_CHUNK) ? n : NUM_DISTRIBUTION_CHUNK / 2;
+
+		UniformRandFillOpen_r(pState, u, 2 * numTries, 0.0, 1.0);
+		for (size_t i = 0; (i < numTries) && (n > 0); i++)
+		{
+			double	us, k;
+			double	U = u[2 * i] - 0.5, V = u[2 * i + 1];
+
+			us = 0.5 - fabs(U);
+			k = floor((2.0 * a / us + b) * U + lambda + 0.43);
+			if ((us >= 0.07) && (V <= vr))
+			{
+				*pOut++ = (unsigned int) k;
+				n--;
+				continue;
+			}
+			if ((k < 0.0) || ((us < 0.013) && (V > us)))
+				continue;
+			if (log(V) + logInvAlpha - log(a / (us * us) + b) <= -lambda + k * logLambda - lgamma(k + 1.0))
+			{
+				*pOut++ = (unsigned int) k;
+				n--;
+			}
+		}
+	}
+	return true;
+}
+
+// TruncatedGaussianMethod names the proposals TruncatedGaussianFill_r() chooses from.
+typedef enum TruncatedGaussianMethod
+{
+	TRUNCATED_GAUSSIAN_REJECTION = 0,		// GaussianRandVec() numbers, kept if they fall in [a, b]
+	TRUNCATED_GAUSSIAN_EXPONENTIAL,			// a + an exponential number of rate alpha, for the tail above a >= 0
+	TRUNCATED_GAUSSIAN_UNIFORM				// Uniform numbers in [a, b]
+} TruncatedGaussianMethod;
+
+// MillsRatio() returns P(X > x) / phi(x) for a standard normal X with density phi, for x >= 0.  Past
+//     MILLS_RATIO_ASYMPTOTIC, where erfc() underflows, it sums the first terms of the asymptotic series
+//     1/x - 1/x^3 + 3/x^5 - 15/x^7.
+static double	MillsRatio(double x)
+{
+	if (x < MILLS_RATIO_ASYMPTOTIC)
+		return 1.2533141373155002512 * erfc(x * 0.70710678118654752440) * exp(0.5 * x * x);
+	else
+	{
+		double	r = 1.0 / (x * x);
+
+		return (1.0 - r * (1.0 - r * (3.0 - 15.0 * r))) / x;
+	}
+}
+
+// TruncatedGaussianFill() fills pOut[0], ..., pOut[n - 1] with standard Gaussian random numbers conditioned
+//     on lying in [a, b], drawing from the GaussianRandVec() lanes and the LargerRand() generator of the
+//     calling thread.  a must be less than b; either may be -HUGE_VAL or HUGE_VAL.  If a is not less than b,
+//     or either is a NaN, there is nothing to draw from and pOut gets n NaNs.  pOut does not need to be
+//     aligned.
+void	MISCRAND_CDECL	TruncatedGaussianFill(double *pOut, size_t n, double a, double b)
+{
+	TruncatedGaussianFill_r(MiscRandDefaultState(), pOut, n, a, b);
+}
+
+// TruncatedGaussianFill_r() is TruncatedGaussianFill() working on *pState.  An interval at or below 0 is
+//     mirrored to [-b, -a] and the numbers negated, so the tails are always above lo >= 0.  The three
+//     proposals each take about two uniform numbers and one or two of the vectorized logarithms per
+//     candidate, so the one with the highest acceptance rate wins:
+//     - rejection accepts P(lo <= X <= hi), which wins for wide intervals around the mean;
+//     - the exponential proposal with the optimal rate alpha = (lo + sqrt(lo^2 + 4)) / 2 of Robert accepts
+//       a candidate z with probability exp(-(z - alpha)^2 / 2), which wins in the tails;
+//     - the uniform proposal accepts z with probability exp((c^2 - z^2) / 2), c being lo or 0, whichever
+//       is the smallest |z| in the interval, which wins for narrow intervals.
+//     Each round draws about as many candidates as the acceptance rate says are needed, up to
+//     NUM_DISTRIBUTION_CHUNK.  The acceptance tests compare -log(u), from the SIMD kernels, with no exp(), and
+//     every candidate is stored, the output pointer moving on only past the accepted ones, so that the
+//     acceptance rates in between 0 and 1 cost no mispredicted branches.
+void	MISCRAND_CDECL	TruncatedGaussianFill_r(MiscRandState *pState, double *pOut, size_t n, double a, double b)
+{
+	alignas(64) double	x[NUM_DISTRIBUTION_CHUNK];
+	alignas(64) double	w[NUM_DISTRIBUTION_CHUNK];
+	const double			sqrt2Pi = 2.5066282746310005024;
+	const bool				bMirrored = (b <= 0.0);
+	const double			lo = bMirrored ? -b : a, hi = bMirrored ? -a : b;
+	const double			sign = bMirrored ? -1.0 : 1.0;
+	double					alpha = 0.0, c2 = 0.0;
+	double					rejectionRate, exponentialRate = 0.0, uniformRate, rate;
+	TruncatedGaussianMethod	method;
+
+	// An empty interval would never accept a candidate, and NaN bounds would make every rate NaN.
+	if (!(a < b))
+	{
+		for (size_t i = 0; i < n; i++)
+			pOut[i] = NAN;
+		return;
+	}
+
+	// Past about 1.3e154, lo^2 overflows, and alpha and the rates with it.  The numbers would be lo + E / lo
+	//     for an exponential E, and E / lo is far below half a unit in the last place of lo, so they are all lo.
+	if (lo * lo == HUGE_VAL)
+	{
+		for (size_t i = 0; i < n; i++)
+			pOut[i] = sign * lo;
+		return;
+	}
+
+	if (lo >= 0.0)
+	{
+		// tail = P(lo <= X <= hi) / phi(lo).
+		double	tail = MillsRatio(lo) - ((hi == HUGE_VAL) ? 0.0 : MillsRatio(hi) * exp(0.5 * (lo - hi) * (lo + hi)));
+
+		alpha = 0.5 * (lo + sqrt(lo * lo + 4.0));
+		c2 = lo * lo;
+		rejectionRate = tail * exp(-0.5 * c2) / sqrt2Pi;
+		exponentialRate = tail * alpha * exp(-0.5 * (alpha - lo) * (alpha - lo));
+		uniformRate = tail / (hi - lo);
+	}
+	else
+	{
+		rejectionRate = 1.0 - 0.5 * erfc(hi * 0.70710678118654752440) - 0.5 * erfc(-lo * 0.70710678118654752440);
+		uniformRate = rejectionRate * sqrt2Pi / (hi - lo);
+	}
+
+	method = TRUNCATED_GAUSSIAN_REJECTION;
+	rate = rejectionRate;
+	if (exponentialRate > rate)
+	{
+		method = TRUNCATED_GAUSSIAN_EXPONENTIAL;
+		rate = exponentialRate;
+	}
+	if ((uniformRate > rate) || !(rate > 0.0))
+	{
+		// An interval too narrow for the rates to come out of the rounding has the uniform proposal accept
+		//     nearly every candidate.
+		method = TRUNCATED_GAUSSIAN_UNIFORM;
+		rate = (uniformRate > 0.0) ? uniformRate : 1.0;
+	}
+
+	while (n > 0)
+	{
+		double	wanted = n / rate + 1.0;
+		size_t	m = (wanted < NUM_DISTRIBUTION_CHUNK) ? (size_t) wanted : NUM_DISTRIBUTION_CHUNK;
+
+		switch (method)
+		{
+		case TRUNCATED_GAUSSIAN_REJECTION:
+			GaussianRandVecFill_r(pState, x, m);
+			for (size_t i = 0; (i < m) && (n > 0); i++)
+			{
+				size_t	bAccepted = (x[i] >= lo) & (x[i] <= hi);
+
+				*pOut = sign * x[i];
+				pOut += bAccepted;
+				n -= bAccepted;
+			}
+			break;
+		case TRUNCATED_GAUSSIAN_EXPONENTIAL:
+			UniformRandFillOpen_r(pState, x, m, 0.0, 1.0);
+			pNegLogTransform(x, m, 1.0 / alpha);
+			UniformRandFillOpen_r(pState, w, m, 0.0, 1.0);
+			pNegLogTransform(w, m, 2.0);
+			for (size_t i = 0; (i < m) && (n > 0); i++)
+			{
+				double	z = lo + x[i];
+				size_t	bAccepted = (z <= hi) & (w[i] >= (z - alpha) * (z - alpha));
+
+				*pOut = sign * z;
+				pOut += bAccepted;
+				n -= bAccepted;
+			}
+			break;
+		default:
+			UniformRandFillOpen_r(pState, x, m, lo, hi);
+			UniformRandFillOpen_r(pState, w, m, 0.0, 1.0);
+			pNegLogTransform(w, m, 2.0);
+			for (size_t i = 0; (i < m) && (n > 0); i++)
+			{
+				size_t	bAccepted = (w[i] >= x[i] * x[i] - c2);
+
+				*pOut = sign * x[i];
+				pOut += bAccepted;
+				n -= bAccepted;
+			}
+			break;
+		}
+	}
+}
@@ -0,0 +1,407 @@
+// RandEngineKernels.cpp implements the kernels declared in RandEngineKernels.h for xoshiro256** (Blackman
+// and Vigna, http://prng.di.unimi.it/), PCG64 in its XSL-RR 128/64 variant (O'Neill, https://www.pcg-random.org/)
+// and Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC11).  The AVX2 kernels
+// run lanes 0-3 and lanes 4-7 in two __m256i, and the AVX512 kernels all eight lanes in one __m512i; none
+// of them needs AVX512DQ, so the 64-bit multiplications are built out of 32-bit ones.
+
+#include <immintrin.h>
+#include "MiscRand.h"
+#include "RandEngineKernels.h"
+
+// ----- xoshiro256** -----
+
+void	XoshiroBlocksScalar(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks)
+{
+	for (size_t b = 0; b < numBlocks; b++)
+	{
+		for (int step = 0; step < NUM_ENGINE_BLOCK / NUM_ENGINE_LANES; step++)
+		{
+			for (int lane = 0; lane < NUM_ENGINE_LANES; lane++)
+			{
+				unsigned long long	*s0 = &pEngine->lanes[0][lane], *s1 = &pEngine->lanes[1][lane];
+				unsigned long long	*s2 = &pEngine->lanes[2][lane], *s3 = &pEngine->lanes[3][lane];
+				unsigned long long	t = *s1 << 17;
+
+				*pOut++ = Rotl64(*s1 * 5, 7) * 9;
+				*s2 ^= *s0;
+				*s3 ^= *s1;
+				*s1 ^= *s2;
+				*s0 ^= *s3;
+				*s2 ^= t;
+				*s3 = Rotl64(*s3, 45);
+			}
+		}
+	}
+}
+
+void	XoshiroBlocksAVX2(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks)
+{
+	__m256i	s0[2], s1[2], s2[2], s3[2], t, r;
+
+	for (int h = 0; h < 2; h++)
+	{
+		s0[h] = _mm256_loadu_si256((const __m256i *) &pEngine->lanes[0][4 * h]);
+		s1[h] = _mm256_loadu_si256((const __m256i *) &pEngine->lanes[1][4 * h]);
+		s2[h] = _mm256_loadu_si256((const __m256i *) &pEngine->lanes[2][4 * h]);
+		s3[h] = _mm256_loadu_si256((const __m256i *) &pEngine->lanes[3][4 * h]);
+	}
+
+	for (size_t b = 0; b < numBlocks; b++)
+	{
+		for (int step = 0; step < NUM_ENGINE_BLOCK / NUM_ENGINE_LANES; step++)
+		{
+			for (int h = 0; h < 2; h++)
+			{
+				// rotl(s1 * 5, 7) * 9, with x * 5 = (x << 2) + x and x * 9 = (x << 3) + x.
+				r = _mm256_add_epi64(_mm256_slli_epi64(s1[h], 2), s1[h]);
+				r = _mm256_or_si256(_mm256_slli_epi64(r, 7), _mm256_srli_epi64(r, 57));
+				r = _mm256_add_epi64(_mm256_slli_epi64(r, 3), r);
+				_mm256_storeu_si256((__m256i *) (pOut + 4 * h), r);
+
+				t = _mm256_slli_epi64(s1[h], 17);
+				s2[h] = _mm256_xor_si256(s2[h], s0[h]);
+				s3[h] = _mm256_xor_si256(s3[h], s1[h]);
+				s1[h] = _mm256_xor_si256(s1[h], s2[h]);
+				s0[h] = _mm256_xor_si256(s0[h], s3[h]);
+				s2[h] = _mm256_xor_si256(s2[h], t);
+				s3[h] = _mm256_or_si256(_mm256_slli_epi64(s3[h], 45), _mm256_srli_epi64(s3[h], 19));
+			}
+			pOut += NUM_ENGINE_LANES;
+		}
+	}
+
+	for (int h = 0; h < 2; h++)
+	{
+		_mm256_storeu_si256((__m256i *) &pEngine->lanes[0][4 * h], s0[h]);
+		_mm256_storeu_si256((__m256i *) &pEngine->lanes[1][4 * h], s1[h]);
+		_mm256_storeu_si256((__m256i *) &pEngine->lanes[2][4 * h], s2[h]);
+		_mm256_storeu_si256((__m256i *) &pEngine->lanes[3][4 * h], s3[h]);
+	}
+}
+
+void	XoshiroBlocksAVX512(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks)
+{
+	__m512i	s0 = _mm512_loadu_si512(pEngine->lanes[0]);
+	__m512i	s1 = _mm512_loadu_si512(pEngine->lanes[1]);
+	__m512i	s2 = _mm512_loadu_si512(pEngine->lanes[2]);
+	__m512i	s3 = _mm512_loadu_si512(pEngine->lanes[3]);
+	__m512i	t, r;
+
+	for (size_t b = 0; b < numBlocks; b++)
+	{
+		for (int step = 0; step < NUM_ENGINE_BLOCK / NUM_ENGINE_LANES; step++)
+		{
+			// rotl(s1 * 5, 7) * 9, with x * 5 = (x << 2) + x and x * 9 = (x << 3) + x.
+			r = _mm512_add_epi64(_mm512_slli_epi64(s1, 2), s1);
+			r = _mm512_rol_epi64(r, 7);
+			r = _mm512_add_epi64(_mm512_slli_epi64(r, 3), r);
+			_mm512_storeu_si512(pOut, r);
+
+			t = _mm512_slli_epi64(s1, 17);
+			s2 = _mm512_xor_si512(s2, s0);
+			s3 = _mm512_xor_si512(s3, s1);
+			s1 = _mm512_xor_si512(s1, s2);
+			s0 = _mm512_xor_si512(s0, s3);
+			s2 = _mm512_xor_si512(s2, t);
+			s3 = _mm512_rol_epi64(s3, 45);
+			pOut += NUM_ENGINE_LANES;
+		}
+	}
+
+	_mm512_storeu_si512(pEngine->lanes[0], s0);
+	_mm512_storeu_si512(pEngine->lanes[1], s1);
+	_mm512_storeu_si512(pEngine->lanes[2], s2);
+	_mm512_storeu_si512(pEngine->lanes[3], s3);
+}
+
+// ----- PCG64 -----
+// Each lane keeps its 128-bit state in lanes[0] (low) and lanes[1] (high), and its 128-bit increment in
+//     lanes[2] and lanes[3].  A step is state = state * PCG64_MULTIPLIER + increment, and the output is
+//     the XSL-RR permutation of the new state: rotr64(high ^ low, high >> 58).
+
+void	PCG64BlocksScalar(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks)
+{
+	for (size_t b = 0; b < numBlocks; b++)
+	{
+		for (int step = 0; step < NUM_ENGINE_BLOCK / NUM_ENGINE_LANES; step++)
+		{
+			for (int lane = 0; lane < NUM_ENGINE_LANES; lane++)
+			{
+				unsigned long long	lo = pEngine->lanes[0][lane], hi = pEngine->lanes[1][lane];
+				unsigned long long	newHi, newLo, x;
+				int					rot;
+
+				newLo = Mul64(lo, PCG64_MULTIPLIER_LO, &newHi);
+				newHi += lo * PCG64_MULTIPLIER_HI + hi * PCG64_MULTIPLIER_LO;
+				lo = newLo + pEngine->lanes[2][lane];
+				hi = newHi + pEngine->lanes[3][lane] + (lo < newLo);
+				pEngine->lanes[0][lane] = lo;
+				pEngine->lanes[1][lane] = hi;
+
+				x = hi ^ lo;
+				rot = (int) (hi >> 58);
+				*pOut++ = (x >> rot) | (x << ((64 - rot) & 63));
+			}
+		}
+	}
+}
+
+// Mul64AVX2() is Mul64() in four 64-bit lanes, with b split into b0 (lower 32 bits) and b1 (upper 32 bits).
+static inline __m256i	Mul64AVX2(__m256i a, __m256i b0, __m256i b1, __m256i *pHi)
+{
+	const __m256i	m32 = _mm256_set1_epi64x(0xffffffffLL);
+	__m256i			a1 = _mm256_srli_epi64(a, 32);
+	__m256i			a0b0 = _mm256_mul_epu32(a, b0);
+	__m256i			a0b1 = _mm256_mul_epu32(a, b1);
+	__m256i			a1b0 = _mm256_mul_epu32(a1, b0);
+	__m256i			a1b1 = _mm256_mul_epu32(a1, b1);
+	__m256i			t = _mm256_add_epi64(_mm256_srli_epi64(a0b0, 32),
+						_mm256_add_epi64(_mm256_and_si256(a1b0, m32), _mm256_and_si256(a0b1, m32)));
+
+	*pHi = _mm256_add_epi64(_mm256_add_epi64(a1b1, _mm256_srli_epi64(t, 32)),
+		_mm256_add_epi64(_mm256_srli_epi64(a1b0, 32), _mm256_srli_epi64(a0b1, 32)));
+	return _mm256_or_si256(_mm256_and_si256(a0b0, m32), _mm256_slli_epi64(t, 32));
+}
+
+void	PCG64BlocksAVX2(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks)
+{
+	const __m256i	mLo0 = _mm256_set1_epi64x(PCG64_MULTIPLIER_LO & 0xffffffffULL);
+	const __m256i	mLo1 = _mm256_set1_epi64x(PCG64_MULTIPLIER_LO >> 32);
+	const __m256i	mHi0 = _mm256_set1_epi64x(PCG64_MULTIPLIER_HI & 0xffffffffULL);
+	const __m256i	mHi1 = _mm256_set1_epi64x(PCG64_MULTIPLIER_HI >> 32);
+	const __m256i	iSignBits = _mm256_set1_epi64x((long long) 0x8000000000000000ULL);
+	const __m256i	i64s = _mm256_set1_epi64x(64);
+	__m256i			lo[2], hi[2], incLo[2], incHi[2], newLo, newHi, tmp, x, rot;
+
+	for (int h = 0; h < 2; h++)
+	{
+		lo[h] = _mm256_loadu_si256((const __m256i *) &pEngine->lanes[0][4 * h]);
+		hi[h] = _mm256_loadu_si256((const __m256i *) &pEngine->lanes[1][4 * h]);
+		incLo[h] = _mm256_loadu_si256((const __m256i *) &pEngine->lanes[2][4 * h]);
+		incHi[h] = _mm256_loadu_si256((const __m256i *) &pEngine->lanes[3][4 * h]);
+	}
+
+	for (size_t b = 0; b < numBlocks; b++)
+	{
+		for (int step = 0; step < NUM_ENGINE_BLOCK / NUM_ENGINE_LANES; step++)
+		{
+			for (int h = 0; h < 2; h++)
+			{
+				// The upper 64 bits of state * multiplier only need the lower 64 bits of the cross products.
+				newLo = Mul64AVX2(lo[h], mLo0, mLo1, &newHi);
+				newHi = _mm256_add_epi64(newHi, Mul64AVX2(lo[h], mHi0, mHi1, &tmp));
+				newHi = _mm256_add_epi64(newHi, Mul64AVX2(hi[h], mLo0, mLo1, &tmp));
+
+				// Adding the increment.  AVX2 has no unsigned 64-bit comparison, so the carry out of the lower
+				//     half is found by flipping the sign bits first; it is -1 where there is a carry.
+				lo[h] = _mm256_add_epi64(newLo, incLo[h]);
+				tmp = _mm256_cmpgt_epi64(_mm256_xor_si256(newLo, iSignBits), _mm256_xor_si256(lo[h], iSignBits));
+				hi[h] = _mm256_sub_epi64(_mm256_add_epi64(newHi, incHi[h]), tmp);
+
+				// rotr64(hi ^ lo, hi >> 58).  The variable shifts return 0 for a count of 64, which is what a
+				//     rotation by 0 needs.
+				x = _mm256_xor_si256(hi[h], lo[h]);
+				rot = _mm256_srli_epi64(hi[h], 58);
+				x = _mm256_or_si256(_mm256_srlv_epi64(x, rot), _mm256_sllv_epi64(x, _mm256_sub_epi64(i64s, rot)));
+				_mm256_storeu_si256((__m256i *) (pOut + 4 * h), x);
+			}
+			pOut += NUM_ENGINE_LANES;
+		}
+	}
+
+	for (int h = 0; h < 2; h++)
+	{
+		_mm256_storeu_si256((__m256i *) &pEngine->lanes[0][4 * h], lo[h]);
+		_mm256_storeu_si256((__m256i *) &pEngine->lanes[1][4 * h], hi[h]);
+	}
+}
+
+// Mul64AVX512() is Mul64() in eight 64-bit lanes, with b split into b0 and b1 as in Mul64AVX2().
+static inline __m512i	Mul64AVX512(__m512i a, __m512i b0, __m512i b1, __m512i *pHi)
+{
+	const __m512i	m32 = _mm512_set1_epi64(0xffffffffLL);
+	__m512i			a1 = _mm512_srli_epi64(a, 32);
+	__m512i			a0b0 = _mm512_mul_epu32(a, b0);
+	__m512i			a0b1 = _mm512_mul_epu32(a, b1);
+	__m512i			a1b0 = _mm512_mul_epu32(a1, b0);
+	__m512i			a1b1 = _mm512_mul_epu32(a1, b1);
+	__m512i			t = _mm512_add_epi64(_mm512_srli_epi64(a0b0, 32),
+						_mm512_add_epi64(_mm512_and_si512(a1b0, m32), _mm512_and_si512(a0b1, m32)));
+
+	*pHi = _mm512_add_epi64(_mm512_add_epi64(a1b1, _mm512_srli_epi64(t, 32)),
+		_mm512_add_epi64(_mm512_srli_epi64(a1b0, 32), _mm512_srli_epi64(a0b1, 32)));
+	return _mm512_or_si512(_mm512_and_si512(a0b0, m32), _mm512_slli_epi64(t, 32));
+}
+
+void	PCG64BlocksAVX512(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks)
+{
+	const __m512i	mLo0 = _mm512_set1_epi64(PCG64_MULTIPLIER_LO & 0xffffffffULL);
+	const __m512i	mLo1 = _mm512_set1_epi64(PCG64_MULTIPLIER_LO >> 32);
+	const __m512i	mHi0 = _mm512_set1_epi64(PCG64_MULTIPLIER_HI & 0xffffffffULL);
+	const __m512i	mHi1 = _mm512_set1_epi64(PCG64_MULTIPLIER_HI >> 32);
+	const __m512i	iOnes = _mm512_set1_epi64(1);
+	__m512i			lo = _mm512_loadu_si512(pEngine->lanes[0]);
+	__m512i			hi = _mm512_loadu_si512(pEngine->lanes[1]);
+	__m512i			incLo = _mm512_loadu_si512(pEngine->lanes[2]);
+	__m512i			incHi = _mm512_loadu_si512(pEngine->lanes[3]);
+	__m512i			newLo, newHi, tmp, x;
+	__mmask8		carries;
+
+	for (size_t b = 0; b < numBlocks; b++)
+	{
+		for (int step = 0; step < NUM_ENGINE_BLOCK / NUM_ENGINE_LANES; step++)
+		{
+			newLo = Mul64AVX512(lo, mLo0, mLo1, &newHi);
+			newHi = _mm512_add_epi64(newHi, Mul64AVX512(lo, mHi0, mHi1, &tmp));
+			newHi = _mm512_add_epi64(newHi, Mul64AVX512(hi, mLo0, mLo1, &tmp));
+
+			lo = _mm512_add_epi64(newLo, incLo);
+			carries = _mm512_cmplt_epu64_mask(lo, newLo);
+			hi = _mm512_mask_add_epi64(_mm512_add_epi64(newHi, incHi), carries,
+				_mm512_add_epi64(newHi, incHi), iOnes);
+
+			x = _mm512_rorv_epi64(_mm512_xor_si512(hi, lo), _mm512_srli_epi64(hi, 58));
+			_mm512_storeu_si512(pOut, x);
+			pOut += NUM_ENGINE_LANES;
+		}
+	}
+
+	_mm512_storeu_si512(pEngine->lanes[0], lo);
+	_mm512_storeu_si512(pEngine->lanes[1], hi);
+}
+
+// ----- Philox4x32-10 -----
+// The engine keeps the 64-bit block counter in lanes[0][0], the upper 64 bits of the 128-bit counter (the
+//     stream) in lanes[1][0] and the 64-bit key in lanes[2][0].  Counter c of a block is lanes[0][0] + c;
+//     lanes[0][0] would only wrap around after 2^64 counters, so we never carry into the stream.
+
+// PhiloxRoundKeys() expands the key into the PHILOX_ROUNDS pairs of round keys.
+static inline void	PhiloxRoundKeys(const MiscRandEngine *pEngine, unsigned int *pK0, unsigned int *pK1)
+{
+	unsigned int	k0 = (unsigned int) pEngine->lanes[2][0], k1 = (unsigned int) (pEngine->lanes[2][0] >> 32);
+
+	for (int r = 0; r < PHILOX_ROUNDS; r++)
+	{
+		pK0[r] = k0;
+		pK1[r] = k1;
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+}
+
+void	PhiloxBlocksScalar(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks)
+{
+	unsigned int	k0[PHILOX_ROUNDS], k1[PHILOX_ROUNDS];
+
+	PhiloxRoundKeys(pEngine, k0, k1);
+	for (size_t b = 0; b < numBlocks; b++)
+	{
+		for (int lane = 0; lane < NUM_ENGINE_LANES; lane++)
+		{
+			unsigned long long	ctr = pEngine->lanes[0][0] + lane;
+			unsigned int		c0 = (unsigned int) ctr, c1 = (unsigned int) (ctr >> 32);
+			unsigned int		c2 = (unsigned int) pEngine->lanes[1][0], c3 = (unsigned int) (pEngine->lanes[1][0] >> 32);
+
+			for (int r = 0; r < PHILOX_ROUNDS; r++)
+			{
+				unsigned long long	p0 = (unsigned long long) PHILOX_M0 * c0;
+				unsigned long long	p1 = (unsigned long long) PHILOX_M1 * c2;
+
+				c0 = (unsigned int) (p1 >> 32) ^ c1 ^ k0[r];
+				c1 = (unsigned int) p1;
+				c2 = (unsigned int) (p0 >> 32) ^ c3 ^ k1[r];
+				c3 = (unsigned int) p0;
+			}
+			*pOut++ = c0 | ((unsigned long long) c1 << 32);
+			*pOut++ = c2 | ((unsigned long long) c3 << 32);
+		}
+		pEngine->lanes[0][0] += NUM_ENGINE_LANES;
+	}
+}
+
+void	PhiloxBlocksAVX2(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks)
+{
+	const __m256i	m32 = _mm256_set1_epi64x(0xffffffffLL);
+	const __m256i	iM0 = _mm256_set1_epi64x(PHILOX_M0);
+	const __m256i	iM1 = _mm256_set1_epi64x(PHILOX_M1);
+	const __m256i	iLanes[2] = { _mm256_setr_epi64x(0, 1, 2, 3), _mm256_setr_epi64x(4, 5, 6, 7) };
+	const __m256i	iStreamLo = _mm256_set1_epi64x(pEngine->lanes[1][0] & 0xffffffffULL);
+	const __m256i	iStreamHi = _mm256_set1_epi64x(pEngine->lanes[1][0] >> 32);
+	unsigned int	k0[PHILOX_ROUNDS], k1[PHILOX_ROUNDS];
+
+	// Each 64-bit lane holds one 32-bit word of the counter of that lane in its lower half, which is what
+	//     _mm256_mul_epu32() multiplies.
+	PhiloxRoundKeys(pEngine, k0, k1);
+	for (size_t b = 0; b < numBlocks; b++)
+	{
+		__m256i	ctr = _mm256_set1_epi64x(pEngine->lanes[0][0]);
+
+		for (int h = 0; h < 2; h++)
+		{
+			__m256i	c = _mm256_add_epi64(ctr, iLanes[h]);
+			__m256i	c0 = _mm256_and_si256(c, m32), c1 = _mm256_srli_epi64(c, 32);
+			__m256i	c2 = iStreamLo, c3 = iStreamHi;
+			__m256i	p0, p1, a, d;
+
+			for (int r = 0; r < PHILOX_ROUNDS; r++)
+			{
+				p0 = _mm256_mul_epu32(c0, iM0);
+				p1 = _mm256_mul_epu32(c2, iM1);
+				c0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p1, 32), c1), _mm256_set1_epi64x(k0[r]));
+				c1 = _mm256_and_si256(p1, m32);
+				c2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p0, 32), c3), _mm256_set1_epi64x(k1[r]));
+				c3 = _mm256_and_si256(p0, m32);
+			}
+
+			// a holds the lower and d the upper 64-bit halves of the four outputs; interleaving them gives
+			//     a0 d0 a1 d1 and a2 d2 a3 d3.
+			a = _mm256_or_si256(c0, _mm256_slli_epi64(c1, 32));
+			d = _mm256_or_si256(c2, _mm256_slli_epi64(c3, 32));
+			_mm256_storeu_si256((__m256i *) (pOut + 8 * h), _mm256_permute2x128_si256(
+				_mm256_unpacklo_epi64(a, d), _mm256_unpackhi_epi64(a, d), 0x20));
+			_mm256_storeu_si256((__m256i *) (pOut + 8 * h + 4), _mm256_permute2x128_si256(
+				_mm256_unpacklo_epi64(a, d), _mm256_unpackhi_epi64(a, d), 0x31));
+		}
+		pEngine->lanes[0][0] += NUM_ENGINE_LANES;
+		pOut += NUM_ENGINE_BLOCK;
+	}
+}
+
+void	PhiloxBlocksAVX512(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks)
+{
+	const __m512i	m32 = _mm512_set1_epi64(0xffffffffLL);
+	const __m512i	iM0 = _mm512_set1_epi64(PHILOX_M0);
+	const __m512i	iM1 = _mm512_set1_epi64(PHILOX_M1);
+	const __m512i	iLanes = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m512i	iLowerHalves = _mm512_setr_epi64(0, 8, 1, 9, 2, 10, 3, 11);
+	const __m512i	iUpperHalves = _mm512_setr_epi64(4, 12, 5, 13, 6, 14, 7, 15);
+	const __m512i	iStreamLo = _mm512_set1_epi64(pEngine->lanes[1][0] & 0xffffffffULL);
+	const __m512i	iStreamHi = _mm512_set1_epi64(pEngine->lanes[1][0] >> 32);
+	unsigned int	k0[PHILOX_ROUNDS], k1[PHILOX_ROUNDS];
+
+	PhiloxRoundKeys(pEngine, k0, k1);
+	for (size_t b = 0; b < numBlocks; b++)
+	{
+		__m512i	c = _mm512_add_epi64(_mm512_set1_epi64(pEngine->lanes[0][0]), iLanes);
+		__m512i	c0 = _mm512_and_si512(c, m32), c1 = _mm512_srli_epi64(c, 32);
+		__m512i	c2 = iStreamLo, c3 = iStreamHi;
+		__m512i	p0, p1, a, d;
+
+		for (int r = 0; r < PHILOX_ROUNDS; r++)
+		{
+			p0 = _mm512_mul_epu32(c0, iM0);
+			p1 = _mm512_mul_epu32(c2, iM1);
+			c0 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p1, 32), c1), _mm512_set1_epi64(k0[r]));
+			c1 = _mm512_and_si512(p1, m32);
+			c2 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p0, 32), c3), _mm512_set1_epi64(k1[r]));
+			c3 = _mm512_and_si512(p0, m32);
+		}
+
+		a = _mm512_or_si512(c0, _mm512_slli_epi64(c1, 32));
+		d = _mm512_or_si512(c2, _mm512_slli_epi64(c3, 32));
+		_mm512_storeu_si512(pOut, _mm512_permutex2var_epi64(a, iLowerHalves, d));
+		_mm512_storeu_si512(pOut + NUM_ENGINE_LANES, _mm512_permutex2var_epi64(a, iUpperHalves, d));
+		pEngine->lanes[0][0] += NUM_ENGINE_LANES;
+		pOut += NUM_ENGINE_BLOCK;
+	}
+}
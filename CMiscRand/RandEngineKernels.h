@@ -0,0 +1,53 @@
+#pragma once
+// RandEngineKernels.h declares the kernels of the random number engines in RandEngines.cpp, one per engine
+// and instruction set.  They are internal to the library.
+//
+// A kernel writes numBlocks blocks of NUM_ENGINE_BLOCK 64-bit random numbers to pOut and advances *pEngine
+// past them.  xoshiro256** and PCG64 run one generator per lane, and a block holds two steps of all the
+// NUM_ENGINE_LANES lanes: pOut[lane] from the first step and pOut[NUM_ENGINE_LANES + lane] from the
+// second.  Philox4x32-10 encrypts the NUM_ENGINE_LANES consecutive counters starting at its counter, and a
+// block holds the two 64-bit halves of the 128-bit output of each counter in turn.  All the kernels of an
+// engine return the same sequence bit for bit.  pOut does not need to be aligned.
+
+typedef void (*RandEngineBlocks_t)(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks);
+
+void	XoshiroBlocksScalar(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks);
+void	XoshiroBlocksAVX2(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks);
+void	XoshiroBlocksAVX512(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks);
+void	PCG64BlocksScalar(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks);
+void	PCG64BlocksAVX2(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks);
+void	PCG64BlocksAVX512(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks);
+void	PhiloxBlocksScalar(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks);
+void	PhiloxBlocksAVX2(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks);
+void	PhiloxBlocksAVX512(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks);
+
+// Rotl64() rotates x left by k bits, 0 < k < 64.
+static inline unsigned long long	Rotl64(unsigned long long x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+// Mul64() returns the lower 64 bits of a * b and stores the upper 64 bits to *pHi, in the same 32-bit
+//     pieces the SIMD kernels use.
+static inline unsigned long long	Mul64(unsigned long long a, unsigned long long b, unsigned long long *pHi)
+{
+	unsigned long long	a0b0 = (a & 0xffffffffULL) * (b & 0xffffffffULL);
+	unsigned long long	a0b1 = (a & 0xffffffffULL) * (b >> 32);
+	unsigned long long	a1b0 = (a >> 32) * (b & 0xffffffffULL);
+	unsigned long long	a1b1 = (a >> 32) * (b >> 32);
+	unsigned long long	t = (a0b0 >> 32) + (a1b0 & 0xffffffffULL) + (a0b1 & 0xffffffffULL);
+
+	*pHi = a1b1 + (a1b0 >> 32) + (a0b1 >> 32) + (t >> 32);
+	return (a0b0 & 0xffffffffULL) | (t << 32);
+}
+
+// The 128-bit multiplier of PCG64 (PCG_DEFAULT_MULTIPLIER_128 of the reference implementation).
+#define PCG64_MULTIPLIER_HI		0x2360ED051FC65DA4ULL
+#define PCG64_MULTIPLIER_LO		0x4385DF649FCCF645ULL
+
+// The round multipliers and key increments of Philox4x32.
+#define PHILOX_M0				0xD2511F53U
+#define PHILOX_M1				0xCD9E8D57U
+#define PHILOX_W0				0x9E3779B9U
+#define PHILOX_W1				0xBB67AE85U
+#define PHILOX_ROUNDS			10
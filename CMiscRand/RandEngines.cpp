@@ -0,0 +1,300 @@
+// RandEngines.cpp implements the 64-bit random number engines xoshiro256**, PCG64 and Philox4x32-10 as an
+// alternative to the rand()-style linear congruential generator behind LargerRand() and GaussianRandVec(),
+// which has 15-bit outputs and a period of 2^31 per lane.  All three engines return full 64-bit random
+// numbers; xoshiro256** has a period of 2^256 - 1 per lane, PCG64 a period of 2^128 per lane, and Philox4x32-10
+// is counter-based with 2^128 counters per key.  The engines generate NUM_ENGINE_BLOCK numbers at a time
+// with the kernels in RandEngineKernels.cpp, and every engine returns the same sequence on every kernel.
+
+#include <string.h>
+#include "MiscRand.h"
+#include "RandEngineKernels.h"
+#include "cpudetect.h"
+
+#define NUM_ENGINE_CHUNK		256		// 64-bit numbers converted at a time by the 32-bit and double front ends
+
+// SplitMix64() returns the next output of the SplitMix64 generator with state *pState.  We only use it to
+//     expand a 64-bit seed into engine states, as recommended by the authors of xoshiro256**.
+static unsigned long long	SplitMix64(unsigned long long *pState)
+{
+	unsigned long long	z = (*pState += 0x9E3779B97F4A7C15ULL);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// XoshiroJump() advances lane of *pEngine by 2^128 steps with the jump polynomial of xoshiro256**, so that
+//     lanes seeded one jump apart never overlap.
+static void	XoshiroJump(MiscRandEngine *pEngine, int lane)
+{
+	static const unsigned long long	jump[] =
+		{ 0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL };
+	unsigned long long	s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+	for (int i = 0; i < 4; i++)
+	{
+		for (int bit = 0; bit < 64; bit++)
+		{
+			if (jump[i] & (1ULL << bit))
+			{
+				s0 ^= pEngine->lanes[0][lane];
+				s1 ^= pEngine->lanes[1][lane];
+				s2 ^= pEngine->lanes[2][lane];
+				s3 ^= pEngine->lanes[3][lane];
+			}
+
+			// One xoshiro256 step of the lane; the output does not matter here.
+			unsigned long long	t = pEngine->lanes[1][lane] << 17;
+			pEngine->lanes[2][lane] ^= pEngine->lanes[0][lane];
+			pEngine->lanes[3][lane] ^= pEngine->lanes[1][lane];
+			pEngine->lanes[1][lane] ^= pEngine->lanes[2][lane];
+			pEngine->lanes[0][lane] ^= pEngine->lanes[3][lane];
+			pEngine->lanes[2][lane] ^= t;
+			pEngine->lanes[3][lane] = Rotl64(pEngine->lanes[3][lane], 45);
+		}
+	}
+
+	pEngine->lanes[0][lane] = s0;
+	pEngine->lanes[1][lane] = s1;
+	pEngine->lanes[2][lane] = s2;
+	pEngine->lanes[3][lane] = s3;
+}
+
+// PCG64Step() advances lane of *pEngine by one step without producing an output.
+static void	PCG64Step(MiscRandEngine *pEngine, int lane)
+{
+	unsigned long long	lo = pEngine->lanes[0][lane], hi = pEngine->lanes[1][lane];
+	unsigned long long	newHi, newLo;
+
+	newLo = Mul64(lo, PCG64_MULTIPLIER_LO, &newHi);
+	newHi += lo * PCG64_MULTIPLIER_HI + hi * PCG64_MULTIPLIER_LO;
+	pEngine->lanes[0][lane] = newLo + pEngine->lanes[2][lane];
+	pEngine->lanes[1][lane] = newHi + pEngine->lanes[3][lane] + (pEngine->lanes[0][lane] < newLo);
+}
+
+// RandEngineInit() sets *pEngine up as an engine of the given type seeded with seed.
+//     - xoshiro256**: lane 0 takes four SplitMix64 outputs of seed, and every other lane starts 2^128 steps
+//       after the previous one.
+//     - PCG64: every lane takes its own 128-bit initial state from SplitMix64 and its own stream, the lane
+//       number, seeded the way pcg64_srandom_r() does it.
+//     - Philox4x32-10: seed is the key, and both the counter and the stream start at 0.
+void	MISCRAND_CDECL	RandEngineInit(MiscRandEngine *pEngine, MiscRandEngineType type, unsigned long long seed)
+{
+	unsigned long long	uSplitMixState = seed;
+
+	memset(pEngine, 0, sizeof(MiscRandEngine));
+	pEngine->type = type;
+
+	switch (type)
+	{
+	case MISCRAND_ENGINE_XOSHIRO256SS:
+		for (int i = 0; i < 4; i++)
+			pEngine->lanes[i][0] = SplitMix64(&uSplitMixState);
+		for (int lane = 1; lane < NUM_ENGINE_LANES; lane++)
+		{
+			for (int i = 0; i < 4; i++)
+				pEngine->lanes[i][lane] = pEngine->lanes[i][lane - 1];
+			XoshiroJump(pEngine, lane);
+		}
+		break;
+
+	case MISCRAND_ENGINE_PCG64:
+		for (int lane = 0; lane < NUM_ENGINE_LANES; lane++)
+		{
+			unsigned long long	uInitLo = SplitMix64(&uSplitMixState);
+			unsigned long long	uInitHi = SplitMix64(&uSplitMixState);
+
+			// The increment is (stream << 1) | 1, which must be odd.
+			pEngine->lanes[2][lane] = ((unsigned long long) lane << 1) | 1;
+			pEngine->lanes[3][lane] = 0;
+			PCG64Step(pEngine, lane);
+			pEngine->lanes[0][lane] += uInitLo;
+			pEngine->lanes[1][lane] += uInitHi + (pEngine->lanes[0][lane] < uInitLo);
+			PCG64Step(pEngine, lane);
+		}
+		break;
+
+	case MISCRAND_ENGINE_PHILOX4X32:
+	default:
+		pEngine->type = MISCRAND_ENGINE_PHILOX4X32;
+		pEngine->lanes[2][0] = seed;
+		break;
+	}
+}
+
+// SelectRandEngineISA() returns the fastest instruction set we have engine kernels for on the running CPU.
+static MiscRandISA	SelectRandEngineISA()
+{
+	if (supportAVX512F())
+		return MISCRAND_ISA_AVX512;
+	else if (supportAVX2())
+		return MISCRAND_ISA_AVX2;
+	else
+		return MISCRAND_ISA_SCALAR;
+}
+
+static void	RandEngineBlocksResolve(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks);
+
+// pRandEngineBlocks[] points to the kernel in use for each engine, and randEngineISA tells which instruction
+//     set they are for.  They are bound at startup the same way as pGaussianRandVecBlock in GaussianRand.cpp.
+static RandEngineBlocks_t	pRandEngineBlocks[NUM_MISCRAND_ENGINES] =
+	{ RandEngineBlocksResolve, RandEngineBlocksResolve, RandEngineBlocksResolve };
+static MiscRandISA			randEngineISA = MISCRAND_ISA_SCALAR;
+static const bool			bRandEngineBound = RandEngineSetISA(SelectRandEngineISA());
+
+static void	RandEngineBlocksResolve(MiscRandEngine *pEngine, unsigned long long *pOut, size_t numBlocks)
+{
+	RandEngineSetISA(SelectRandEngineISA());
+	pRandEngineBlocks[pEngine->type](pEngine, pOut, numBlocks);
+}
+
+// RandEngineISA() returns the instruction set of the engine kernels in use.
+MiscRandISA	MISCRAND_CDECL	RandEngineISA()
+{
+	if (pRandEngineBlocks[0] == RandEngineBlocksResolve)
+		RandEngineSetISA(SelectRandEngineISA());
+	return randEngineISA;
+}
+
+// RandEngineSetISA() makes all the engines use their kernels for isa.  It returns false and changes nothing
+//     if there are no such kernels or the running CPU does not support isa.  It is not meant to be called
+//     while other threads are generating.
+bool	MISCRAND_CDECL	RandEngineSetISA(MiscRandISA isa)
+{
+	switch (isa)
+	{
+	case MISCRAND_ISA_AVX512:
+		if (!supportAVX512F())
+			return false;
+		pRandEngineBlocks[MISCRAND_ENGINE_XOSHIRO256SS] = XoshiroBlocksAVX512;
+		pRandEngineBlocks[MISCRAND_ENGINE_PCG64] = PCG64BlocksAVX512;
+		pRandEngineBlocks[MISCRAND_ENGINE_PHILOX4X32] = PhiloxBlocksAVX512;
+		break;
+	case MISCRAND_ISA_AVX2:
+		if (!supportAVX2())
+			return false;
+		pRandEngineBlocks[MISCRAND_ENGINE_XOSHIRO256SS] = XoshiroBlocksAVX2;
+		pRandEngineBlocks[MISCRAND_ENGINE_PCG64] = PCG64BlocksAVX2;
+		pRandEngineBlocks[MISCRAND_ENGINE_PHILOX4X32] = PhiloxBlocksAVX2;
+		break;
+	case MISCRAND_ISA_SCALAR:
+		pRandEngineBlocks[MISCRAND_ENGINE_XOSHIRO256SS] = XoshiroBlocksScalar;
+		pRandEngineBlocks[MISCRAND_ENGINE_PCG64] = PCG64BlocksScalar;
+		pRandEngineBlocks[MISCRAND_ENGINE_PHILOX4X32] = PhiloxBlocksScalar;
+		break;
+	default:
+		return false;
+	}
+	randEngineISA = isa;
+	return true;
+}
+
+// RandEngineNext64() returns the next 64-bit random number of *pEngine.
+unsigned long long	MISCRAND_CDECL	RandEngineNext64(MiscRandEngine *pEngine)
+{
+	if (pEngine->numAvailableResults == 0)
+	{
+		pRandEngineBlocks[pEngine->type](pEngine, pEngine->results, 1);
+		pEngine->numAvailableResults = NUM_ENGINE_BLOCK;
+	}
+
+	return pEngine->results[NUM_ENGINE_BLOCK - pEngine->numAvailableResults--];
+}
+
+// RandEngineFill64() fills pOut[0], ..., pOut[n - 1] with what n RandEngineNext64() calls would return.
+void	MISCRAND_CDECL	RandEngineFill64(MiscRandEngine *pEngine, unsigned long long *pOut, size_t n)
+{
+	size_t	numBlocks;
+
+	// The head comes from results[], the body straight from the kernel, and the tail from results[] again,
+	//     as in GaussianRandVecFill_r().
+	while ((n > 0) && (pEngine->numAvailableResults > 0))
+	{
+		*pOut++ = RandEngineNext64(pEngine);
+		n--;
+	}
+
+	numBlocks = n / NUM_ENGINE_BLOCK;
+	if (numBlocks > 0)
+	{
+		pRandEngineBlocks[pEngine->type](pEngine, pOut, numBlocks);
+		pOut += numBlocks * NUM_ENGINE_BLOCK;
+		n -= numBlocks * NUM_ENGINE_BLOCK;
+	}
+
+	while (n > 0)
+	{
+		*pOut++ = RandEngineNext64(pEngine);
+		n--;
+	}
+}
+
+// RandEngineNext32() returns the next 32-bit random number of *pEngine.  The 32-bit sequence splits every
+//     64-bit random number into its lower half and then its upper half.
+unsigned int	MISCRAND_CDECL	RandEngineNext32(MiscRandEngine *pEngine)
+{
+	unsigned long long	x;
+
+	if (pEngine->bHasPendingHalf)
+	{
+		pEngine->bHasPendingHalf = 0;
+		return pEngine->uPendingHalf;
+	}
+
+	x = RandEngineNext64(pEngine);
+	pEngine->uPendingHalf = (unsigned int) (x >> 32);
+	pEngine->bHasPendingHalf = 1;
+	return (unsigned int) x;
+}
+
+// RandEngineFill32() fills pOut[0], ..., pOut[n - 1] with what n RandEngineNext32() calls would return.
+void	MISCRAND_CDECL	RandEngineFill32(MiscRandEngine *pEngine, unsigned int *pOut, size_t n)
+{
+	unsigned long long	chunk[NUM_ENGINE_CHUNK];
+
+	if ((n > 0) && pEngine->bHasPendingHalf)
+	{
+		*pOut++ = RandEngineNext32(pEngine);
+		n--;
+	}
+
+	while (n >= 2)
+	{
+		size_t	m = (n / 2 < NUM_ENGINE_CHUNK) ? n / 2 : NUM_ENGINE_CHUNK;
+
+		RandEngineFill64(pEngine, chunk, m);
+		for (size_t i = 0; i < m; i++)
+		{
+			*pOut++ = (unsigned int) chunk[i];
+			*pOut++ = (unsigned int) (chunk[i] >> 32);
+		}
+		n -= 2 * m;
+	}
+
+	if (n > 0)
+		*pOut = RandEngineNext32(pEngine);
+}
+
+// RandEngineNextDouble() returns a uniformly distributed random number in [0, 1) with a full 53-bit
+//     mantissa, made of the upper 53 bits of the next 64-bit random number of *pEngine.
+double	MISCRAND_CDECL	RandEngineNextDouble(MiscRandEngine *pEngine)
+{
+	return (RandEngineNext64(pEngine) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// RandEngineFillDouble() fills pOut[0], ..., pOut[n - 1] with what n RandEngineNextDouble() calls would return.
+void	MISCRAND_CDECL	RandEngineFillDouble(MiscRandEngine *pEngine, double *pOut, size_t n)
+{
+	unsigned long long	chunk[NUM_ENGINE_CHUNK];
+
+	while (n > 0)
+	{
+		size_t	m = (n < NUM_ENGINE_CHUNK) ? n : NUM_ENGINE_CHUNK;
+
+		RandEngineFill64(pEngine, chunk, m);
+		for (size_t i = 0; i < m; i++)
+			pOut[i] = (chunk[i] >> 11) * (1.0 / 9007199254740992.0);
+		pOut += m;
+		n -= m;
+	}
+}
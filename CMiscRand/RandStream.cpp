@@ -0,0 +1,327 @@
+// RandStream.cpp writes precomputed random number streams to files and replays them from memory-mapped
+// views, so that hundreds of processes replaying the same sequence share one copy in the page cache
+// instead of each generating it again.
+//
+// A stream file is a RAND_STREAM_HEADER_SIZE-byte header followed by the numbers, little-endian as the
+// CPUs this library runs on store them.  The header records the generator, the seed of SplitStreams() the
+// numbers come from, their type and count, and the generator lanes where the numbers end; the writer
+// rounds the count up to a whole number of kernel blocks, so these lanes are all it takes to continue the
+// sequence live.  RandStreamView() hands out pointers straight into the mapping; RandStreamFill() copies
+// from it and goes on generating past the end of the file.
+//
+// The data start on a page boundary.  On Linux the mapping is advised MADV_SEQUENTIAL, so the kernel reads
+// ahead and drops pages behind, and optionally MADV_HUGEPAGE, which helps where the page cache supports
+// huge pages for files (tmpfs, for instance).  Windows maps file views with small pages only, so it opens
+// the file FILE_FLAG_SEQUENTIAL_SCAN and ignores the huge page request.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "MiscRand.h"
+
+#define RAND_STREAM_MAGIC			"MRSTREAM"
+#define RAND_STREAM_VERSION			2		// 2: GaussianRandVec() blocks back in the order it has always served them
+#define RAND_STREAM_HEADER_SIZE		4096		// The header takes a whole page, so the data are page-aligned
+#define NUM_RAND_STREAM_CHUNK		65536		// Numbers generated and written at a time
+#define NUM_RAND_STREAM_ROUNDING	NUM_GAUSSIANRANDFLOAT_GENERATED		// Counts are multiples of this
+
+// RandStreamHeader is the start of the header page; the rest of the page is zeros.  All the fields have
+//     fixed sizes, so the layout is the same for every compiler.
+typedef struct RandStreamHeader
+{
+	char				magic[8];									// RAND_STREAM_MAGIC, without the '\0'
+	unsigned int		version;									// RAND_STREAM_VERSION
+	unsigned int		headerSize;									// RAND_STREAM_HEADER_SIZE
+	unsigned int		type;										// MiscRandStreamType
+	unsigned int		sampleBytes;								// 8 for doubles, 4 for floats
+	unsigned long long	seed;										// Seed of SplitStreams()
+	unsigned long long	count;										// Number of numbers in the file
+	unsigned long long	dataOffset;									// Where the numbers start
+	unsigned int		endLaneSeeds[NUM_GAUSSIANRAND_LANES];		// The lanes after the last number
+	unsigned int		endFloatLaneSeeds[NUM_GAUSSIANRANDFLOAT_LANES];
+	unsigned int		endLargerRandSeed;
+	unsigned int		reserved;
+} RandStreamHeader;
+
+// RandStream is a stream file opened for replay.  Like MiscRandState, each thread should own the RandStream
+//     it reads from; several of them can map the same file.
+struct RandStream
+{
+	RandStreamHeader	header;
+	const char			*pData;				// The numbers in the mapping
+	unsigned long long	position;			// Numbers handed out so far, from the file or live
+	MiscRandState		liveState;			// Generates the numbers past the end of the file
+	void				*pMapping;			// The whole file, as mapped
+	size_t				mappingSize;
+#ifdef _WIN32
+	HANDLE				hFile;
+	HANDLE				hMapping;
+#endif
+};
+
+// RandStreamSampleBytes() returns the size of the numbers of a stream of the given type, or 0 for no type.
+static unsigned int	RandStreamSampleBytes(unsigned int type)
+{
+	switch (type)
+	{
+	case MISCRAND_STREAM_GAUSSIANRANDVEC:
+	case MISCRAND_STREAM_UNIFORMRAND:
+		return sizeof(double);
+	case MISCRAND_STREAM_GAUSSIANRANDVECFLOAT:
+	case MISCRAND_STREAM_UNIFORMRANDFLOAT:
+		return sizeof(float);
+	default:
+		return 0;
+	}
+}
+
+// RandStreamGenerate() writes the next n numbers of a stream of the given type from *pState to pOut.  These
+//     are the same calls the writer makes, so they continue the sequence of the file.
+static void	RandStreamGenerate(MiscRandState *pState, unsigned int type, void *pOut, size_t n)
+{
+	switch (type)
+	{
+	case MISCRAND_STREAM_GAUSSIANRANDVEC:
+		GaussianRandVecFill_r(pState, (double *) pOut, n);
+		break;
+	case MISCRAND_STREAM_GAUSSIANRANDVECFLOAT:
+		GaussianRandVecFloatFill_r(pState, (float *) pOut, n);
+		break;
+	case MISCRAND_STREAM_UNIFORMRAND:
+		UniformRandFill_r(pState, (double *) pOut, n, 0.0, 1.0);
+		break;
+	case MISCRAND_STREAM_UNIFORMRANDFLOAT:
+		UniformRandFillFloat_r(pState, (float *) pOut, n, 0.0f, 1.0f);
+		break;
+	}
+}
+
+// RandStreamWriteFile() writes a stream file of count numbers of the given type, generated from the state
+//     SplitStreams(&state, 1, seed, 0) sets up.  count is rounded up to a multiple of
+//     NUM_RAND_STREAM_ROUNDING.  It returns false if the type is unknown or the file cannot be written.
+bool	MISCRAND_CDECL	RandStreamWriteFile(const char *pPath, MiscRandStreamType type, unsigned long seed,
+	unsigned long long count)
+{
+	RandStreamHeader	header;
+	MiscRandState		state;
+	char				*pPage;
+	void				*pChunk;
+	FILE				*pFile;
+	unsigned int		sampleBytes = RandStreamSampleBytes(type);
+	bool				bWritten;
+
+	if (sampleBytes == 0)
+		return false;
+	count = (count + NUM_RAND_STREAM_ROUNDING - 1) / NUM_RAND_STREAM_ROUNDING * NUM_RAND_STREAM_ROUNDING;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, RAND_STREAM_MAGIC, sizeof(header.magic));
+	header.version = RAND_STREAM_VERSION;
+	header.headerSize = RAND_STREAM_HEADER_SIZE;
+	header.type = type;
+	header.sampleBytes = sampleBytes;
+	header.seed = seed;
+	header.count = count;
+	header.dataOffset = RAND_STREAM_HEADER_SIZE;
+
+	pPage = (char *) calloc(RAND_STREAM_HEADER_SIZE, 1);
+	pChunk = malloc((size_t) NUM_RAND_STREAM_CHUNK * sampleBytes);
+	pFile = fopen(pPath, "wb");
+	bWritten = (pPage != NULL) && (pChunk != NULL) && (pFile != NULL);
+
+	// The header page goes first as zeros, and again with the end lanes once the numbers are written.
+	if (bWritten)
+		bWritten = (fwrite(pPage, RAND_STREAM_HEADER_SIZE, 1, pFile) == 1);
+	SplitStreams(&state, 1, seed, 0);
+	for (unsigned long long done = 0; bWritten && (done < count); done += NUM_RAND_STREAM_CHUNK)
+	{
+		size_t	n = (count - done < NUM_RAND_STREAM_CHUNK) ? (size_t) (count - done) : NUM_RAND_STREAM_CHUNK;
+
+		RandStreamGenerate(&state, type, pChunk, n);
+		bWritten = (fwrite(pChunk, sampleBytes, n, pFile) == n);
+	}
+	if (bWritten)
+	{
+		memcpy(header.endLaneSeeds, state.laneSeeds, sizeof(header.endLaneSeeds));
+		memcpy(header.endFloatLaneSeeds, state.floatLaneSeeds, sizeof(header.endFloatLaneSeeds));
+		header.endLargerRandSeed = (unsigned int) state.uLargerRandSeed;
+		memcpy(pPage, &header, sizeof(header));
+		bWritten = (fseek(pFile, 0, SEEK_SET) == 0) && (fwrite(pPage, RAND_STREAM_HEADER_SIZE, 1, pFile) == 1);
+	}
+
+	if ((pFile != NULL) && (fclose(pFile) != 0))
+		bWritten = false;
+	free(pChunk);
+	free(pPage);
+	if (!bWritten && (pFile != NULL))
+		remove(pPath);
+	return bWritten;
+}
+
+// RandStreamUnmap() releases whatever RandStreamOpen() got for *pStream, and *pStream itself.
+static void	RandStreamUnmap(RandStream *pStream)
+{
+#ifdef _WIN32
+	if (pStream->pMapping != NULL)
+		UnmapViewOfFile(pStream->pMapping);
+	if (pStream->hMapping != NULL)
+		CloseHandle(pStream->hMapping);
+	if (pStream->hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(pStream->hFile);
+#else
+	if (pStream->pMapping != NULL)
+		munmap(pStream->pMapping, pStream->mappingSize);
+#endif
+	_mm_free(pStream);
+}
+
+// RandStreamOpen() maps the stream file pPath for replay, asking for huge pages if bHugePages is true.
+//     It returns NULL if the file cannot be mapped, is not a stream file of this version, or is shorter
+//     than its header says.
+RandStream *	MISCRAND_CDECL	RandStreamOpen(const char *pPath, bool bHugePages)
+{
+	RandStream		*pStream = (RandStream *) _mm_malloc(sizeof(RandStream), 64);
+	const RandStreamHeader	*pHeader;
+
+	if (pStream == NULL)
+		return NULL;
+	memset(pStream, 0, sizeof(RandStream));
+
+#ifdef _WIN32
+	LARGE_INTEGER	fileSize;
+
+	(void) bHugePages;
+	pStream->hMapping = NULL;
+	pStream->hFile = CreateFileA(pPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if ((pStream->hFile == INVALID_HANDLE_VALUE) || !GetFileSizeEx(pStream->hFile, &fileSize)
+		|| (fileSize.QuadPart < RAND_STREAM_HEADER_SIZE) || ((unsigned long long) fileSize.QuadPart > (size_t) -1))
+	{
+		RandStreamUnmap(pStream);
+		return NULL;
+	}
+	pStream->mappingSize = (size_t) fileSize.QuadPart;
+	pStream->hMapping = CreateFileMappingA(pStream->hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (pStream->hMapping != NULL)
+		pStream->pMapping = MapViewOfFile(pStream->hMapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	struct stat		fileStat;
+	int				fd = open(pPath, O_RDONLY);
+
+	if ((fd < 0) || (fstat(fd, &fileStat) != 0) || (fileStat.st_size < RAND_STREAM_HEADER_SIZE))
+	{
+		if (fd >= 0)
+			close(fd);
+		RandStreamUnmap(pStream);
+		return NULL;
+	}
+	pStream->mappingSize = (size_t) fileStat.st_size;
+	pStream->pMapping = mmap(NULL, pStream->mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (pStream->pMapping == MAP_FAILED)
+		pStream->pMapping = NULL;
+	if (pStream->pMapping != NULL)
+	{
+		madvise(pStream->pMapping, pStream->mappingSize, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+		if (bHugePages)
+			madvise(pStream->pMapping, pStream->mappingSize, MADV_HUGEPAGE);
+#else
+		(void) bHugePages;
+#endif
+	}
+#endif
+	if (pStream->pMapping == NULL)
+	{
+		RandStreamUnmap(pStream);
+		return NULL;
+	}
+
+	pHeader = (const RandStreamHeader *) pStream->pMapping;
+	if ((memcmp(pHeader->magic, RAND_STREAM_MAGIC, sizeof(pHeader->magic)) != 0)
+		|| (pHeader->version != RAND_STREAM_VERSION) || (pHeader->sampleBytes == 0)
+		|| (pHeader->sampleBytes != RandStreamSampleBytes(pHeader->type))
+		|| (pHeader->dataOffset > pStream->mappingSize)
+		|| (pHeader->count > (pStream->mappingSize - pHeader->dataOffset) / pHeader->sampleBytes))
+	{
+		RandStreamUnmap(pStream);
+		return NULL;
+	}
+
+	pStream->header = *pHeader;
+	pStream->pData = (const char *) pStream->pMapping + pHeader->dataOffset;
+	pStream->position = 0;
+	MiscRandStateInit(&pStream->liveState);
+	memcpy(pStream->liveState.laneSeeds, pHeader->endLaneSeeds, sizeof(pHeader->endLaneSeeds));
+	memcpy(pStream->liveState.floatLaneSeeds, pHeader->endFloatLaneSeeds, sizeof(pHeader->endFloatLaneSeeds));
+	pStream->liveState.uLargerRandSeed = pHeader->endLargerRandSeed;
+	return pStream;
+}
+
+// RandStreamClose() unmaps the file and frees *pStream.  The pointers RandStreamView() returned are no
+//     longer valid after that.
+void	MISCRAND_CDECL	RandStreamClose(RandStream *pStream)
+{
+	if (pStream != NULL)
+		RandStreamUnmap(pStream);
+}
+
+// RandStreamInfo() returns what the header of the file says.  Any of the pointers may be NULL.
+void	MISCRAND_CDECL	RandStreamInfo(const RandStream *pStream, MiscRandStreamType *pType, unsigned long *pSeed,
+	unsigned long long *pCount)
+{
+	if (pType != NULL)
+		*pType = (MiscRandStreamType) pStream->header.type;
+	if (pSeed != NULL)
+		*pSeed = (unsigned long) pStream->header.seed;
+	if (pCount != NULL)
+		*pCount = pStream->header.count;
+}
+
+// RandStreamView() returns a pointer to the next numbers in the mapping, doubles or floats as the type of
+//     the stream says, and takes them off the stream.  *pNumViewed is set to how many there are, at most n;
+//     it is 0, and the result NULL, once the file is used up.  The numbers stay valid until
+//     RandStreamClose().
+const void *	MISCRAND_CDECL	RandStreamView(RandStream *pStream, size_t n, size_t *pNumViewed)
+{
+	const void	*pView;
+
+	if (pStream->position >= pStream->header.count)
+	{
+		*pNumViewed = 0;
+		return NULL;
+	}
+	if (n > pStream->header.count - pStream->position)
+		n = (size_t) (pStream->header.count - pStream->position);
+	pView = pStream->pData + pStream->position * pStream->header.sampleBytes;
+	pStream->position += n;
+	*pNumViewed = n;
+	return pView;
+}
+
+// RandStreamFill() copies the next n numbers of the stream to pOut, doubles or floats as the type of the
+//     stream says.  Past the end of the file, it generates them: the numbers go on exactly as if the file
+//     had been longer.
+void	MISCRAND_CDECL	RandStreamFill(RandStream *pStream, void *pOut, size_t n)
+{
+	size_t		numViewed;
+	const void	*pView = RandStreamView(pStream, n, &numViewed);
+
+	if (numViewed > 0)
+		memcpy(pOut, pView, numViewed * pStream->header.sampleBytes);
+	if (numViewed < n)
+	{
+		RandStreamGenerate(&pStream->liveState, pStream->header.type,
+			(char *) pOut + numViewed * pStream->header.sampleBytes, n - numViewed);
+		pStream->position += n - numViewed;
+	}
+}
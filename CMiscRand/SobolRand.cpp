@@ -0,0 +1,381 @@
+// SobolRand.cpp generates Sobol low-discrepancy sequences with the direction numbers of Joe and Kuo in up to
+// SOBOL_MAX_DIMENSION dimensions.  Monte Carlo estimates over them converge close to 1/N instead of
+// 1/sqrt(N), so they need far fewer points for the same accuracy when the integrand is smooth enough.
+//
+// Point n of dimension d is the XOR of the direction numbers v[k][d] for the bits k set in the Gray code
+// n ^ (n >> 1).  Consecutive Gray codes differ in one bit, the lowest zero bit of n, so each point is the
+// one before XOR one row of direction numbers; SobolRandSeek() builds a point from the Gray code directly
+// in 32 XORs per dimension, whatever n is.  The direction numbers have 32 bits, so a sequence has 2^32
+// points and starts over after them.  The numbers are x * 2^-32 + 2^-33, the centers of the 2^32 cells,
+// so they are in (0, 1) and can go straight into UniformToGaussian().
+//
+// The scrambles randomize the sequence without changing its Gray code update.  The digital shift XORs
+// dimension d with a random 32-bit number.  MISCRAND_SOBOL_LINEAR_MATRIX is the random linear scrambling
+// of Matousek ("On the L2-discrepancy for anchored boxes", Journal of Complexity, 1998): the direction
+// numbers of each dimension are multiplied by a random lower triangular binary matrix with a unit diagonal
+// before the digital shift.  It is not Owen's nested scrambling, which draws a permutation for every
+// prefix of digits, and it does not have the variance bounds Owen proved for that.  Both scrambles are
+// done once in SobolRandCreate(), so scrambled points cost as much as plain ones.
+//
+// The SIMD kernels update and convert a point a vector of dimensions at a time; all the steps are exact,
+// so every kernel returns the same numbers.
+
+#include <string.h>
+#include <immintrin.h>
+#include "MiscRand.h"
+#include "cpudetect.h"
+#include "SobolDirections.h"
+
+#define NUM_SOBOL_BITS			32			// Bits of a direction number
+#define NUM_SOBOL_CHUNK			4096		// Numbers SobolGaussianFill() transforms at a time
+#define SOBOL_SCALE				(1.0 / 4294967296.0)	// 2^-32
+#define SOBOL_HALF_CELL			(0.5 / 4294967296.0)	// 2^-33
+
+// SobolRand keeps the direction numbers and the current point of a sequence.  The rows of pDirections and
+//     pPoint are stride numbers long, stride being dim rounded up to 16, so each row starts on a cache line.
+//     Row NUM_SOBOL_BITS of pDirections repeats row NUM_SOBOL_BITS - 1: point 2^32 - 1 is point 0 XOR that
+//     row, so XORing it again starts the sequence over.
+struct SobolRand
+{
+	unsigned int		*pDirections;		// (NUM_SOBOL_BITS + 1) rows of direction numbers
+	unsigned int		*pPoint;			// The next point, scrambled
+	unsigned int		*pShift;			// The digital shift, 0 without one
+	unsigned long long	index;				// The index of the next point, below 2^32
+	int					dim;
+	int					stride;
+};
+
+// SobolPoints_t writes numPoints points to pOut, starting with pPoint at index and stepping pPoint on after
+//     each one.  index + numPoints must not exceed 2^32.
+typedef void (*SobolPoints_t)(unsigned int *pPoint, const unsigned int *pDirections, int stride, int dim,
+	unsigned long long index, double *pOut, size_t numPoints);
+
+// SobolStepRow() returns the row of direction numbers that takes point index to point index + 1: the lowest
+//     zero bit of index.
+static inline int	SobolStepRow(unsigned long long index)
+{
+	int		k = 0;
+
+	while (index & 1)
+	{
+		index >>= 1;
+		k++;
+	}
+	return k;
+}
+
+static void	SobolPointsScalar(unsigned int *pPoint, const unsigned int *pDirections, int stride, int dim,
+	unsigned long long index, double *pOut, size_t numPoints)
+{
+	for (size_t i = 0; i < numPoints; i++)
+	{
+		const unsigned int	*pRow = &pDirections[(size_t) SobolStepRow(index + i) * stride];
+
+		for (int d = 0; d < dim; d++)
+		{
+			pOut[d] = (double) pPoint[d] * SOBOL_SCALE + SOBOL_HALF_CELL;
+			pPoint[d] ^= pRow[d];
+		}
+		pOut += dim;
+	}
+}
+
+// SobolPointsAVX2() converts 4 unsigned numbers at a time by flipping their top bits, converting them as
+//     signed numbers and adding 2^31 back.
+static void	SobolPointsAVX2(unsigned int *pPoint, const unsigned int *pDirections, int stride, int dim,
+	unsigned long long index, double *pOut, size_t numPoints)
+{
+	const __m128i	topBit = _mm_set1_epi32((int) 0x80000000);
+	const __m256d	twoTo31 = _mm256_set1_pd(2147483648.0);
+	const __m256d	scale = _mm256_set1_pd(SOBOL_SCALE), halfCell = _mm256_set1_pd(SOBOL_HALF_CELL);
+
+	for (size_t i = 0; i < numPoints; i++)
+	{
+		const unsigned int	*pRow = &pDirections[(size_t) SobolStepRow(index + i) * stride];
+		int					d = 0;
+
+		for (; d + 4 <= dim; d += 4)
+		{
+			__m128i	x = _mm_load_si128((const __m128i *) &pPoint[d]);
+			__m256d	u = _mm256_add_pd(_mm256_cvtepi32_pd(_mm_xor_si128(x, topBit)), twoTo31);
+
+			_mm256_storeu_pd(&pOut[d], _mm256_add_pd(_mm256_mul_pd(u, scale), halfCell));
+			_mm_store_si128((__m128i *) &pPoint[d], _mm_xor_si128(x, _mm_load_si128((const __m128i *) &pRow[d])));
+		}
+		for (; d < dim; d++)
+		{
+			pOut[d] = (double) pPoint[d] * SOBOL_SCALE + SOBOL_HALF_CELL;
+			pPoint[d] ^= pRow[d];
+		}
+		pOut += dim;
+	}
+}
+
+static void	SobolPointsAVX512(unsigned int *pPoint, const unsigned int *pDirections, int stride, int dim,
+	unsigned long long index, double *pOut, size_t numPoints)
+{
+	const __m512d	scale = _mm512_set1_pd(SOBOL_SCALE), halfCell = _mm512_set1_pd(SOBOL_HALF_CELL);
+
+	for (size_t i = 0; i < numPoints; i++)
+	{
+		const unsigned int	*pRow = &pDirections[(size_t) SobolStepRow(index + i) * stride];
+		int					d = 0;
+
+		for (; d + 8 <= dim; d += 8)
+		{
+			__m256i	x = _mm256_load_si256((const __m256i *) &pPoint[d]);
+
+			_mm512_storeu_pd(&pOut[d], _mm512_add_pd(_mm512_mul_pd(_mm512_cvtepu32_pd(x), scale), halfCell));
+			_mm256_store_si256((__m256i *) &pPoint[d], _mm256_xor_si256(x, _mm256_load_si256((const __m256i *) &pRow[d])));
+		}
+		for (; d < dim; d++)
+		{
+			pOut[d] = (double) pPoint[d] * SOBOL_SCALE + SOBOL_HALF_CELL;
+			pPoint[d] ^= pRow[d];
+		}
+		pOut += dim;
+	}
+}
+
+// SelectSobolRandISA() returns the fastest instruction set we have kernels for on the running CPU.
+static MiscRandISA	SelectSobolRandISA()
+{
+	if (supportAVX512F())
+		return MISCRAND_ISA_AVX512;
+	else if (supportAVX2())
+		return MISCRAND_ISA_AVX2;
+	else
+		return MISCRAND_ISA_SCALAR;
+}
+
+static void	SobolPointsResolve(unsigned int *pPoint, const unsigned int *pDirections, int stride, int dim,
+	unsigned long long index, double *pOut, size_t numPoints);
+
+// pSobolPoints and sobolRandISA are bound at startup the same way as pGaussianRandVecBlock in
+//     GaussianRand.cpp.
+static SobolPoints_t	pSobolPoints = SobolPointsResolve;
+static MiscRandISA		sobolRandISA = MISCRAND_ISA_SCALAR;
+static const bool		bSobolRandBound = SobolRandSetISA(SelectSobolRandISA());
+
+static void	SobolPointsResolve(unsigned int *pPoint, const unsigned int *pDirections, int stride, int dim,
+	unsigned long long index, double *pOut, size_t numPoints)
+{
+	SobolRandSetISA(SelectSobolRandISA());
+	pSobolPoints(pPoint, pDirections, stride, dim, index, pOut, numPoints);
+}
+
+// SobolRandISA() returns the instruction set of the kernels SobolRandFill() uses.
+MiscRandISA	MISCRAND_CDECL	SobolRandISA()
+{
+	if (pSobolPoints == SobolPointsResolve)
+		SobolRandSetISA(SelectSobolRandISA());
+	return sobolRandISA;
+}
+
+// SobolRandSetISA() makes SobolRandFill() use the kernels for isa.  It returns false and changes nothing if
+//     there are no such kernels or the running CPU does not support isa.  It is not meant to be called while
+//     other threads are generating.
+bool	MISCRAND_CDECL	SobolRandSetISA(MiscRandISA isa)
+{
+	switch (isa)
+	{
+	case MISCRAND_ISA_AVX512:
+		if (!supportAVX512F())
+			return false;
+		pSobolPoints = SobolPointsAVX512;
+		break;
+	case MISCRAND_ISA_AVX2:
+		if (!supportAVX2())
+			return false;
+		pSobolPoints = SobolPointsAVX2;
+		break;
+	case MISCRAND_ISA_SCALAR:
+		pSobolPoints = SobolPointsScalar;
+		break;
+	default:
+		return false;
+	}
+	sobolRandISA = isa;
+	return true;
+}
+
+// SobolDegree() returns the degree of a polynomial of sobolPolynomials[].
+static inline int	SobolDegree(unsigned int polynomial)
+{
+	int		degree = 0;
+
+	for (; polynomial > 1; polynomial >>= 1)
+		degree++;
+	return degree;
+}
+
+// SobolDirectionNumbers() writes the NUM_SOBOL_BITS direction numbers of a dimension to v, v[k] being
+//     m_(k+1) * 2^(31-k), from its polynomial x^s + a_1 x^(s-1) + ... + a_(s-1) x + 1 and its initial
+//     m_1, ..., m_s at pInitialM.  Past those, m_k = 2 a_1 m_(k-1) ^ 4 a_2 m_(k-2) ^ ... ^ 2^s m_(k-s) ^
+//     m_(k-s), as in Joe and Kuo.  Polynomial 1, of degree 0, gives dimension 0, with all the m_k 1.
+static void	SobolDirectionNumbers(unsigned int polynomial, const unsigned short *pInitialM, unsigned int v[NUM_SOBOL_BITS])
+{
+	int		degree = SobolDegree(polynomial);
+
+	if (degree == 0)
+	{
+		for (int k = 0; k < NUM_SOBOL_BITS; k++)
+			v[k] = 1U << (NUM_SOBOL_BITS - 1 - k);
+		return;
+	}
+
+	for (int k = 0; k < degree; k++)
+		v[k] = (unsigned int) pInitialM[k] << (NUM_SOBOL_BITS - 1 - k);
+	for (int k = degree; k < NUM_SOBOL_BITS; k++)
+	{
+		v[k] = v[k - degree] ^ (v[k - degree] >> degree);
+		for (int i = 1; i < degree; i++)
+			if ((polynomial >> (degree - i)) & 1)
+				v[k] ^= v[k - i];
+	}
+}
+
+// SobolParity() returns 1 if x has an odd number of bits set and 0 otherwise.
+static inline unsigned int	SobolParity(unsigned int x)
+{
+	x ^= x >> 16;
+	x ^= x >> 8;
+	x ^= x >> 4;
+	x ^= x >> 2;
+	x ^= x >> 1;
+	return x & 1;
+}
+
+// SobolScrambleMatrix() multiplies the direction numbers v by a random lower triangular binary matrix with a
+//     unit diagonal, bit 31 being the first digit: digit j of the result is digit j of v XOR the parity of
+//     the digits before it picked by a random mask.
+static void	SobolScrambleMatrix(MiscRandEngine *pEngine, unsigned int v[NUM_SOBOL_BITS])
+{
+	unsigned int	rows[NUM_SOBOL_BITS];
+
+	for (int j = 0; j < NUM_SOBOL_BITS; j++)
+	{
+		unsigned int	above = (j == 0) ? 0U : ~0U << (NUM_SOBOL_BITS - j);	// The digits before digit j
+
+		rows[j] = (RandEngineNext32(pEngine) & above) | (1U << (NUM_SOBOL_BITS - 1 - j));
+	}
+	for (int k = 0; k < NUM_SOBOL_BITS; k++)
+	{
+		unsigned int	x = 0;
+
+		for (int j = 0; j < NUM_SOBOL_BITS; j++)
+			x |= SobolParity(v[k] & rows[j]) << (NUM_SOBOL_BITS - 1 - j);
+		v[k] = x;
+	}
+}
+
+// SobolRandCreate() returns a Sobol sequence in dim dimensions, 1 <= dim <= SOBOL_MAX_DIMENSION, positioned
+//     at point 0.  The scrambles draw their random numbers from a xoshiro256** engine seeded with seed,
+//     which the unscrambled sequence ignores.  It returns NULL if dim is out of range or it cannot allocate
+//     the sequence.  Each thread should own the SobolRand it generates from.
+SobolRand *	MISCRAND_CDECL	SobolRandCreate(int dim, MiscRandSobolScramble scramble, unsigned long long seed)
+{
+	int				stride = (dim + 15) & ~15;
+	const unsigned short	*pInitialM = sobolInitialM;		// The m_k of the next dimension
+	SobolRand		*pSobol;
+	MiscRandEngine	engine;
+
+	if ((dim < 1) || (dim > SOBOL_MAX_DIMENSION))
+		return NULL;
+	pSobol = (SobolRand *) _mm_malloc(sizeof(SobolRand), 64);
+	if (pSobol == NULL)
+		return NULL;
+	pSobol->pDirections = (unsigned int *) _mm_malloc((size_t) (NUM_SOBOL_BITS + 3) * stride * sizeof(unsigned int), 64);
+	if (pSobol->pDirections == NULL)
+	{
+		_mm_free(pSobol);
+		return NULL;
+	}
+	pSobol->pPoint = pSobol->pDirections + (size_t) (NUM_SOBOL_BITS + 1) * stride;
+	pSobol->pShift = pSobol->pPoint + stride;
+	pSobol->dim = dim;
+	pSobol->stride = stride;
+	memset(pSobol->pDirections, 0, (size_t) (NUM_SOBOL_BITS + 3) * stride * sizeof(unsigned int));
+
+	RandEngineInit(&engine, MISCRAND_ENGINE_XOSHIRO256SS, seed);
+	for (int d = 0; d < dim; d++)
+	{
+		unsigned int	v[NUM_SOBOL_BITS];
+
+		if (d == 0)
+			SobolDirectionNumbers(1U, NULL, v);
+		else
+		{
+			SobolDirectionNumbers(sobolPolynomials[d - 1], pInitialM, v);
+			pInitialM += SobolDegree(sobolPolynomials[d - 1]);
+		}
+		if (scramble == MISCRAND_SOBOL_LINEAR_MATRIX)
+			SobolScrambleMatrix(&engine, v);
+		for (int k = 0; k < NUM_SOBOL_BITS; k++)
+			pSobol->pDirections[(size_t) k * stride + d] = v[k];
+		pSobol->pDirections[(size_t) NUM_SOBOL_BITS * stride + d] = v[NUM_SOBOL_BITS - 1];
+		if (scramble != MISCRAND_SOBOL_UNSCRAMBLED)
+			pSobol->pShift[d] = RandEngineNext32(&engine);
+	}
+
+	SobolRandSeek(pSobol, 0);
+	return pSobol;
+}
+
+// SobolRandDestroy() frees a sequence SobolRandCreate() returned.
+void	MISCRAND_CDECL	SobolRandDestroy(SobolRand *pSobol)
+{
+	_mm_free(pSobol->pDirections);
+	_mm_free(pSobol);
+}
+
+// SobolRandSeek() positions the sequence at point index mod 2^32, in 32 steps per dimension.  Threads
+//     splitting the points of one sequence give each its own SobolRand with the same arguments and seek each
+//     to the start of its slice.
+void	MISCRAND_CDECL	SobolRandSeek(SobolRand *pSobol, unsigned long long index)
+{
+	unsigned int	gray;
+
+	index &= 0xFFFFFFFFULL;
+	gray = (unsigned int) (index ^ (index >> 1));
+	memcpy(pSobol->pPoint, pSobol->pShift, pSobol->stride * sizeof(unsigned int));
+	for (int k = 0; k < NUM_SOBOL_BITS; k++)
+		if ((gray >> k) & 1)
+			for (int d = 0; d < pSobol->dim; d++)
+				pSobol->pPoint[d] ^= pSobol->pDirections[(size_t) k * pSobol->stride + d];
+	pSobol->index = index;
+}
+
+// SobolRandFill() writes the next numPoints points of the sequence to pOut, point i at pOut[i * dim], ...,
+//     pOut[i * dim + dim - 1].  pOut does not need to be aligned.
+void	MISCRAND_CDECL	SobolRandFill(SobolRand *pSobol, double *pOut, size_t numPoints)
+{
+	while (numPoints > 0)
+	{
+		unsigned long long	numLeft = (1ULL << NUM_SOBOL_BITS) - pSobol->index;		// Points before the restart
+		size_t				m = (numPoints < numLeft) ? numPoints : (size_t) numLeft;
+
+		pSobolPoints(pSobol->pPoint, pSobol->pDirections, pSobol->stride, pSobol->dim, pSobol->index, pOut, m);
+		pSobol->index = (pSobol->index + m) & 0xFFFFFFFFULL;
+		pOut += m * pSobol->dim;
+		numPoints -= m;
+	}
+}
+
+// SobolGaussianFill() writes the next numPoints points of the sequence to pOut as SobolRandFill() does, each
+//     number mapped through UniformToGaussian(), so each point is a standard Gaussian vector.  It transforms
+//     about NUM_SOBOL_CHUNK numbers at a time, while they are still in cache.
+void	MISCRAND_CDECL	SobolGaussianFill(SobolRand *pSobol, double *pOut, size_t numPoints)
+{
+	size_t	numPerChunk = (pSobol->dim < NUM_SOBOL_CHUNK) ? NUM_SOBOL_CHUNK / pSobol->dim : 1;
+
+	while (numPoints > 0)
+	{
+		size_t	m = (numPoints < numPerChunk) ? numPoints : numPerChunk;
+
+		SobolRandFill(pSobol, pOut, m);
+		UniformToGaussian(pOut, pOut, m * pSobol->dim);
+		pOut += m * pSobol->dim;
+		numPoints -= m;
+	}
+}
@@ -1,16 +1,262 @@
 #include "MiscRand.h"
+#include "UniformRandKernels.h"
+#include "cpudetect.h"
 
-static unsigned long		uLargerRandSeed = 0;
+void	MISCRAND_CDECL	sLargerRand(unsigned long _Seed)
+{
+	sLargerRand_r(MiscRandDefaultState(), _Seed);
+}
+
+long		MISCRAND_CDECL	LargerRand()
+{
+	return LargerRand_r(MiscRandDefaultState());
+}
 
-void	__cdecl	sLargerRand(unsigned long _Seed)
+void	MISCRAND_CDECL	sLargerRand_r(MiscRandState *pState, unsigned long _Seed)
 {
-	uLargerRandSeed = _Seed;
+	pState->uLargerRandSeed = _Seed;
 }
 
-long		__cdecl	LargerRand()
+long		MISCRAND_CDECL	LargerRand_r(MiscRandState *pState)
 {
 	// We no longer compute ((uLargerRandSeed = uLargerRandSeed * 214013L + 2531011L) >> 16) & 0x7fff;
 	// we only evalute the linear congruential generator and the users need to apply the
 	// right shift and the bitmask.
-	return (long)(uLargerRandSeed = uLargerRandSeed * 214013L + 2531011L);
-}
\ No newline at end of file
+	return (long)(pState->uLargerRandSeed = MiscRand::LcgStep<MiscRand::MsvcLcgParams>((unsigned int) pState->uLargerRandSeed));
+}
+
+// LargerRandJumpSeed() returns the seed the linear congruential generator behind LargerRand() and rand()
+//     reaches from _Seed after k steps.  Since x -> 214013 * x + 2531011 is an affine map mod 2^32, k steps
+//     are the map raised to the k-th power, which takes O(log k) squarings instead of k steps; see
+//     LcgJumpMap() in MiscRandTemplates.h.
+unsigned long	MISCRAND_CDECL	LargerRandJumpSeed(unsigned long _Seed, unsigned long long k)
+{
+	MiscRand::LcgAffine	jump = MiscRand::LcgJumpMap(MiscRand::MsvcLcgParams::multiplier(),
+		MiscRand::MsvcLcgParams::increment(), k);
+
+	return (unsigned long) (unsigned int) (jump.multiplier * (unsigned int) _Seed + jump.increment);
+}
+
+// LargerRandJump() moves LargerRand() k calls ahead, as if it were called k times.
+void	MISCRAND_CDECL	LargerRandJump(unsigned long long k)
+{
+	LargerRandJump_r(MiscRandDefaultState(), k);
+}
+
+// LargerRandJump_r() is LargerRandJump() working on *pState.
+void	MISCRAND_CDECL	LargerRandJump_r(MiscRandState *pState, unsigned long long k)
+{
+	pState->uLargerRandSeed = LargerRandJumpSeed(pState->uLargerRandSeed, k);
+}
+
+// UniformRand() returns a uniformly distributed random number in [0, 1) with 52 random bits, made of the
+//     upper 26 bits of the next two LargerRand() outputs.  It returns the same as UniformRandFill() does.
+double	MISCRAND_CDECL	UniformRand()
+{
+	return UniformRand_r(MiscRandDefaultState());
+}
+
+// UniformRand_r() is UniformRand() working on *pState.
+double	MISCRAND_CDECL	UniformRand_r(MiscRandState *pState)
+{
+	unsigned int	u0 = (unsigned int) LargerRand_r(pState);
+	unsigned int	u1 = (unsigned int) LargerRand_r(pState);
+
+	return UniformRandDoubleBits(u0, u1) - 1.0;
+}
+
+// SelectUniformRandISA() returns the fastest instruction set we have uniform kernels for on the running
+//     CPU.  There is no SSE4.1 kernel; it would be bound to the scalar one like the compact Gaussian kernel.
+static MiscRandISA	SelectUniformRandISA()
+{
+	if (supportAVX512F())
+		return MISCRAND_ISA_AVX512;
+	else if (supportAVX2())
+		return MISCRAND_ISA_AVX2;
+	else
+		return MISCRAND_ISA_SCALAR;
+}
+
+static void	UniformRandDoubleBlocksResolve(unsigned int *pLanes, double *pOut, size_t numBlocks, double shift,
+	double scale, double lo);
+static void	UniformRandFloatBlocksResolve(unsigned int *pLanes, float *pOut, size_t numBlocks, float shift,
+	float scale, float lo);
+
+// pUniformRandDoubleBlocks, pUniformRandFloatBlocks and uniformRandISA are bound at startup the same way as
+//     pGaussianRandVecBlock in GaussianRand.cpp.
+static UniformRandDoubleBlocks_t	pUniformRandDoubleBlocks = UniformRandDoubleBlocksResolve;
+static UniformRandFloatBlocks_t		pUniformRandFloatBlocks = UniformRandFloatBlocksResolve;
+static MiscRandISA					uniformRandISA = MISCRAND_ISA_SCALAR;
+static const bool					bUniformRandBound = UniformRandSetISA(SelectUniformRandISA());
+
+static void	UniformRandDoubleBlocksResolve(unsigned int *pLanes, double *pOut, size_t numBlocks, double shift,
+	double scale, double lo)
+{
+	UniformRandSetISA(SelectUniformRandISA());
+	pUniformRandDoubleBlocks(pLanes, pOut, numBlocks, shift, scale, lo);
+}
+
+static void	UniformRandFloatBlocksResolve(unsigned int *pLanes, float *pOut, size_t numBlocks, float shift,
+	float scale, float lo)
+{
+	UniformRandSetISA(SelectUniformRandISA());
+	pUniformRandFloatBlocks(pLanes, pOut, numBlocks, shift, scale, lo);
+}
+
+// UniformRandISA() returns the instruction set of the kernels UniformRandFill() and its siblings use.
+MiscRandISA	MISCRAND_CDECL	UniformRandISA()
+{
+	if (pUniformRandDoubleBlocks == UniformRandDoubleBlocksResolve)
+		UniformRandSetISA(SelectUniformRandISA());
+	return uniformRandISA;
+}
+
+// UniformRandSetISA() makes UniformRandFill() and its siblings use the kernels for isa.  It returns false
+//     and changes nothing if there are no such kernels or the running CPU does not support isa.  It is not
+//     meant to be called while other threads are generating.
+bool	MISCRAND_CDECL	UniformRandSetISA(MiscRandISA isa)
+{
+	switch (isa)
+	{
+	case MISCRAND_ISA_AVX512:
+		if (!supportAVX512F())
+			return false;
+		pUniformRandDoubleBlocks = UniformRandDoubleBlocksAVX512;
+		pUniformRandFloatBlocks = UniformRandFloatBlocksAVX512;
+		break;
+	case MISCRAND_ISA_AVX2:
+		if (!supportAVX2())
+			return false;
+		pUniformRandDoubleBlocks = UniformRandDoubleBlocksAVX2;
+		pUniformRandFloatBlocks = UniformRandFloatBlocksAVX2;
+		break;
+	case MISCRAND_ISA_SCALAR:
+		pUniformRandDoubleBlocks = UniformRandDoubleBlocksScalar;
+		pUniformRandFloatBlocks = UniformRandFloatBlocksScalar;
+		break;
+	default:
+		return false;
+	}
+	uniformRandISA = isa;
+	return true;
+}
+
+// StartUniformRandLanes() puts the next NUM_UNIFORMRAND_LANES LargerRand() outputs of *pState to pLanes[].
+static void	StartUniformRandLanes(MiscRandState *pState, unsigned int *pLanes)
+{
+	unsigned int	uSeed = (unsigned int) pState->uLargerRandSeed;
+
+	for (int lane = 0; lane < NUM_UNIFORMRAND_LANES; lane++)
+		pLanes[lane] = uSeed = uSeed * 214013U + 2531011U;
+}
+
+// FillUniformDoubles() runs the double kernel on the whole blocks of pOut and serves the rest one number at
+//     a time, leaving LargerRand() of *pState 2 * n outputs further.
+static void	FillUniformDoubles(MiscRandState *pState, double *pOut, size_t n, double shift, double scale, double lo)
+{
+	const size_t	numPerBlock = NUM_UNIFORMRAND_LANES / 2;
+	size_t			numBlocks = n / numPerBlock;
+
+	if (numBlocks > 0)
+	{
+		alignas(64) unsigned int	lanes[NUM_UNIFORMRAND_LANES];
+
+		StartUniformRandLanes(pState, lanes);
+		pUniformRandDoubleBlocks(lanes, pOut, numBlocks, shift, scale, lo);
+		pState->uLargerRandSeed = lanes[NUM_UNIFORMRAND_LANES - 1];
+		pOut += numBlocks * numPerBlock;
+		n -= numBlocks * numPerBlock;
+	}
+
+	while (n > 0)
+	{
+		unsigned int	u0 = (unsigned int) LargerRand_r(pState);
+		unsigned int	u1 = (unsigned int) LargerRand_r(pState);
+
+		*pOut++ = (UniformRandDoubleBits(u0, u1) - shift) * scale + lo;
+		n--;
+	}
+}
+
+// FillUniformFloats() is FillUniformDoubles() for floats, one LargerRand() output per number.
+static void	FillUniformFloats(MiscRandState *pState, float *pOut, size_t n, float shift, float scale, float lo)
+{
+	size_t	numBlocks = n / NUM_UNIFORMRAND_LANES;
+
+	if (numBlocks > 0)
+	{
+		alignas(64) unsigned int	lanes[NUM_UNIFORMRAND_LANES];
+
+		StartUniformRandLanes(pState, lanes);
+		pUniformRandFloatBlocks(lanes, pOut, numBlocks, shift, scale, lo);
+		pState->uLargerRandSeed = lanes[NUM_UNIFORMRAND_LANES - 1];
+		pOut += numBlocks * NUM_UNIFORMRAND_LANES;
+		n -= numBlocks * NUM_UNIFORMRAND_LANES;
+	}
+
+	while (n > 0)
+	{
+		*pOut++ = (UniformRandFloatBits((unsigned int) LargerRand_r(pState)) - shift) * scale + lo;
+		n--;
+	}
+}
+
+// Subtracting these from x in [1, 2) instead of 1 moves the numbers half a step up, from k * 2^-52 to
+//     (k + 1/2) * 2^-52 for doubles and likewise for floats, so neither end is reached.  Both subtractions
+//     are exact.
+#define UNIFORMRAND_OPEN_SHIFT			(1.0 - 1.0 / 9007199254740992.0)		// 1 - 2^-53
+#define UNIFORMRANDFLOAT_OPEN_SHIFT		(1.0f - 1.0f / 16777216.0f)				// 1 - 2^-24
+
+// UniformRandFill() fills pOut[0], ..., pOut[n - 1] with random numbers uniformly distributed in [lo, hi),
+//     made of the next 2 * n LargerRand() outputs of the calling thread, the upper 26 bits of two outputs
+//     giving the 52 random mantissa bits of a number in [0, 1).  The numbers are computed as
+//     u * (hi - lo) + lo without a division; when hi - lo is not a power of two, rounding may give hi
+//     itself for the largest few u.  pOut does not need to be aligned.
+void	MISCRAND_CDECL	UniformRandFill(double *pOut, size_t n, double lo, double hi)
+{
+	UniformRandFill_r(MiscRandDefaultState(), pOut, n, lo, hi);
+}
+
+// UniformRandFillOpen() is UniformRandFill() for the open interval (lo, hi): u is (k + 1/2) * 2^-52 for a
+//     random 52-bit k, so with lo = 0 and hi = 1 neither 0 nor 1 comes out, and log(u) is always finite.
+void	MISCRAND_CDECL	UniformRandFillOpen(double *pOut, size_t n, double lo, double hi)
+{
+	UniformRandFillOpen_r(MiscRandDefaultState(), pOut, n, lo, hi);
+}
+
+// UniformRandFillFloat() is UniformRandFill() for floats, with the upper 23 bits of one LargerRand()
+//     output per number.
+void	MISCRAND_CDECL	UniformRandFillFloat(float *pOut, size_t n, float lo, float hi)
+{
+	UniformRandFillFloat_r(MiscRandDefaultState(), pOut, n, lo, hi);
+}
+
+// UniformRandFillFloatOpen() is UniformRandFillOpen() for floats.
+void	MISCRAND_CDECL	UniformRandFillFloatOpen(float *pOut, size_t n, float lo, float hi)
+{
+	UniformRandFillFloatOpen_r(MiscRandDefaultState(), pOut, n, lo, hi);
+}
+
+// UniformRandFill_r() is UniformRandFill() working on *pState.
+void	MISCRAND_CDECL	UniformRandFill_r(MiscRandState *pState, double *pOut, size_t n, double lo, double hi)
+{
+	FillUniformDoubles(pState, pOut, n, 1.0, hi - lo, lo);
+}
+
+// UniformRandFillOpen_r() is UniformRandFillOpen() working on *pState.
+void	MISCRAND_CDECL	UniformRandFillOpen_r(MiscRandState *pState, double *pOut, size_t n, double lo, double hi)
+{
+	FillUniformDoubles(pState, pOut, n, UNIFORMRAND_OPEN_SHIFT, hi - lo, lo);
+}
+
+// UniformRandFillFloat_r() is UniformRandFillFloat() working on *pState.
+void	MISCRAND_CDECL	UniformRandFillFloat_r(MiscRandState *pState, float *pOut, size_t n, float lo, float hi)
+{
+	FillUniformFloats(pState, pOut, n, 1.0f, hi - lo, lo);
+}
+
+// UniformRandFillFloatOpen_r() is UniformRandFillFloatOpen() working on *pState.
+void	MISCRAND_CDECL	UniformRandFillFloatOpen_r(MiscRandState *pState, float *pOut, size_t n, float lo, float hi)
+{
+	FillUniformFloats(pState, pOut, n, UNIFORMRANDFLOAT_OPEN_SHIFT, hi - lo, lo);
+}
@@ -0,0 +1,208 @@
+// UniformRandKernels.cpp implements the kernels declared in UniformRandKernels.h.  The AVX512 kernels keep
+// the NUM_UNIFORMRAND_LANES lanes in one __m512i and the AVX2 kernels in two __m256i.  None of them needs
+// AVX512DQ: the bits of a double are put together with 64-bit shifts and masks, not conversions.
+
+#include <immintrin.h>
+#include "MiscRand.h"
+#include "UniformRandKernels.h"
+
+// ----- Scalar -----
+
+void	UniformRandDoubleBlocksScalar(unsigned int *pLanes, double *pOut, size_t numBlocks, double shift, double scale, double lo)
+{
+	for (size_t b = 0; ; )
+	{
+		for (int lane = 0; lane < NUM_UNIFORMRAND_LANES; lane += 2)
+			*pOut++ = (UniformRandDoubleBits(pLanes[lane], pLanes[lane + 1]) - shift) * scale + lo;
+		if (++b == numBlocks)
+			break;
+		for (int lane = 0; lane < NUM_UNIFORMRAND_LANES; lane++)
+			pLanes[lane] = pLanes[lane] * LCG_MUL_16 + LCG_ADD_16;
+	}
+}
+
+void	UniformRandFloatBlocksScalar(unsigned int *pLanes, float *pOut, size_t numBlocks, float shift, float scale, float lo)
+{
+	for (size_t b = 0; ; )
+	{
+		for (int lane = 0; lane < NUM_UNIFORMRAND_LANES; lane++)
+			*pOut++ = (UniformRandFloatBits(pLanes[lane]) - shift) * scale + lo;
+		if (++b == numBlocks)
+			break;
+		for (int lane = 0; lane < NUM_UNIFORMRAND_LANES; lane++)
+			pLanes[lane] = pLanes[lane] * LCG_MUL_16 + LCG_ADD_16;
+	}
+}
+
+// ----- AVX2 -----
+
+// UniformRandDoubleAVX2() turns eight consecutive outputs into four x in [1, 2): the 64-bit lane k holds
+//     output 2k in its lower half and output 2k + 1 in its upper half.
+static inline __m256d	UniformRandDoubleAVX2(__m256i u)
+{
+	const __m256i	exponent = _mm256_set1_epi64x(0x3FF0000000000000LL);
+	const __m256i	lowerMask = _mm256_set1_epi64x(0x00000000FFFFFFC0LL);
+	__m256i			bits = _mm256_or_si256(_mm256_slli_epi64(_mm256_and_si256(u, lowerMask), 20), _mm256_srli_epi64(u, 38));
+
+	return _mm256_castsi256_pd(_mm256_or_si256(bits, exponent));
+}
+
+static inline __m256	UniformRandFloatAVX2(__m256i u)
+{
+	return _mm256_castsi256_ps(_mm256_or_si256(_mm256_srli_epi32(u, 9), _mm256_set1_epi32(0x3F800000)));
+}
+
+void	UniformRandDoubleBlocksAVX2(unsigned int *pLanes, double *pOut, size_t numBlocks, double shift, double scale, double lo)
+{
+	const __m256i	mul16 = _mm256_set1_epi32((int) LCG_MUL_16), add16 = _mm256_set1_epi32((int) LCG_ADD_16);
+	const __m256i	mul32 = _mm256_set1_epi32((int) LCG_MUL_32), add32 = _mm256_set1_epi32((int) LCG_ADD_32);
+	const __m256d	avxShift = _mm256_set1_pd(shift), avxScale = _mm256_set1_pd(scale), avxLo = _mm256_set1_pd(lo);
+	__m256i			even[2], odd[2];				// Blocks 2i and 2i + 1
+	size_t			b = 0;
+
+	even[0] = _mm256_loadu_si256((const __m256i *) &pLanes[0]);
+	even[1] = _mm256_loadu_si256((const __m256i *) &pLanes[8]);
+	odd[0] = _mm256_add_epi32(_mm256_mullo_epi32(even[0], mul16), add16);
+	odd[1] = _mm256_add_epi32(_mm256_mullo_epi32(even[1], mul16), add16);
+
+	while (numBlocks - b >= 2)
+	{
+		_mm256_storeu_pd(pOut, _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(UniformRandDoubleAVX2(even[0]), avxShift), avxScale), avxLo));
+		_mm256_storeu_pd(pOut + 4, _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(UniformRandDoubleAVX2(even[1]), avxShift), avxScale), avxLo));
+		_mm256_storeu_pd(pOut + 8, _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(UniformRandDoubleAVX2(odd[0]), avxShift), avxScale), avxLo));
+		_mm256_storeu_pd(pOut + 12, _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(UniformRandDoubleAVX2(odd[1]), avxShift), avxScale), avxLo));
+		pOut += NUM_UNIFORMRAND_LANES;
+		b += 2;
+		if (b == numBlocks)
+		{
+			_mm256_storeu_si256((__m256i *) &pLanes[0], odd[0]);
+			_mm256_storeu_si256((__m256i *) &pLanes[8], odd[1]);
+			return;
+		}
+		even[0] = _mm256_add_epi32(_mm256_mullo_epi32(even[0], mul32), add32);
+		even[1] = _mm256_add_epi32(_mm256_mullo_epi32(even[1], mul32), add32);
+		odd[0] = _mm256_add_epi32(_mm256_mullo_epi32(odd[0], mul32), add32);
+		odd[1] = _mm256_add_epi32(_mm256_mullo_epi32(odd[1], mul32), add32);
+	}
+
+	// One block is left, and even[] holds it.
+	_mm256_storeu_pd(pOut, _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(UniformRandDoubleAVX2(even[0]), avxShift), avxScale), avxLo));
+	_mm256_storeu_pd(pOut + 4, _mm256_add_pd(_mm256_mul_pd(_mm256_sub_pd(UniformRandDoubleAVX2(even[1]), avxShift), avxScale), avxLo));
+	_mm256_storeu_si256((__m256i *) &pLanes[0], even[0]);
+	_mm256_storeu_si256((__m256i *) &pLanes[8], even[1]);
+}
+
+void	UniformRandFloatBlocksAVX2(unsigned int *pLanes, float *pOut, size_t numBlocks, float shift, float scale, float lo)
+{
+	const __m256i	mul16 = _mm256_set1_epi32((int) LCG_MUL_16), add16 = _mm256_set1_epi32((int) LCG_ADD_16);
+	const __m256i	mul32 = _mm256_set1_epi32((int) LCG_MUL_32), add32 = _mm256_set1_epi32((int) LCG_ADD_32);
+	const __m256	avxShift = _mm256_set1_ps(shift), avxScale = _mm256_set1_ps(scale), avxLo = _mm256_set1_ps(lo);
+	__m256i			even[2], odd[2];
+	size_t			b = 0;
+
+	even[0] = _mm256_loadu_si256((const __m256i *) &pLanes[0]);
+	even[1] = _mm256_loadu_si256((const __m256i *) &pLanes[8]);
+	odd[0] = _mm256_add_epi32(_mm256_mullo_epi32(even[0], mul16), add16);
+	odd[1] = _mm256_add_epi32(_mm256_mullo_epi32(even[1], mul16), add16);
+
+	while (numBlocks - b >= 2)
+	{
+		_mm256_storeu_ps(pOut, _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(UniformRandFloatAVX2(even[0]), avxShift), avxScale), avxLo));
+		_mm256_storeu_ps(pOut + 8, _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(UniformRandFloatAVX2(even[1]), avxShift), avxScale), avxLo));
+		_mm256_storeu_ps(pOut + 16, _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(UniformRandFloatAVX2(odd[0]), avxShift), avxScale), avxLo));
+		_mm256_storeu_ps(pOut + 24, _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(UniformRandFloatAVX2(odd[1]), avxShift), avxScale), avxLo));
+		pOut += 2 * NUM_UNIFORMRAND_LANES;
+		b += 2;
+		if (b == numBlocks)
+		{
+			_mm256_storeu_si256((__m256i *) &pLanes[0], odd[0]);
+			_mm256_storeu_si256((__m256i *) &pLanes[8], odd[1]);
+			return;
+		}
+		even[0] = _mm256_add_epi32(_mm256_mullo_epi32(even[0], mul32), add32);
+		even[1] = _mm256_add_epi32(_mm256_mullo_epi32(even[1], mul32), add32);
+		odd[0] = _mm256_add_epi32(_mm256_mullo_epi32(odd[0], mul32), add32);
+		odd[1] = _mm256_add_epi32(_mm256_mullo_epi32(odd[1], mul32), add32);
+	}
+
+	_mm256_storeu_ps(pOut, _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(UniformRandFloatAVX2(even[0]), avxShift), avxScale), avxLo));
+	_mm256_storeu_ps(pOut + 8, _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(UniformRandFloatAVX2(even[1]), avxShift), avxScale), avxLo));
+	_mm256_storeu_si256((__m256i *) &pLanes[0], even[0]);
+	_mm256_storeu_si256((__m256i *) &pLanes[8], even[1]);
+}
+
+// ----- AVX512 -----
+
+static inline __m512d	UniformRandDoubleAVX512(__m512i u)
+{
+	const __m512i	exponent = _mm512_set1_epi64(0x3FF0000000000000LL);
+	const __m512i	lowerMask = _mm512_set1_epi64(0x00000000FFFFFFC0LL);
+	__m512i			bits = _mm512_or_si512(_mm512_slli_epi64(_mm512_and_si512(u, lowerMask), 20), _mm512_srli_epi64(u, 38));
+
+	return _mm512_castsi512_pd(_mm512_or_si512(bits, exponent));
+}
+
+static inline __m512	UniformRandFloatAVX512(__m512i u)
+{
+	return _mm512_castsi512_ps(_mm512_or_si512(_mm512_srli_epi32(u, 9), _mm512_set1_epi32(0x3F800000)));
+}
+
+void	UniformRandDoubleBlocksAVX512(unsigned int *pLanes, double *pOut, size_t numBlocks, double shift, double scale, double lo)
+{
+	const __m512i	mul16 = _mm512_set1_epi32((int) LCG_MUL_16), add16 = _mm512_set1_epi32((int) LCG_ADD_16);
+	const __m512i	mul32 = _mm512_set1_epi32((int) LCG_MUL_32), add32 = _mm512_set1_epi32((int) LCG_ADD_32);
+	const __m512d	avxShift = _mm512_set1_pd(shift), avxScale = _mm512_set1_pd(scale), avxLo = _mm512_set1_pd(lo);
+	__m512i			even, odd;
+	size_t			b = 0;
+
+	even = _mm512_loadu_si512(pLanes);
+	odd = _mm512_add_epi32(_mm512_mullo_epi32(even, mul16), add16);
+
+	while (numBlocks - b >= 2)
+	{
+		_mm512_storeu_pd(pOut, _mm512_add_pd(_mm512_mul_pd(_mm512_sub_pd(UniformRandDoubleAVX512(even), avxShift), avxScale), avxLo));
+		_mm512_storeu_pd(pOut + 8, _mm512_add_pd(_mm512_mul_pd(_mm512_sub_pd(UniformRandDoubleAVX512(odd), avxShift), avxScale), avxLo));
+		pOut += NUM_UNIFORMRAND_LANES;
+		b += 2;
+		if (b == numBlocks)
+		{
+			_mm512_storeu_si512(pLanes, odd);
+			return;
+		}
+		even = _mm512_add_epi32(_mm512_mullo_epi32(even, mul32), add32);
+		odd = _mm512_add_epi32(_mm512_mullo_epi32(odd, mul32), add32);
+	}
+
+	_mm512_storeu_pd(pOut, _mm512_add_pd(_mm512_mul_pd(_mm512_sub_pd(UniformRandDoubleAVX512(even), avxShift), avxScale), avxLo));
+	_mm512_storeu_si512(pLanes, even);
+}
+
+void	UniformRandFloatBlocksAVX512(unsigned int *pLanes, float *pOut, size_t numBlocks, float shift, float scale, float lo)
+{
+	const __m512i	mul16 = _mm512_set1_epi32((int) LCG_MUL_16), add16 = _mm512_set1_epi32((int) LCG_ADD_16);
+	const __m512i	mul32 = _mm512_set1_epi32((int) LCG_MUL_32), add32 = _mm512_set1_epi32((int) LCG_ADD_32);
+	const __m512	avxShift = _mm512_set1_ps(shift), avxScale = _mm512_set1_ps(scale), avxLo = _mm512_set1_ps(lo);
+	__m512i			even, odd;
+	size_t			b = 0;
+
+	even = _mm512_loadu_si512(pLanes);
+	odd = _mm512_add_epi32(_mm512_mullo_epi32(even, mul16), add16);
+
+	while (numBlocks - b >= 2)
+	{
+		_mm512_storeu_ps(pOut, _mm512_add_ps(_mm512_mul_ps(_mm512_sub_ps(UniformRandFloatAVX512(even), avxShift), avxScale), avxLo));
+		_mm512_storeu_ps(pOut + 16, _mm512_add_ps(_mm512_mul_ps(_mm512_sub_ps(UniformRandFloatAVX512(odd), avxShift), avxScale), avxLo));
+		pOut += 2 * NUM_UNIFORMRAND_LANES;
+		b += 2;
+		if (b == numBlocks)
+		{
+			_mm512_storeu_si512(pLanes, odd);
+			return;
+		}
+		even = _mm512_add_epi32(_mm512_mullo_epi32(even, mul32), add32);
+		odd = _mm512_add_epi32(_mm512_mullo_epi32(odd, mul32), add32);
+	}
+
+	_mm512_storeu_ps(pOut, _mm512_add_ps(_mm512_mul_ps(_mm512_sub_ps(UniformRandFloatAVX512(even), avxShift), avxScale), avxLo));
+	_mm512_storeu_si512(pLanes, even);
+}
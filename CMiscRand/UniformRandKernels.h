@@ -0,0 +1,60 @@
+#pragma once
+// UniformRandKernels.h declares the kernels behind UniformRandFill() and UniformRandFillFloat() in
+// UniformRand.cpp, one per instruction set.  They are internal to the library.
+//
+// The kernels run the linear congruential generator of LargerRand() in NUM_UNIFORMRAND_LANES interleaved
+// lanes: lane i holds output i of every group of NUM_UNIFORMRAND_LANES consecutive outputs, and all lanes
+// take NUM_UNIFORMRAND_LANES steps at once with the multiplier and increment below.  So the kernels turn
+// exactly the outputs LargerRand() would return, in the same order, into uniform random numbers.
+//
+// On entry, pLanes[0], ..., pLanes[NUM_UNIFORMRAND_LANES - 1] hold the next NUM_UNIFORMRAND_LANES outputs;
+// on return, they hold the last NUM_UNIFORMRAND_LANES outputs used, so pLanes[NUM_UNIFORMRAND_LANES - 1] is
+// where LargerRand() goes on.  numBlocks must be positive.
+//
+// A double takes the upper 26 bits of two consecutive outputs as the 52 bits of its mantissa, with the
+// exponent of [1, 2): pOut[k] = (x - shift) * scale + lo, where x is in [1, 2).  A block holds
+// NUM_UNIFORMRAND_LANES / 2 doubles.  A float takes the upper 23 bits of one output the same way, and a block
+// holds NUM_UNIFORMRAND_LANES floats.  All the kernels return the same numbers bit for bit.
+
+#include <string.h>
+#include "MiscRandTemplates.h"
+
+#define NUM_UNIFORMRAND_LANES		16
+
+// x -> 214013 * x + 2531011 applied NUM_UNIFORMRAND_LANES and 2 * NUM_UNIFORMRAND_LANES times, as
+//     LargerRandJumpSeed() composes it.  The SIMD kernels keep two blocks in flight to hide the latency of
+//     the 32-bit multiplication, and step each by two blocks.
+#define LCG_MUL_16					0x43BA1741U
+#define LCG_ADD_16					0x3E314290U
+#define LCG_MUL_32					0xD290BE81U
+#define LCG_ADD_32					0x824E1920U
+
+static_assert((MiscRand::LcgJumpMap(214013U, 2531011U, NUM_UNIFORMRAND_LANES).multiplier == LCG_MUL_16)
+	&& (MiscRand::LcgJumpMap(214013U, 2531011U, NUM_UNIFORMRAND_LANES).increment == LCG_ADD_16)
+	&& (MiscRand::LcgJumpMap(214013U, 2531011U, 2 * NUM_UNIFORMRAND_LANES).multiplier == LCG_MUL_32)
+	&& (MiscRand::LcgJumpMap(214013U, 2531011U, 2 * NUM_UNIFORMRAND_LANES).increment == LCG_ADD_32),
+	"The jump constants must match the generator of LargerRand().");
+
+// UniformRandDoubleBits() and UniformRandFloatBits() turn LCG outputs into x in [1, 2) the way the kernels do;
+//     MiscRandTemplates.h has the bit layout.
+static inline double	UniformRandDoubleBits(unsigned int u0, unsigned int u1)
+{
+	return MiscRand::UniformDoubleBits(u0, u1);
+}
+
+static inline float	UniformRandFloatBits(unsigned int u)
+{
+	return MiscRand::UniformFloatBits(u);
+}
+
+typedef void (*UniformRandDoubleBlocks_t)(unsigned int *pLanes, double *pOut, size_t numBlocks, double shift,
+	double scale, double lo);
+typedef void (*UniformRandFloatBlocks_t)(unsigned int *pLanes, float *pOut, size_t numBlocks, float shift,
+	float scale, float lo);
+
+void	UniformRandDoubleBlocksScalar(unsigned int *pLanes, double *pOut, size_t numBlocks, double shift, double scale, double lo);
+void	UniformRandDoubleBlocksAVX2(unsigned int *pLanes, double *pOut, size_t numBlocks, double shift, double scale, double lo);
+void	UniformRandDoubleBlocksAVX512(unsigned int *pLanes, double *pOut, size_t numBlocks, double shift, double scale, double lo);
+void	UniformRandFloatBlocksScalar(unsigned int *pLanes, float *pOut, size_t numBlocks, float shift, float scale, float lo);
+void	UniformRandFloatBlocksAVX2(unsigned int *pLanes, float *pOut, size_t numBlocks, float shift, float scale, float lo);
+void	UniformRandFloatBlocksAVX512(unsigned int *pLanes, float *pOut, size_t numBlocks, float shift, float scale, float lo);
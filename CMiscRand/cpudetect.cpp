@@ -1,107 +1,181 @@
 #include <stdio.h>
-#include "intrin.h"
+#include <string.h>
+#ifndef _MSC_VER
+#include <cpuid.h>
+#endif
+#include "MiscRandPortability.h"
 #include "cpudetect.h"
 
+// XCR0 bits of the register states the OS saves and restores.  Please refer to the Intel 64 and IA-32
+//     Architectures Software Developer's Manual, Volume 1, Section 13.3 for more information.
+#define XCR0_SSE_STATE			0x02		// XMM registers
+#define XCR0_AVX_STATE			0x04		// Upper halves of YMM registers
+#define XCR0_AVX512_STATE		0xe0		// Opmask registers, upper halves of ZMM0-15 and ZMM16-31
 
-// isIntel() returns 1 if the code is executed on an Intel CPU, 0 otherwise.  Please refer to
-//     https://en.wikipedia.org/wiki/CPUID
-// for more information.
-bool	isIntel()
+// CpuId() runs CPUID for the leaf and subleaf and stores EAX, EBX, ECX and EDX to info[0-3], as __cpuidex()
+//     of MSVC does.
+static void	CpuId(int info[4], int leaf, int subleaf)
 {
-	const int	Genu = 0x756E6547;  // "uneG", little-endian for [Genu]ineIntel.
-	const int   Inei = 0x49656E69;  // "Ieni", little-endian for Genu[ineI]ntel.
-	const int	ntel = 0x6C65746E;  // "letn", little-endian for GenuineI[ntel].
-
-	int		cpuInfo[4];
+#ifdef _MSC_VER
+	__cpuidex(info, leaf, subleaf);
+#else
+	__cpuid_count(leaf, subleaf, info[0], info[1], info[2], info[3]);
+#endif
+}
 
-	__cpuid(cpuInfo, 0);
-	// EBX, EDX and ECX are returned in cpuInfo[1-3] when input EAX is 0.
-	if ((cpuInfo[1] == Genu) && (cpuInfo[2] == ntel) && (cpuInfo[3] == Inei))
-		return 1;
-	else
-		return 0;
+// XGetBV() reads the extended control register xcr.  GCC and Clang only allow _xgetbv() in functions
+//     compiled for XSAVE, and this one runs on any CPU, so it is written out for them.
+static unsigned long long	XGetBV(unsigned int xcr)
+{
+#ifdef _MSC_VER
+	return _xgetbv(xcr);
+#else
+	unsigned int	eax, edx;
+
+	__asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (xcr));
+	return ((unsigned long long) edx << 32) | eax;
+#endif
 }
 
-// isAMD() returns 1 if the code is executed on an AMD CPU, 0 otherwise.  Please refer to
+// TakeCpuFeatures() runs CPUID and XGETBV and returns what they report.  Please refer to
 //     https://en.wikipedia.org/wiki/CPUID
 // for more information.
-bool	isAMD()
+static CpuFeatures	TakeCpuFeatures()
+{
+	CpuFeatures		features;
+	int				cpuInfo[4], leaf1[4] = { 0 }, leaf7[4] = { 0 };
+	int				maxLeaf;
+	unsigned long long	xcr0 = 0;
+
+	memset(&features, 0, sizeof(features));
+
+	CpuId(cpuInfo, 0, 0);
+	// EAX is the highest standard leaf; the vendor string is in EBX, EDX and ECX, in that order.
+	maxLeaf = cpuInfo[0];
+	memcpy(&features.vendor[0], &cpuInfo[1], 4);
+	memcpy(&features.vendor[4], &cpuInfo[3], 4);
+	memcpy(&features.vendor[8], &cpuInfo[2], 4);
+	features.vendor[12] = '\0';
+	features.bIntel = (strcmp(features.vendor, "GenuineIntel") == 0);
+	features.bAMD = (strcmp(features.vendor, "AuthenticAMD") == 0);
+
+	// EBX, ECX and EDX are returned in cpuInfo[1-3].
+	if (maxLeaf >= 1)
+		CpuId(leaf1, 1, 0);
+	if (maxLeaf >= 7)
+		CpuId(leaf7, 7, 0);
+
+	// XGETBV itself faults unless the OS set CR4.OSXSAVE, which CPUID reports in leaf 1 ECX bit 27.
+	features.bOSXSAVE = !!(leaf1[2] & 0x08000000);
+	if (features.bOSXSAVE)
+		xcr0 = XGetBV(0);
+	features.bOSAVXState = ((xcr0 & (XCR0_SSE_STATE | XCR0_AVX_STATE)) == (XCR0_SSE_STATE | XCR0_AVX_STATE));
+	features.bOSAVX512State = features.bOSAVXState && ((xcr0 & XCR0_AVX512_STATE) == XCR0_AVX512_STATE);
+
+	features.bSSE41 = !!(leaf1[2] & 0x00080000);
+	features.bRDRAND = !!(leaf1[2] & 0x40000000);
+	features.bRDSEED = !!(leaf7[1] & 0x00040000);
+	features.bAVX = !!(leaf1[2] & 0x10000000) && features.bOSAVXState;
+	features.bFMA = !!(leaf1[2] & 0x00001000) && features.bAVX;
+	features.bAVX2 = !!(leaf7[1] & 0x00000020) && features.bAVX;
+	features.bAVX512F = !!(leaf7[1] & 0x00010000) && features.bOSAVX512State;
+	features.bAVX512DQ = !!(leaf7[1] & 0x00020000) && features.bAVX512F;
+	features.bAVX512BW = !!(leaf7[1] & 0x40000000) && features.bAVX512F;
+	features.bAVX512VL = !!(leaf7[1] & 0x80000000) && features.bAVX512F;
+
+	return features;
+}
+
+// getCpuFeatures() returns the CpuFeatures snapshot.  The function-local static is initialized exactly once
+//     even if several threads call it at the same time, and the dispatchers of the generators may call it
+//     from their static initializers in any order.
+const CpuFeatures *	getCpuFeatures()
 {
-	const int	Auth = 0x68747541;  // "htuA", little-endian for [Auth]enticAMD.
-	const int   enti = 0x69746E65;  // "itne", little-endian for Auth[enti]cAMD.
-	const int	cAMD = 0x444D4163;  // "DMAc", little-endian for Authenti[cAMD].
+	static const CpuFeatures	features = TakeCpuFeatures();
 
-	int		cpuInfo[4];
+	return &features;
+}
+
+// isIntel() returns 1 if the code is executed on an Intel CPU, 0 otherwise.
+bool	isIntel()
+{
+	return getCpuFeatures()->bIntel;
+}
 
-	__cpuid(cpuInfo, 0);
-	// EBX, EDX and ECX are returned in cpuInfo[1-3] when input EAX is 0.
-	if ((cpuInfo[1] == Auth) && (cpuInfo[2] == cAMD) && (cpuInfo[3] == enti))
-		return 1;
-	else
-		return 0;
+// isAMD() returns 1 if the code is executed on an AMD CPU, 0 otherwise.
+bool	isAMD()
+{
+	return getCpuFeatures()->bAMD;
 }
 
 // supportRDRAND() returns TRUE if the CPU where the code is executed supports
-// RDRAND feature.  Please refer to
-//     https://en.wikipedia.org/wiki/CPUID
-// for more information.
+// RDRAND feature.
 bool	supportRDRAND()
 {
-	int		cpuInfo[4];
-
-	__cpuid(cpuInfo, 1);
-	// EBX, ECX and EDX are returned in cpuInfo[1-3].
-	return !!(cpuInfo[2] & 0x40000000);
+	return getCpuFeatures()->bRDRAND;
 }
 
 // supportRDSEED() returns TRUE if the CPU where the code is executed supports
-// RDSEED feature.  Please refer to
-//     https://en.wikipedia.org/wiki/CPUID
-// for more information.
+// RDSEED feature.
 bool	supportRDSEED()
 {
-	int		cpuInfo[4];
+	return getCpuFeatures()->bRDSEED;
+}
 
-	__cpuid(cpuInfo, 7);
-	// EBX, ECX and EDX are returned in cpuInfo[1-3].
-	return !!(cpuInfo[1] & 0x00040000);
+// supportSSE41() returns TRUE if the CPU where the code is executed supports
+// SSE4.1 feature.
+bool	supportSSE41()
+{
+	return getCpuFeatures()->bSSE41;
 }
 
 // supportAVX() returns TRUE if the CPU where the code is executed supports
-// AVX feature.  Please refer to
-//     https://en.wikipedia.org/wiki/CPUID
-// for more information.
+// AVX feature and the OS saves the YMM registers.
 bool	supportAVX()
 {
-	int		cpuInfo[4];
-
-	__cpuid(cpuInfo, 1);
-	// EBX, ECX and EDX are returned in cpuInfo[1-3].
-	return !!(cpuInfo[2] & 0x10000000);
+	return getCpuFeatures()->bAVX;
 }
 
 // supportAVX2() returns TRUE if the CPU where the code is executed supports
-// AVX2 feature.  Please refer to
-//     https://en.wikipedia.org/wiki/CPUID
-// for more information.
+// AVX2 feature and the OS saves the YMM registers.
 bool	supportAVX2()
 {
-	int		cpuInfo[4];
+	return getCpuFeatures()->bAVX2;
+}
 
-	__cpuid(cpuInfo, 7);
-	// EBX, ECX and EDX are returned in cpuInfo[1-3].
-	return !!(cpuInfo[1] & 0x00000020);
+// supportFMA() returns TRUE if the CPU where the code is executed supports
+// FMA3 feature and the OS saves the YMM registers.
+bool	supportFMA()
+{
+	return getCpuFeatures()->bFMA;
 }
 
 // supportAVX512F() returns TRUE if the CPU where the code is executed supports
-// AVX-512 Foundation feature.  Please refer to
-//     https://en.wikipedia.org/wiki/CPUID
-// for more information.
+// AVX-512 Foundation feature and the OS saves the ZMM and opmask registers.
 bool	supportAVX512F()
 {
-	int		cpuInfo[4];
+	return getCpuFeatures()->bAVX512F;
+}
 
-	__cpuid(cpuInfo, 7);
-	// EBX, ECX and EDX are returned in cpuInfo[1-3].
-	return !!(cpuInfo[1] & 0x00010000);
+// supportAVX512VL() returns TRUE if the CPU where the code is executed supports
+// AVX-512 Vector Length extensions and the OS saves the ZMM and opmask registers.
+bool	supportAVX512VL()
+{
+	return getCpuFeatures()->bAVX512VL;
+}
+
+// supportAVX512DQ() returns TRUE if the CPU where the code is executed supports
+// AVX-512 Doubleword and Quadword instructions and the OS saves the ZMM and
+// opmask registers.
+bool	supportAVX512DQ()
+{
+	return getCpuFeatures()->bAVX512DQ;
+}
+
+// supportAVX512BW() returns TRUE if the CPU where the code is executed supports
+// AVX-512 Byte and Word instructions and the OS saves the ZMM and opmask
+// registers.
+bool	supportAVX512BW()
+{
+	return getCpuFeatures()->bAVX512BW;
 }
@@ -1,4 +1,32 @@
 #pragma once
+
+// CpuFeatures is a snapshot of what the CPU where the code is executed supports, taken once with CPUID and
+// XGETBV.  A vector extension is only reported if the operating system also saves and restores its
+// registers on context switches, as the XSAVE feature mask XCR0 says; otherwise using it would fault.
+typedef struct CpuFeatures
+{
+	char	vendor[13];			// "GenuineIntel", "AuthenticAMD", ...
+	bool	bIntel;
+	bool	bAMD;
+	bool	bOSXSAVE;			// The OS enabled XSAVE, so XCR0 can be read
+	bool	bOSAVXState;		// XCR0 has the XMM and YMM state
+	bool	bOSAVX512State;		// XCR0 has the XMM, YMM, opmask and ZMM state
+	bool	bSSE41;
+	bool	bAVX;
+	bool	bAVX2;
+	bool	bFMA;
+	bool	bAVX512F;
+	bool	bAVX512DQ;
+	bool	bAVX512VL;
+	bool	bAVX512BW;
+	bool	bRDRAND;
+	bool	bRDSEED;
+} CpuFeatures;
+
+// getCpuFeatures() returns the CpuFeatures snapshot, taken on the first call.  It is safe to call from any
+// thread and during static initialization, and later calls do not run CPUID again.
+const CpuFeatures *	getCpuFeatures();
+
 // isIntel() returns 1 if the code is executed on an Intel CPU, 0 otherwise.
 bool	isIntel();
 
@@ -13,6 +41,10 @@ bool	supportRDRAND();
 // RDSEED feature.
 bool	supportRDSEED();
 
+// supportSSE41() returns TRUE if the CPU where the code is executed supports
+// SSE4.1 feature.
+bool	supportSSE41();
+
 // supportAVX() returns TRUE if the CPU where the code is executed supports
 // AVX feature.
 bool	supportAVX();
@@ -21,6 +53,22 @@ bool	supportAVX();
 // AVX2 feature.
 bool	supportAVX2();
 
-// supportAVX512() returns TRUE if the CPU where the code is executed supports
+// supportFMA() returns TRUE if the CPU where the code is executed supports
+// FMA3 feature.
+bool	supportFMA();
+
+// supportAVX512F() returns TRUE if the CPU where the code is executed supports
 // AVX512 feature.
 bool	supportAVX512F();
+
+// supportAVX512VL() returns TRUE if the CPU where the code is executed supports
+// AVX-512 Vector Length extensions.
+bool	supportAVX512VL();
+
+// supportAVX512DQ() returns TRUE if the CPU where the code is executed supports
+// AVX-512 Doubleword and Quadword instructions.
+bool	supportAVX512DQ();
+
+// supportAVX512BW() returns TRUE if the CPU where the code is executed supports
+// AVX-512 Byte and Word instructions.
+bool	supportAVX512BW();
\ No newline at end of file
@@ -0,0 +1,754 @@
+// CMiscRandBench.cpp : Throughput and latency benchmark of every generator in CMiscRand.
+//
+// Each case is one generator, one API shape ("call" for one number per call, "fill" for the bulk Fill
+//     functions), one output type and, where the generator has several kernels, one instruction set or
+//     engine.  A case first runs for the warmup samples, then generates the requested number of samples
+//     in batches, --repeat times; the median of the repeats gives ns/sample, samples/s and GB/s.  The
+//     per-call latency percentiles come from timing single API calls, one number for the "call" shape
+//     and one batch for the "fill" shape, with the cost of an empty pair of __rdtsc() reads taken out.
+//
+// The parallel fills are measured apart, as one call filling all the samples on 1, 2, 4, ... threads up to
+//     --threads, so they show how the throughput scales; their latency figures are of whole calls, and each
+//     run checks that the output matches the one-thread output.  --cpu pins only the calling thread.
+//
+// Usage: CMiscRandBench [--samples N] [--batch N] [--warmup N] [--repeat N] [--latency N] [--cpu K]
+//                       [--threads N] [--filter TEXT] [--csv FILE] [--json FILE]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <immintrin.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+#include "MiscRand.h"
+
+#define DEFAULT_NUM_SAMPLES			(1 << 24)
+#define DEFAULT_BATCH				4096
+#define DEFAULT_NUM_WARMUP			(1 << 20)
+#define DEFAULT_NUM_REPEATS			5
+#define DEFAULT_NUM_LATENCY_CALLS	100000
+#define MAX_NUM_REPEATS				64
+
+typedef void (*BenchRun_t)(void *pOut, size_t n);
+typedef bool (MISCRAND_CDECL *BenchSetISA_t)(MiscRandISA isa);
+
+// BenchGenerator describes one generator and API shape; main() expands it into one case per instruction set
+//     (when setISA is not NULL) and per engine (when bUsesEngine is set).
+typedef struct BenchGenerator
+{
+	const char		*name;
+	const char		*shape;				// "call" or "fill"
+	const char		*type;				// The output type
+	size_t			sampleBytes;
+	BenchSetISA_t	setISA;				// NULL if the generator has only one kernel
+	bool			bUsesEngine;
+	BenchRun_t		run;				// Writes n samples to pOut
+} BenchGenerator;
+
+// BenchResult keeps what one case measured.
+typedef struct BenchResult
+{
+	const char		*name;
+	const char		*shape;
+	const char		*type;
+	const char		*isa;
+	const char		*engine;
+	int				numThreads;
+	size_t			numSamples;
+	size_t			latencyUnit;		// Samples per timed call in the latency figures
+	double			nsPerSample;
+	double			samplesPerSecond;
+	double			gbPerSecond;
+	double			p50Ns, p99Ns, maxNs;
+} BenchResult;
+
+static const char	*isaNames[] = { "scalar", "sse41", "avx2", "avx512" };
+static const char	*engineNames[NUM_MISCRAND_ENGINES] = { "xoshiro256ss", "pcg64", "philox4x32" };
+
+// The engine the engine-driven cases draw from, set up before each of them.
+static MiscRandEngine	benchEngine;
+
+// The ring GaussianRandRingNext() takes from.
+static GaussianRandRing	*pBenchRing;
+
+// The sequence SobolRandFill() and SobolGaussianFill() take from.
+static SobolRand		*pBenchSobol;
+
+#define BENCH_RING_SIZE				65536
+#define BENCH_RING_LOW_WATERMARK	16384
+#define NUM_BENCH_MULTIVARIATE_DIM	16			// Dimension of the MultivariateGaussianFill() vectors
+#define NUM_BENCH_SOBOL_DIM			64			// Dimension of the Sobol points
+
+static void	RunGaussianRandCall(void *pOut, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		((double *) pOut)[i] = GaussianRand();
+}
+
+static void	RunGaussianRandRingCall(void *pOut, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		((double *) pOut)[i] = GaussianRandRingNext(pBenchRing);
+}
+
+static void	RunLargerRandCall(void *pOut, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		((unsigned int *) pOut)[i] = (unsigned int) LargerRand();
+}
+
+static void	RunUniformRandCall(void *pOut, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		((double *) pOut)[i] = UniformRand();
+}
+
+static void	RunUniformRandFill(void *pOut, size_t n)
+{
+	UniformRandFill((double *) pOut, n, 0.0, 1.0);
+}
+
+static void	RunUniformRandFillFloat(void *pOut, size_t n)
+{
+	UniformRandFillFloat((float *) pOut, n, 0.0f, 1.0f);
+}
+
+static void	RunExponentialRandFill(void *pOut, size_t n)
+{
+	ExponentialRandFill((double *) pOut, n, 1.0);
+}
+
+static void	RunGammaRandFill(void *pOut, size_t n)
+{
+	GammaRandFill((double *) pOut, n, 2.5, 1.0);
+}
+
+static void	RunGammaRandFillSmallShape(void *pOut, size_t n)
+{
+	GammaRandFill((double *) pOut, n, 0.5, 1.0);
+}
+
+static void	RunPoissonRandFillSmallMean(void *pOut, size_t n)
+{
+	PoissonRandFill((unsigned int *) pOut, n, 4.0);
+}
+
+static void	RunPoissonRandFillLargeMean(void *pOut, size_t n)
+{
+	PoissonRandFill((unsigned int *) pOut, n, 100.0);
+}
+
+static void	RunTruncatedGaussianFillTail(void *pOut, size_t n)
+{
+	TruncatedGaussianFill((double *) pOut, n, 4.0, HUGE_VAL);
+}
+
+static void	RunTruncatedGaussianFillNarrow(void *pOut, size_t n)
+{
+	TruncatedGaussianFill((double *) pOut, n, 1.0, 1.5);
+}
+
+// benchCholesky is the Cholesky factor of the covariance matrix with 1 on the diagonal and 0.5 elsewhere.
+static double	benchCholesky[NUM_BENCH_MULTIVARIATE_DIM * NUM_BENCH_MULTIVARIATE_DIM];
+
+static void	RunMultivariateGaussianFill(void *pOut, size_t n)
+{
+	double	*pL = benchCholesky;
+
+	if (benchCholesky[0] == 0.0)
+		for (int i = 0; i < NUM_BENCH_MULTIVARIATE_DIM; i++)
+			for (int j = 0; j <= i; j++)
+			{
+				double	sum = (i == j) ? 1.0 : 0.5;
+
+				for (int k = 0; k < j; k++)
+					sum -= pL[i * NUM_BENCH_MULTIVARIATE_DIM + k] * pL[j * NUM_BENCH_MULTIVARIATE_DIM + k];
+				pL[i * NUM_BENCH_MULTIVARIATE_DIM + j] = (i == j) ? sqrt(sum) : sum / pL[j * NUM_BENCH_MULTIVARIATE_DIM + j];
+			}
+	MultivariateGaussianFill(benchCholesky, NUM_BENCH_MULTIVARIATE_DIM, n / NUM_BENCH_MULTIVARIATE_DIM, (double *) pOut);
+}
+
+static void	RunAddGaussianNoise(void *pOut, size_t n)
+{
+	AddGaussianNoise((double *) pOut, n, 1.0, 0.0);
+}
+
+static void	RunAddGaussianNoiseFloat(void *pOut, size_t n)
+{
+	AddGaussianNoiseFloat((float *) pOut, n, 1.0f, 0.0f);
+}
+
+static void	RunAddGaussianNoiseInt16(void *pOut, size_t n)
+{
+	AddGaussianNoiseInt16((short *) pOut, n, 100.0f, 0.0f);
+}
+
+static void	RunGaussianRandInvCall(void *pOut, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		((double *) pOut)[i] = GaussianRandInv();
+}
+
+static void	RunGaussianRandInvFill(void *pOut, size_t n)
+{
+	GaussianRandInvFill((double *) pOut, n);
+}
+
+static void	RunSobolRandFill(void *pOut, size_t n)
+{
+	SobolRandFill(pBenchSobol, (double *) pOut, n / NUM_BENCH_SOBOL_DIM);
+}
+
+static void	RunSobolGaussianFill(void *pOut, size_t n)
+{
+	SobolGaussianFill(pBenchSobol, (double *) pOut, n / NUM_BENCH_SOBOL_DIM);
+}
+
+static void	RunGaussianRandVecCall(void *pOut, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		((double *) pOut)[i] = GaussianRandVec();
+}
+
+static void	RunGaussianRandVecFill(void *pOut, size_t n)
+{
+	GaussianRandVecFill((double *) pOut, n);
+}
+
+static void	RunGaussianRandVecCompactCall(void *pOut, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		((double *) pOut)[i] = GaussianRandVecCompact();
+}
+
+static void	RunGaussianRandVecCompactFill(void *pOut, size_t n)
+{
+	GaussianRandVecCompactFill((double *) pOut, n);
+}
+
+static void	RunGaussianRandVecFloatCall(void *pOut, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		((float *) pOut)[i] = GaussianRandVecFloat();
+}
+
+static void	RunGaussianRandVecFloatFill(void *pOut, size_t n)
+{
+	GaussianRandVecFloatFill((float *) pOut, n);
+}
+
+static void	RunGaussianRandZigCall(void *pOut, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		((double *) pOut)[i] = GaussianRandZig();
+}
+
+static void	RunGaussianRandZigFill(void *pOut, size_t n)
+{
+	GaussianRandZigFill((double *) pOut, n);
+}
+
+static void	RunGaussianRandZigEngineFill(void *pOut, size_t n)
+{
+	GaussianRandZigEngineFill(&benchEngine, (double *) pOut, n);
+}
+
+static void	RunRandEngineNext64Call(void *pOut, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		((unsigned long long *) pOut)[i] = RandEngineNext64(&benchEngine);
+}
+
+static void	RunRandEngineFill64(void *pOut, size_t n)
+{
+	RandEngineFill64(&benchEngine, (unsigned long long *) pOut, n);
+}
+
+static void	RunRandEngineNext32Call(void *pOut, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		((unsigned int *) pOut)[i] = RandEngineNext32(&benchEngine);
+}
+
+static void	RunRandEngineFill32(void *pOut, size_t n)
+{
+	RandEngineFill32(&benchEngine, (unsigned int *) pOut, n);
+}
+
+static void	RunRandEngineNextDoubleCall(void *pOut, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		((double *) pOut)[i] = RandEngineNextDouble(&benchEngine);
+}
+
+static void	RunRandEngineFillDouble(void *pOut, size_t n)
+{
+	RandEngineFillDouble(&benchEngine, (double *) pOut, n);
+}
+
+static const BenchGenerator	benchGenerators[] =
+{
+	{ "GaussianRand", "call", "double", sizeof(double), NULL, false, RunGaussianRandCall },
+	{ "LargerRand", "call", "uint32", sizeof(unsigned int), NULL, false, RunLargerRandCall },
+	{ "UniformRand", "call", "double", sizeof(double), NULL, false, RunUniformRandCall },
+	{ "UniformRandFill", "fill", "double", sizeof(double), UniformRandSetISA, false, RunUniformRandFill },
+	{ "UniformRandFillFloat", "fill", "float", sizeof(float), UniformRandSetISA, false, RunUniformRandFillFloat },
+	{ "ExponentialRandFill", "fill", "double", sizeof(double), RandDistributionsSetISA, false, RunExponentialRandFill },
+	{ "GammaRandFill(2.5)", "fill", "double", sizeof(double), NULL, false, RunGammaRandFill },
+	{ "GammaRandFill(0.5)", "fill", "double", sizeof(double), RandDistributionsSetISA, false, RunGammaRandFillSmallShape },
+	{ "PoissonRandFill(4)", "fill", "uint32", sizeof(unsigned int), NULL, false, RunPoissonRandFillSmallMean },
+	{ "PoissonRandFill(100)", "fill", "uint32", sizeof(unsigned int), NULL, false, RunPoissonRandFillLargeMean },
+	{ "TruncatedGaussian(4,inf)", "fill", "double", sizeof(double), RandDistributionsSetISA, false, RunTruncatedGaussianFillTail },
+	{ "TruncatedGaussian(1,1.5)", "fill", "double", sizeof(double), RandDistributionsSetISA, false, RunTruncatedGaussianFillNarrow },
+	{ "GaussianRandVec", "call", "double", sizeof(double), GaussianRandVecSetISA, false, RunGaussianRandVecCall },
+	{ "GaussianRandVec", "fill", "double", sizeof(double), GaussianRandVecSetISA, false, RunGaussianRandVecFill },
+	{ "MultivariateGaussianFill(16)", "fill", "double", sizeof(double), MultivariateGaussianSetISA, false, RunMultivariateGaussianFill },
+	{ "AddGaussianNoise", "fill", "double", sizeof(double), GaussianNoiseSetISA, false, RunAddGaussianNoise },
+	{ "AddGaussianNoiseFloat", "fill", "float", sizeof(float), GaussianNoiseSetISA, false, RunAddGaussianNoiseFloat },
+	{ "AddGaussianNoiseInt16", "fill", "int16", sizeof(short), GaussianNoiseSetISA, false, RunAddGaussianNoiseInt16 },
+	{ "GaussianRandInv", "call", "double", sizeof(double), GaussianRandInvSetISA, false, RunGaussianRandInvCall },
+	{ "GaussianRandInvFill", "fill", "double", sizeof(double), GaussianRandInvSetISA, false, RunGaussianRandInvFill },
+	{ "SobolRandFill(64)", "fill", "double", sizeof(double), SobolRandSetISA, false, RunSobolRandFill },
+	{ "SobolGaussianFill(64)", "fill", "double", sizeof(double), SobolRandSetISA, false, RunSobolGaussianFill },
+	{ "GaussianRandRing", "call", "double", sizeof(double), NULL, false, RunGaussianRandRingCall },
+	{ "GaussianRandVecCompact", "call", "double", sizeof(double), GaussianRandVecSetISA, false, RunGaussianRandVecCompactCall },
+	{ "GaussianRandVecCompact", "fill", "double", sizeof(double), GaussianRandVecSetISA, false, RunGaussianRandVecCompactFill },
+	{ "GaussianRandVecFloat", "call", "float", sizeof(float), GaussianRandVecSetISA, false, RunGaussianRandVecFloatCall },
+	{ "GaussianRandVecFloat", "fill", "float", sizeof(float), GaussianRandVecSetISA, false, RunGaussianRandVecFloatFill },
+	{ "GaussianRandZig", "call", "double", sizeof(double), GaussianRandZigSetISA, false, RunGaussianRandZigCall },
+	{ "GaussianRandZig", "fill", "double", sizeof(double), GaussianRandZigSetISA, false, RunGaussianRandZigFill },
+	{ "GaussianRandZigEngine", "fill", "double", sizeof(double), GaussianRandZigSetISA, true, RunGaussianRandZigEngineFill },
+	{ "RandEngineNext64", "call", "uint64", sizeof(unsigned long long), RandEngineSetISA, true, RunRandEngineNext64Call },
+	{ "RandEngineFill64", "fill", "uint64", sizeof(unsigned long long), RandEngineSetISA, true, RunRandEngineFill64 },
+	{ "RandEngineNext32", "call", "uint32", sizeof(unsigned int), RandEngineSetISA, true, RunRandEngineNext32Call },
+	{ "RandEngineFill32", "fill", "uint32", sizeof(unsigned int), RandEngineSetISA, true, RunRandEngineFill32 },
+	{ "RandEngineNextDouble", "call", "double", sizeof(double), RandEngineSetISA, true, RunRandEngineNextDoubleCall },
+	{ "RandEngineFillDouble", "fill", "double", sizeof(double), RandEngineSetISA, true, RunRandEngineFillDouble },
+};
+
+// BenchParallelGenerator describes one of the parallel fills, which main() runs on 1, 2, 4, ... threads.
+typedef struct BenchParallelGenerator
+{
+	const char		*name;
+	void			(MISCRAND_CDECL *fill)(double *pOut, size_t n, unsigned long seed, int numThreads);
+} BenchParallelGenerator;
+
+static const BenchParallelGenerator	benchParallelGenerators[] =
+{
+	{ "ParallelGaussianFill", ParallelGaussianFill },
+	{ "ParallelUniformFill", ParallelUniformFill },
+};
+
+// ReadTSC() reads the time-stamp counter without letting earlier or later instructions drift across it.
+static inline unsigned long long	ReadTSC()
+{
+	unsigned long long	ulTSC;
+
+	_mm_lfence();
+	ulTSC = __rdtsc();
+	_mm_lfence();
+	return ulTSC;
+}
+
+// MeasureTSCGHz() returns the time-stamp counter frequency in GHz, against the steady clock over 100 ms.
+static double	MeasureTSCGHz()
+{
+	std::chrono::steady_clock::time_point	tBefore = std::chrono::steady_clock::now(), tAfter;
+	unsigned long long	ulClockBefore = ReadTSC(), ulClockAfter;
+
+	do
+	{
+		tAfter = std::chrono::steady_clock::now();
+	} while (std::chrono::duration<double>(tAfter - tBefore).count() < 0.1);
+	ulClockAfter = ReadTSC();
+
+	return (double) (ulClockAfter - ulClockBefore) / std::chrono::duration<double, std::nano>(tAfter - tBefore).count();
+}
+
+// MeasureTSCOverhead() returns the smallest number of cycles between two back-to-back ReadTSC() calls.
+static unsigned long long	MeasureTSCOverhead()
+{
+	unsigned long long	ulMin = ~0ULL;
+
+	for (int i = 0; i < 1000; i++)
+	{
+		unsigned long long	ulClockBefore = ReadTSC();
+		unsigned long long	ulClockAfter = ReadTSC();
+
+		if (ulClockAfter - ulClockBefore < ulMin)
+			ulMin = ulClockAfter - ulClockBefore;
+	}
+	return ulMin;
+}
+
+// PinToCPU() keeps the calling thread on logical processor cpu.  It returns false if that fails.
+static bool	PinToCPU(int cpu)
+{
+#ifdef _WIN32
+	return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR) 1 << cpu) != 0;
+#else
+	cpu_set_t	cpuSet;
+
+	CPU_ZERO(&cpuSet);
+	CPU_SET(cpu, &cpuSet);
+	return sched_setaffinity(0, sizeof(cpuSet), &cpuSet) == 0;
+#endif
+}
+
+static int	CompareDoubles(const void *pA, const void *pB)
+{
+	double	a = *(const double *) pA, b = *(const double *) pB;
+
+	return (a < b) ? -1 : (a > b);
+}
+
+static int	CompareULongLongs(const void *pA, const void *pB)
+{
+	unsigned long long	a = *(const unsigned long long *) pA, b = *(const unsigned long long *) pB;
+
+	return (a < b) ? -1 : (a > b);
+}
+
+// RunCase() measures one case into *pResult.  pBuffer holds at least batch samples of any type, and
+//     pLatencies numLatencyCalls entries.
+static void	RunCase(const BenchGenerator *pGenerator, size_t numSamples, size_t batch, size_t numWarmup,
+	int numRepeats, size_t numLatencyCalls, double tscGHz, unsigned long long ulTSCOverhead, void *pBuffer,
+	unsigned long long *pLatencies, BenchResult *pResult)
+{
+	double	nsPerSample[MAX_NUM_REPEATS];
+	size_t	done, n;
+
+	for (done = 0; done < numWarmup; done += n)
+	{
+		n = (numWarmup - done < batch) ? numWarmup - done : batch;
+		pGenerator->run(pBuffer, n);
+	}
+
+	// The throughput: numSamples samples in batches of batch, timed as a whole.
+	for (int r = 0; r < numRepeats; r++)
+	{
+		std::chrono::steady_clock::time_point	tBefore = std::chrono::steady_clock::now();
+
+		for (done = 0; done < numSamples; done += n)
+		{
+			n = (numSamples - done < batch) ? numSamples - done : batch;
+			pGenerator->run(pBuffer, n);
+		}
+		nsPerSample[r] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - tBefore).count()
+			/ numSamples;
+	}
+	qsort(nsPerSample, numRepeats, sizeof(double), CompareDoubles);
+
+	// The latency: one API call at a time, which shows the refills of the per-call shape apart.
+	pResult->latencyUnit = (strcmp(pGenerator->shape, "call") == 0) ? 1 : batch;
+	for (size_t i = 0; i < numLatencyCalls; i++)
+	{
+		unsigned long long	ulClockBefore = ReadTSC();
+
+		pGenerator->run(pBuffer, pResult->latencyUnit);
+		pLatencies[i] = ReadTSC() - ulClockBefore;
+		pLatencies[i] = (pLatencies[i] > ulTSCOverhead) ? pLatencies[i] - ulTSCOverhead : 0;
+	}
+	qsort(pLatencies, numLatencyCalls, sizeof(unsigned long long), CompareULongLongs);
+
+	pResult->name = pGenerator->name;
+	pResult->shape = pGenerator->shape;
+	pResult->type = pGenerator->type;
+	pResult->numThreads = 1;
+	pResult->numSamples = numSamples;
+	pResult->nsPerSample = nsPerSample[numRepeats / 2];
+	pResult->samplesPerSecond = 1e9 / pResult->nsPerSample;
+	pResult->gbPerSecond = pResult->samplesPerSecond * pGenerator->sampleBytes / 1e9;
+	pResult->p50Ns = pLatencies[numLatencyCalls / 2] / tscGHz;
+	pResult->p99Ns = pLatencies[(size_t) (numLatencyCalls * 0.99)] / tscGHz;
+	pResult->maxNs = pLatencies[numLatencyCalls - 1] / tscGHz;
+}
+
+// RunParallelCase() measures one parallel fill of numSamples doubles on numThreads threads into *pResult.
+//     pReference holds the one-thread output; it returns false if the output differs from it.
+static bool	RunParallelCase(const BenchParallelGenerator *pGenerator, int numThreads, size_t numSamples,
+	int numRepeats, double *pOut, const double *pReference, BenchResult *pResult)
+{
+	double	nsPerCall[MAX_NUM_REPEATS];
+
+	pGenerator->fill(pOut, numSamples, 1, numThreads);
+	for (int r = 0; r < numRepeats; r++)
+	{
+		std::chrono::steady_clock::time_point	tBefore = std::chrono::steady_clock::now();
+
+		pGenerator->fill(pOut, numSamples, 1, numThreads);
+		nsPerCall[r] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - tBefore).count();
+	}
+	qsort(nsPerCall, numRepeats, sizeof(double), CompareDoubles);
+
+	pResult->name = pGenerator->name;
+	pResult->shape = "fill";
+	pResult->type = "double";
+	pResult->isa = "-";
+	pResult->engine = "-";
+	pResult->numThreads = numThreads;
+	pResult->numSamples = numSamples;
+	pResult->latencyUnit = numSamples;
+	pResult->nsPerSample = nsPerCall[numRepeats / 2] / numSamples;
+	pResult->samplesPerSecond = 1e9 / pResult->nsPerSample;
+	pResult->gbPerSecond = pResult->samplesPerSecond * sizeof(double) / 1e9;
+	pResult->p50Ns = nsPerCall[numRepeats / 2];
+	pResult->p99Ns = nsPerCall[(size_t) ((numRepeats - 1) * 0.99)];
+	pResult->maxNs = nsPerCall[numRepeats - 1];
+
+	return (pReference == NULL) || (memcmp(pOut, pReference, numSamples * sizeof(double)) == 0);
+}
+
+static void	WriteCSV(FILE *pFile, const BenchResult *pResults, int numResults)
+{
+	fprintf(pFile, "generator,shape,type,isa,engine,threads,samples,ns_per_sample,samples_per_s,gb_per_s,"
+		"latency_unit,p50_ns,p99_ns,max_ns\n");
+	for (int i = 0; i < numResults; i++)
+	{
+		const BenchResult	*p = &pResults[i];
+
+		fprintf(pFile, "%s,%s,%s,%s,%s,%d,%zu,%.4f,%.6g,%.4f,%zu,%.1f,%.1f,%.1f\n", p->name, p->shape, p->type,
+			p->isa, p->engine, p->numThreads, p->numSamples, p->nsPerSample, p->samplesPerSecond, p->gbPerSecond,
+			p->latencyUnit, p->p50Ns, p->p99Ns, p->maxNs);
+	}
+}
+
+static void	WriteJSON(FILE *pFile, const BenchResult *pResults, int numResults, double tscGHz, int cpu)
+{
+	fprintf(pFile, "{\n  \"tsc_ghz\": %.4f,\n  \"cpu\": %d,\n  \"results\": [\n", tscGHz, cpu);
+	for (int i = 0; i < numResults; i++)
+	{
+		const BenchResult	*p = &pResults[i];
+
+		fprintf(pFile, "    { \"generator\": \"%s\", \"shape\": \"%s\", \"type\": \"%s\", \"isa\": \"%s\", "
+			"\"engine\": \"%s\", \"threads\": %d, \"samples\": %zu, \"ns_per_sample\": %.4f, \"samples_per_s\": %.6g, "
+			"\"gb_per_s\": %.4f, \"latency_unit\": %zu, \"p50_ns\": %.1f, \"p99_ns\": %.1f, \"max_ns\": %.1f }%s\n",
+			p->name, p->shape, p->type, p->isa, p->engine, p->numThreads, p->numSamples, p->nsPerSample, p->samplesPerSecond,
+			p->gbPerSecond, p->latencyUnit, p->p50Ns, p->p99Ns, p->maxNs, (i + 1 < numResults) ? "," : "");
+	}
+	fprintf(pFile, "  ]\n}\n");
+}
+
+static int	Usage()
+{
+	fprintf(stderr, "Usage: CMiscRandBench [--samples N] [--batch N] [--warmup N] [--repeat N] [--latency N]\n"
+		"                      [--cpu K] [--threads N] [--filter TEXT] [--csv FILE] [--json FILE]\n");
+	return 2;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t		numSamples = DEFAULT_NUM_SAMPLES, batch = DEFAULT_BATCH, numWarmup = DEFAULT_NUM_WARMUP;
+	size_t		numLatencyCalls = DEFAULT_NUM_LATENCY_CALLS;
+	int			numRepeats = DEFAULT_NUM_REPEATS, cpu = -1, maxNumThreads = (int) std::thread::hardware_concurrency();
+	const char	*filter = NULL, *csvPath = NULL, *jsonPath = NULL;
+	const int	numGenerators = sizeof(benchGenerators) / sizeof(benchGenerators[0]);
+	const int	numParallelGenerators = sizeof(benchParallelGenerators) / sizeof(benchParallelGenerators[0]);
+	const int	maxNumResults = numGenerators * (MISCRAND_ISA_AVX512 + 1) * NUM_MISCRAND_ENGINES
+		+ numParallelGenerators * 32;
+	BenchResult			*pResults;
+	int					numResults = 0;
+	void				*pBuffer;
+	unsigned long long	*pLatencies;
+	double				tscGHz;
+	unsigned long long	ulTSCOverhead;
+
+	for (int a = 1; a < argc; a++)
+	{
+		if (a + 1 >= argc)
+			return Usage();
+		if (strcmp(argv[a], "--samples") == 0)
+			numSamples = strtoull(argv[++a], NULL, 0);
+		else if (strcmp(argv[a], "--batch") == 0)
+			batch = strtoull(argv[++a], NULL, 0);
+		else if (strcmp(argv[a], "--warmup") == 0)
+			numWarmup = strtoull(argv[++a], NULL, 0);
+		else if (strcmp(argv[a], "--repeat") == 0)
+			numRepeats = atoi(argv[++a]);
+		else if (strcmp(argv[a], "--latency") == 0)
+			numLatencyCalls = strtoull(argv[++a], NULL, 0);
+		else if (strcmp(argv[a], "--cpu") == 0)
+			cpu = atoi(argv[++a]);
+		else if (strcmp(argv[a], "--threads") == 0)
+			maxNumThreads = atoi(argv[++a]);
+		else if (strcmp(argv[a], "--filter") == 0)
+			filter = argv[++a];
+		else if (strcmp(argv[a], "--csv") == 0)
+			csvPath = argv[++a];
+		else if (strcmp(argv[a], "--json") == 0)
+			jsonPath = argv[++a];
+		else
+			return Usage();
+	}
+	if (maxNumThreads < 1)
+		maxNumThreads = 1;
+	if ((numSamples == 0) || (batch == 0) || (numLatencyCalls == 0) || (numRepeats < 1) || (numRepeats > MAX_NUM_REPEATS))
+		return Usage();
+
+	// The ring is created before we pin ourselves, so its producer thread is free to run on any other core.
+	pBenchRing = GaussianRandRingCreate(BENCH_RING_SIZE, BENCH_RING_LOW_WATERMARK, false, 1);
+	if (pBenchRing == NULL)
+	{
+		fprintf(stderr, "We cannot create the ring of GaussianRandRingNext().\n");
+		return 1;
+	}
+	pBenchSobol = SobolRandCreate(NUM_BENCH_SOBOL_DIM, MISCRAND_SOBOL_LINEAR_MATRIX, 1);
+	if (pBenchSobol == NULL)
+	{
+		fprintf(stderr, "We cannot create the Sobol sequence of SobolRandFill().\n");
+		return 1;
+	}
+
+	if ((cpu >= 0) && !PinToCPU(cpu))
+	{
+		fprintf(stderr, "We cannot pin the benchmark to logical processor %d.\n", cpu);
+		return 1;
+	}
+
+	pResults = (BenchResult *) malloc(maxNumResults * sizeof(BenchResult));
+	pBuffer = _mm_malloc(batch * sizeof(unsigned long long), 64);
+	pLatencies = (unsigned long long *) malloc(numLatencyCalls * sizeof(unsigned long long));
+	if ((pResults == NULL) || (pBuffer == NULL) || (pLatencies == NULL))
+	{
+		fprintf(stderr, "We cannot allocate the benchmark buffers.\n");
+		return 1;
+	}
+
+	tscGHz = MeasureTSCGHz();
+	ulTSCOverhead = MeasureTSCOverhead();
+	fprintf(stdout, "TSC runs at %.3f GHz; an empty pair of reads takes %llu cycles.\n\n", tscGHz, ulTSCOverhead);
+	fprintf(stdout, "%-22s %-5s %-7s %-7s %-13s %7s %10s %12s %8s %10s %10s %10s\n", "generator", "shape", "type",
+		"isa", "engine", "threads", "ns/sample", "samples/s", "GB/s", "p50 ns", "p99 ns", "max ns");
+
+	for (int g = 0; g < numGenerators; g++)
+	{
+		const BenchGenerator	*pGenerator = &benchGenerators[g];
+		MiscRandISA				savedISA = MISCRAND_ISA_SCALAR;
+
+		if ((filter != NULL) && (strstr(pGenerator->name, filter) == NULL))
+			continue;
+		if (pGenerator->setISA == GaussianRandVecSetISA)
+			savedISA = GaussianRandVecISA();
+		else if (pGenerator->setISA == GaussianRandZigSetISA)
+			savedISA = GaussianRandZigISA();
+		else if (pGenerator->setISA == RandEngineSetISA)
+			savedISA = RandEngineISA();
+		else if (pGenerator->setISA == UniformRandSetISA)
+			savedISA = UniformRandISA();
+		else if (pGenerator->setISA == RandDistributionsSetISA)
+			savedISA = RandDistributionsISA();
+		else if (pGenerator->setISA == MultivariateGaussianSetISA)
+			savedISA = MultivariateGaussianISA();
+		else if (pGenerator->setISA == GaussianNoiseSetISA)
+			savedISA = GaussianNoiseISA();
+		else if (pGenerator->setISA == GaussianRandInvSetISA)
+			savedISA = GaussianRandInvISA();
+		else if (pGenerator->setISA == SobolRandSetISA)
+			savedISA = SobolRandISA();
+
+		for (int isa = MISCRAND_ISA_SCALAR; isa <= MISCRAND_ISA_AVX512; isa++)
+		{
+			if ((pGenerator->setISA == NULL) ? (isa != MISCRAND_ISA_SCALAR) : !pGenerator->setISA((MiscRandISA) isa))
+				continue;
+
+			for (int e = 0; e < (pGenerator->bUsesEngine ? NUM_MISCRAND_ENGINES : 1); e++)
+			{
+				BenchResult	*pResult = &pResults[numResults++];
+
+				if (pGenerator->bUsesEngine)
+					RandEngineInit(&benchEngine, (MiscRandEngineType) e, 0);
+				RunCase(pGenerator, numSamples, batch, numWarmup, numRepeats, numLatencyCalls, tscGHz,
+					ulTSCOverhead, pBuffer, pLatencies, pResult);
+				pResult->isa = (pGenerator->setISA == NULL) ? "-" : isaNames[isa];
+				pResult->engine = pGenerator->bUsesEngine ? engineNames[e] : "-";
+
+				fprintf(stdout, "%-22s %-5s %-7s %-7s %-13s %7d %10.3f %12.4g %8.3f %10.1f %10.1f %10.1f\n",
+					pResult->name, pResult->shape, pResult->type, pResult->isa, pResult->engine, pResult->numThreads,
+					pResult->nsPerSample, pResult->samplesPerSecond, pResult->gbPerSecond, pResult->p50Ns,
+					pResult->p99Ns, pResult->maxNs);
+				fflush(stdout);
+			}
+		}
+
+		if (pGenerator->setISA != NULL)
+			pGenerator->setISA(savedISA);
+	}
+
+	for (int g = 0; g < numParallelGenerators; g++)
+	{
+		const BenchParallelGenerator	*pGenerator = &benchParallelGenerators[g];
+		double							*pOut, *pReference;
+		double							oneThreadNsPerSample = 0.0;
+
+		if ((filter != NULL) && (strstr(pGenerator->name, filter) == NULL))
+			continue;
+		pOut = (double *) _mm_malloc(numSamples * sizeof(double), 64);
+		pReference = (double *) _mm_malloc(numSamples * sizeof(double), 64);
+		if ((pOut == NULL) || (pReference == NULL))
+		{
+			fprintf(stderr, "We cannot allocate %zu samples for %s.\n", numSamples, pGenerator->name);
+			return 1;
+		}
+
+		// 1, 2, 4, ... threads, and maxNumThreads last if it is not a power of two.
+		for (int numThreads = 1; numThreads <= maxNumThreads;
+			numThreads = ((numThreads < maxNumThreads) && (numThreads * 2 > maxNumThreads)) ? maxNumThreads : numThreads * 2)
+		{
+			BenchResult	*pResult = &pResults[numResults++];
+			bool		bSame = RunParallelCase(pGenerator, numThreads, numSamples, numRepeats,
+				(numThreads == 1) ? pReference : pOut, (numThreads == 1) ? NULL : pReference, pResult);
+
+			if (numThreads == 1)
+				oneThreadNsPerSample = pResult->nsPerSample;
+			fprintf(stdout, "%-22s %-5s %-7s %-7s %-13s %7d %10.3f %12.4g %8.3f %10.1f %10.1f %10.1f  x%.2f%s\n",
+				pResult->name, pResult->shape, pResult->type, pResult->isa, pResult->engine, pResult->numThreads,
+				pResult->nsPerSample, pResult->samplesPerSecond, pResult->gbPerSecond, pResult->p50Ns,
+				pResult->p99Ns, pResult->maxNs, oneThreadNsPerSample / pResult->nsPerSample,
+				bSame ? "" : "  OUTPUT DIFFERS FROM ONE THREAD");
+			fflush(stdout);
+			if (!bSame)
+				return 1;
+		}
+
+		_mm_free(pOut);
+		_mm_free(pReference);
+	}
+
+	if (csvPath != NULL)
+	{
+		FILE	*pFile = fopen(csvPath, "w");
+
+		if (pFile == NULL)
+		{
+			fprintf(stderr, "We cannot write %s.\n", csvPath);
+			return 1;
+		}
+		WriteCSV(pFile, pResults, numResults);
+		fclose(pFile);
+	}
+	if (jsonPath != NULL)
+	{
+		FILE	*pFile = fopen(jsonPath, "w");
+
+		if (pFile == NULL)
+		{
+			fprintf(stderr, "We cannot write %s.\n", jsonPath);
+			return 1;
+		}
+		WriteJSON(pFile, pResults, numResults, tscGHz, cpu);
+		fclose(pFile);
+	}
+
+	SobolRandDestroy(pBenchSobol);
+	GaussianRandRingDestroy(pBenchRing);
+	_mm_free(pBuffer);
+	free(pLatencies);
+	free(pResults);
+	return 0;
+}
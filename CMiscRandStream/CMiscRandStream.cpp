@@ -0,0 +1,188 @@
+// CMiscRandStream.cpp : Writes and checks the precomputed random number stream files of RandStream.cpp.
+//
+// "write" generates a stream file, "info" prints its header, and "verify" replays it through RandStreamFill()
+//     against the numbers generated live from the same seed, over the whole file and --past numbers beyond
+//     its end, so it also checks that the live fallback continues the sequence.  verify returns 0 if all the
+//     numbers match bit for bit and 1 otherwise.
+//
+// Usage: CMiscRandStream write FILE [--type gaussian|gaussianfloat|uniform|uniformfloat] [--seed N] [--count N]
+//        CMiscRandStream info FILE
+//        CMiscRandStream verify FILE [--past N]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "MiscRand.h"
+
+#define DEFAULT_STREAM_COUNT		(1 << 24)
+#define DEFAULT_NUM_PAST			(1 << 20)
+#define NUM_VERIFY_CHUNK			65536		// Numbers compared at a time
+
+static const char	*streamTypeNames[NUM_MISCRAND_STREAMS] = { "gaussian", "gaussianfloat", "uniform", "uniformfloat" };
+
+static int	Usage()
+{
+	fprintf(stderr, "Usage: CMiscRandStream write FILE [--type gaussian|gaussianfloat|uniform|uniformfloat] [--seed N]\n"
+		"                       [--count N]\n"
+		"       CMiscRandStream info FILE\n"
+		"       CMiscRandStream verify FILE [--past N]\n");
+	return 2;
+}
+
+// StreamSampleBytes() returns the size of the numbers of a stream of the given type.
+static size_t	StreamSampleBytes(MiscRandStreamType type)
+{
+	return ((type == MISCRAND_STREAM_GAUSSIANRANDVEC) || (type == MISCRAND_STREAM_UNIFORMRAND)) ? sizeof(double)
+		: sizeof(float);
+}
+
+// GenerateLive() generates the next n numbers of a stream of the given type from *pState, the way the
+//     writer does.
+static void	GenerateLive(MiscRandState *pState, MiscRandStreamType type, void *pOut, size_t n)
+{
+	switch (type)
+	{
+	case MISCRAND_STREAM_GAUSSIANRANDVEC:
+		GaussianRandVecFill_r(pState, (double *) pOut, n);
+		break;
+	case MISCRAND_STREAM_GAUSSIANRANDVECFLOAT:
+		GaussianRandVecFloatFill_r(pState, (float *) pOut, n);
+		break;
+	case MISCRAND_STREAM_UNIFORMRAND:
+		UniformRandFill_r(pState, (double *) pOut, n, 0.0, 1.0);
+		break;
+	default:
+		UniformRandFillFloat_r(pState, (float *) pOut, n, 0.0f, 1.0f);
+		break;
+	}
+}
+
+static int	Write(const char *pPath, int argc, char *argv[])
+{
+	MiscRandStreamType	type = MISCRAND_STREAM_GAUSSIANRANDVEC;
+	unsigned long		seed = 1;
+	unsigned long long	count = DEFAULT_STREAM_COUNT;
+
+	for (int a = 0; a < argc; a++)
+	{
+		if (a + 1 >= argc)
+			return Usage();
+		if (strcmp(argv[a], "--type") == 0)
+		{
+			int		t;
+
+			a++;
+			for (t = 0; t < NUM_MISCRAND_STREAMS; t++)
+				if (strcmp(argv[a], streamTypeNames[t]) == 0)
+					break;
+			if (t == NUM_MISCRAND_STREAMS)
+				return Usage();
+			type = (MiscRandStreamType) t;
+		}
+		else if (strcmp(argv[a], "--seed") == 0)
+			seed = strtoul(argv[++a], NULL, 0);
+		else if (strcmp(argv[a], "--count") == 0)
+			count = strtoull(argv[++a], NULL, 0);
+		else
+			return Usage();
+	}
+
+	if (!RandStreamWriteFile(pPath, type, seed, count))
+	{
+		fprintf(stderr, "We cannot write %s.\n", pPath);
+		return 1;
+	}
+	printf("Wrote %s.\n", pPath);
+	return 0;
+}
+
+static int	Info(const char *pPath)
+{
+	RandStream			*pStream = RandStreamOpen(pPath, false);
+	MiscRandStreamType	type;
+	unsigned long		seed;
+	unsigned long long	count;
+
+	if (pStream == NULL)
+	{
+		fprintf(stderr, "%s is not a stream file we can read.\n", pPath);
+		return 1;
+	}
+	RandStreamInfo(pStream, &type, &seed, &count);
+	printf("type %s, seed %lu, %llu numbers of %u bytes\n", streamTypeNames[type], seed, count,
+		(unsigned int) StreamSampleBytes(type));
+	RandStreamClose(pStream);
+	return 0;
+}
+
+static int	Verify(const char *pPath, int argc, char *argv[])
+{
+	RandStream			*pStream;
+	MiscRandStreamType	type;
+	unsigned long		seed;
+	unsigned long long	count, numPast = DEFAULT_NUM_PAST, numMismatches = 0;
+	MiscRandState		state;
+	size_t				sampleBytes;
+	char				*pReplayed, *pLive;
+
+	for (int a = 0; a < argc; a++)
+	{
+		if ((a + 1 < argc) && (strcmp(argv[a], "--past") == 0))
+			numPast = strtoull(argv[++a], NULL, 0);
+		else
+			return Usage();
+	}
+
+	pStream = RandStreamOpen(pPath, false);
+	if (pStream == NULL)
+	{
+		fprintf(stderr, "%s is not a stream file we can read.\n", pPath);
+		return 1;
+	}
+	RandStreamInfo(pStream, &type, &seed, &count);
+	sampleBytes = StreamSampleBytes(type);
+	pReplayed = (char *) malloc(NUM_VERIFY_CHUNK * sampleBytes);
+	pLive = (char *) malloc(NUM_VERIFY_CHUNK * sampleBytes);
+	if ((pReplayed == NULL) || (pLive == NULL))
+	{
+		fprintf(stderr, "We cannot allocate the verification buffers.\n");
+		return 1;
+	}
+
+	SplitStreams(&state, 1, seed, 0);
+	for (unsigned long long done = 0; done < count + numPast; done += NUM_VERIFY_CHUNK)
+	{
+		size_t	n = (count + numPast - done < NUM_VERIFY_CHUNK) ? (size_t) (count + numPast - done) : NUM_VERIFY_CHUNK;
+
+		RandStreamFill(pStream, pReplayed, n);
+		GenerateLive(&state, type, pLive, n);
+		for (size_t i = 0; i < n; i++)
+			if (memcmp(pReplayed + i * sampleBytes, pLive + i * sampleBytes, sampleBytes) != 0)
+			{
+				if (numMismatches == 0)
+					fprintf(stderr, "Number %llu differs from the live one.\n", done + i);
+				numMismatches++;
+			}
+	}
+
+	printf("%s: %llu of %llu numbers in the file and %llu past its end differ.\n", pPath, numMismatches, count,
+		numPast);
+	free(pLive);
+	free(pReplayed);
+	RandStreamClose(pStream);
+	return (numMismatches == 0) ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+		return Usage();
+	if (strcmp(argv[1], "write") == 0)
+		return Write(argv[2], argc - 3, argv + 3);
+	else if ((strcmp(argv[1], "info") == 0) && (argc == 3))
+		return Info(argv[2]);
+	else if (strcmp(argv[1], "verify") == 0)
+		return Verify(argv[2], argc - 3, argv + 3);
+	else
+		return Usage();
+}
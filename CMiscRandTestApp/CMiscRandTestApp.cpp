@@ -4,7 +4,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <immintrin.h>
-#include <intrin.h>
 #include "MiscRand.h"
 #include "cpudetect.h"
 
@@ -247,13 +246,13 @@ int main(int argc, char* argv[])
 	}
 #endif
 	// In the sixth part, we generate many normally distributed random variables with SIMD and showing the performance statistics.
+	// The loop is timed as a whole: a pair of __rdtsc() reads around each call costs more than the call itself.  For
+	//     throughput and latency percentiles of every generator, instruction set and engine, run CMiscRandBench.
 	{
 		double            fRdSample;
 		double            fSumSamples = 0.0, fSumSampleSquares = 0.0;
-		double            fSumCycles = 0.0;
+		double            fSumCycles;
 		unsigned int      uNumGoodSamples;
-		unsigned int      uMinRDCycles = UINT_MAX, uMinRDCount = 0;
-		unsigned int      uMaxRDCycles = 0, uMaxRDCount = 0;
 		unsigned long long  ulClockBefore, ulClockAfter;
 		double (*GaussianRand_ptr)() = NULL;
 		unsigned int	  uGaussianBinCounts[NUM_GAUSSIAN_BINS];
@@ -273,18 +272,27 @@ int main(int argc, char* argv[])
 			return 1;
 		}
 
+		// getCpuFeatures() has the snapshot the dispatchers chose their kernels from.
+		const CpuFeatures	*pFeatures = getCpuFeatures();
+		fprintf(stdout, "%s: OS saves %s; SSE4.1 %d, AVX %d, AVX2 %d, FMA %d, AVX-512 F %d DQ %d VL %d BW %d, "
+			"RDRAND %d, RDSEED %d.\n", pFeatures->vendor,
+			pFeatures->bOSAVX512State ? "XMM/YMM/ZMM" : (pFeatures->bOSAVXState ? "XMM/YMM" : "XMM only"),
+			pFeatures->bSSE41, pFeatures->bAVX, pFeatures->bAVX2, pFeatures->bFMA, pFeatures->bAVX512F,
+			pFeatures->bAVX512DQ, pFeatures->bAVX512VL, pFeatures->bAVX512BW, pFeatures->bRDRAND, pFeatures->bRDSEED);
+
 		uNumGoodSamples = 0;
-		// Using GaussianRandVec() when both AVX and AVX2 are supported.
-		GaussianRand_ptr = supportAVX512F() ? GaussianRandVec : GaussianRand;
+		// GaussianRandVec() picks the fastest kernel the processor supports by itself.
+		static const char	*isaNames[] = { "plain C", "SSE4.1", "AVX2", "AVX512" };
+		fprintf(stdout, "GaussianRandVec() runs on its %s kernel.\n", isaNames[GaussianRandVecISA()]);
+		GaussianRand_ptr = GaussianRandVec;
 
 		for (i = 0; i < NUM_GAUSSIAN_BINS; i++)
 			uGaussianBinCounts[i] = 0;
 
+		ulClockBefore = __rdtsc();
 		for (i = 0; i < NUM_RDRAND_ITERATIONS; i++) {
 
-			ulClockBefore = __rdtsc();
 			fRdSample = GaussianRand_ptr();
-			ulClockAfter = __rdtsc();
 
 			// Updating all the related statistics.
 			fSumSamples += fRdSample;
@@ -295,31 +303,10 @@ int main(int argc, char* argv[])
 			if ((iBinIndex >= 0) && (iBinIndex < NUM_GAUSSIAN_BINS))
 				uGaussianBinCounts[iBinIndex]++;
 
-			unsigned long   uElapsedCycles = (unsigned long)(ulClockAfter - ulClockBefore);
-			fSumCycles += (double)uElapsedCycles;
-			if (uElapsedCycles == uMinRDCycles)
-			{
-				uMinRDCount++;
-			}
-			else if (uElapsedCycles == uMaxRDCycles)
-			{
-				uMaxRDCount++;
-			}
-			else if (uElapsedCycles < uMinRDCycles)
-			{
-				// We have a new minimum cycle count from RDRAND.
-				uMinRDCycles = uElapsedCycles;
-				uMinRDCount = 1;
-			}
-			else if (uElapsedCycles > uMaxRDCycles)
-			{
-				// We have a new maximum cycle count from RDRAND.
-				uMaxRDCycles = uElapsedCycles;
-				uMaxRDCount = 1;
-			}
-
 			uNumGoodSamples++;
 		}
+		ulClockAfter = __rdtsc();
+		fSumCycles = (double)(ulClockAfter - ulClockBefore);
 
 		// Showing all the statistics.
 		if (uNumGoodSamples)
@@ -332,9 +319,7 @@ int main(int argc, char* argv[])
 			fSumCycles /= uNumGoodSamples;
 			fprintf(stdout, "Mean of all %u samples: %lf\n", uNumGoodSamples, fSumSamples);
 			fprintf(stdout, "Variance of all %u samples: %lf\n", uNumGoodSamples, fSumSampleSquares);
-			fprintf(stdout, "On average each GaussianRandVec() call costs %lf cycles.\n", fSumCycles);
-			fprintf(stdout, "Minimum cycles GaussianRandVec() took is %lu cycles, occurring %lu times.\n", uMinRDCycles, uMinRDCount);
-			fprintf(stdout, "Maximum cycles GaussianRandVec() took is %lu cycles, occurring %lu times.\n", uMaxRDCycles, uMaxRDCount);
+			fprintf(stdout, "On average each GaussianRandVec() call, with its binning, costs %lf cycles.\n", fSumCycles);
 		}
 		else
 		{
@@ -347,6 +332,220 @@ int main(int argc, char* argv[])
 			fprintf(stdout, "%2dth bin (from %+f to %+f) contains %5d samples.\n", i,
 				(-GAUSSIAN_BIN_RANGE + i * dfGaussianBinGap), (-GAUSSIAN_BIN_RANGE + (i + 1) * dfGaussianBinGap),
 				uGaussianBinCounts[i]);
+
+		// With MISCRAND_INSTRUMENTATION defined, the counters show what the loop above cost inside GaussianRandVec().
+		if (MiscRandCountersEnabled())
+		{
+			MiscRandCounters	counters;
+
+			MiscRandCountersSnapshot(&counters);
+			fprintf(stdout, "\n%llu refills ran %llu blocks with %lf rejection rounds per block and %lf frozen lanes "
+				"per round.\n", counters.numRefills, counters.numBlocks,
+				counters.numBlocks ? (double)counters.numRejectionRounds / counters.numBlocks : 0.0,
+				counters.numRejectionRounds ? (double)counters.numFrozenLanes / counters.numRejectionRounds : 0.0);
+			fprintf(stdout, "%llu samples took %llu cycles to refill and %llu cycles to serve.\n", counters.numSamples,
+				counters.refillCycles, counters.serveCycles);
+			MiscRandCountersReset();
+		}
+	}
+
+	// In the seventh part, we generate the same amount of normally distributed random variables in one
+	//     GaussianRandVecFill() call and compare the per-sample cost against the sixth part.
+	{
+		double            *pSamples;
+		double            fSumSamples = 0.0, fSumSampleSquares = 0.0;
+		unsigned long long  ulClockBefore, ulClockAfter;
+
+		fprintf(stdout, "\n\n====== Part Seven ======\n");
+
+		pSamples = (double *) malloc(NUM_RDRAND_ITERATIONS * sizeof(double));
+		if (pSamples == NULL)
+		{
+			fprintf(stderr, "We cannot allocate %u doubles for GaussianRandVecFill().\n", NUM_RDRAND_ITERATIONS);
+			return 1;
+		}
+
+		ulClockBefore = __rdtsc();
+		GaussianRandVecFill(pSamples, NUM_RDRAND_ITERATIONS);
+		ulClockAfter = __rdtsc();
+
+		for (i = 0; i < NUM_RDRAND_ITERATIONS; i++)
+		{
+			fSumSamples += pSamples[i];
+			fSumSampleSquares += pSamples[i] * pSamples[i];
+		}
+		free(pSamples);
+
+		// E(X) = Sum(X)/N
+		fSumSamples /= NUM_RDRAND_ITERATIONS;
+		// Var(X) = Sum(X^2)/N - E(X)*E(X)
+		fSumSampleSquares = fSumSampleSquares / NUM_RDRAND_ITERATIONS - fSumSamples * fSumSamples;
+
+		fprintf(stdout, "Mean of all %u samples: %lf\n", NUM_RDRAND_ITERATIONS, fSumSamples);
+		fprintf(stdout, "Variance of all %u samples: %lf\n", NUM_RDRAND_ITERATIONS, fSumSampleSquares);
+		fprintf(stdout, "On average each sample from GaussianRandVecFill() costs %lf cycles.\n",
+			(double)(ulClockAfter - ulClockBefore) / NUM_RDRAND_ITERATIONS);
+	}
+
+	// In the eighth part, we repeat the seventh part with the Ziggurat method, GaussianRandZigFill(), so
+	//     that the two methods can be compared against each other.
+	{
+		double            *pSamples;
+		double            fSumSamples = 0.0, fSumSampleSquares = 0.0;
+		unsigned long long  ulClockBefore, ulClockAfter;
+
+		fprintf(stdout, "\n\n====== Part Eight ======\n");
+
+		pSamples = (double *) malloc(NUM_RDRAND_ITERATIONS * sizeof(double));
+		if (pSamples == NULL)
+		{
+			fprintf(stderr, "We cannot allocate %u doubles for GaussianRandZigFill().\n", NUM_RDRAND_ITERATIONS);
+			return 1;
+		}
+
+		ulClockBefore = __rdtsc();
+		GaussianRandZigFill(pSamples, NUM_RDRAND_ITERATIONS);
+		ulClockAfter = __rdtsc();
+
+		for (i = 0; i < NUM_RDRAND_ITERATIONS; i++)
+		{
+			fSumSamples += pSamples[i];
+			fSumSampleSquares += pSamples[i] * pSamples[i];
+		}
+		free(pSamples);
+
+		// E(X) = Sum(X)/N
+		fSumSamples /= NUM_RDRAND_ITERATIONS;
+		// Var(X) = Sum(X^2)/N - E(X)*E(X)
+		fSumSampleSquares = fSumSampleSquares / NUM_RDRAND_ITERATIONS - fSumSamples * fSumSamples;
+
+		fprintf(stdout, "Mean of all %u samples: %lf\n", NUM_RDRAND_ITERATIONS, fSumSamples);
+		fprintf(stdout, "Variance of all %u samples: %lf\n", NUM_RDRAND_ITERATIONS, fSumSampleSquares);
+		fprintf(stdout, "On average each sample from GaussianRandZigFill() costs %lf cycles.\n",
+			(double)(ulClockAfter - ulClockBefore) / NUM_RDRAND_ITERATIONS);
+	}
+
+	// In the ninth part, we drive the Ziggurat method with each of the 64-bit engines instead of the LCG
+	//     lanes, and time the engines alone by their uniform doubles as well.
+	{
+		static const char	*engineNames[NUM_MISCRAND_ENGINES] = { "xoshiro256**", "PCG64", "Philox4x32-10" };
+		MiscRandEngine		engine;
+		double            *pSamples;
+		unsigned long long  ulClockBefore, ulClockAfter;
+		int					iEngine;
+
+		fprintf(stdout, "\n\n====== Part Nine ======\n");
+
+		pSamples = (double *) malloc(NUM_RDRAND_ITERATIONS * sizeof(double));
+		if (pSamples == NULL)
+		{
+			fprintf(stderr, "We cannot allocate %u doubles for the engines.\n", NUM_RDRAND_ITERATIONS);
+			return 1;
+		}
+
+		for (iEngine = 0; iEngine < NUM_MISCRAND_ENGINES; iEngine++)
+		{
+			double            fSumSamples = 0.0, fSumSampleSquares = 0.0;
+
+			RandEngineInit(&engine, (MiscRandEngineType) iEngine, RAND_SEED);
+
+			ulClockBefore = __rdtsc();
+			RandEngineFillDouble(&engine, pSamples, NUM_RDRAND_ITERATIONS);
+			ulClockAfter = __rdtsc();
+			fprintf(stdout, "On average each uniform double from %s costs %lf cycles.\n", engineNames[iEngine],
+				(double)(ulClockAfter - ulClockBefore) / NUM_RDRAND_ITERATIONS);
+
+			ulClockBefore = __rdtsc();
+			GaussianRandZigEngineFill(&engine, pSamples, NUM_RDRAND_ITERATIONS);
+			ulClockAfter = __rdtsc();
+
+			for (i = 0; i < NUM_RDRAND_ITERATIONS; i++)
+			{
+				fSumSamples += pSamples[i];
+				fSumSampleSquares += pSamples[i] * pSamples[i];
+			}
+			fSumSamples /= NUM_RDRAND_ITERATIONS;
+			fSumSampleSquares = fSumSampleSquares / NUM_RDRAND_ITERATIONS - fSumSamples * fSumSamples;
+
+			fprintf(stdout, "Mean and variance of %u Ziggurat samples from %s: %lf, %lf\n", NUM_RDRAND_ITERATIONS,
+				engineNames[iEngine], fSumSamples, fSumSampleSquares);
+			fprintf(stdout, "On average each such sample costs %lf cycles.\n",
+				(double)(ulClockAfter - ulClockBefore) / NUM_RDRAND_ITERATIONS);
+		}
+		free(pSamples);
+	}
+
+	// In the tenth part, we repeat the seventh part with the float version, GaussianRandVecFloatFill(),
+	//     which runs twice as many lanes per instruction and writes half as many bytes.
+	{
+		float             *pSamples;
+		double            fSumSamples = 0.0, fSumSampleSquares = 0.0;
+		unsigned long long  ulClockBefore, ulClockAfter;
+
+		fprintf(stdout, "\n\n====== Part Ten ======\n");
+
+		pSamples = (float *) malloc(NUM_RDRAND_ITERATIONS * sizeof(float));
+		if (pSamples == NULL)
+		{
+			fprintf(stderr, "We cannot allocate %u floats for GaussianRandVecFloatFill().\n", NUM_RDRAND_ITERATIONS);
+			return 1;
+		}
+
+		ulClockBefore = __rdtsc();
+		GaussianRandVecFloatFill(pSamples, NUM_RDRAND_ITERATIONS);
+		ulClockAfter = __rdtsc();
+
+		for (i = 0; i < NUM_RDRAND_ITERATIONS; i++)
+		{
+			fSumSamples += pSamples[i];
+			fSumSampleSquares += (double) pSamples[i] * pSamples[i];
+		}
+		free(pSamples);
+
+		fSumSamples /= NUM_RDRAND_ITERATIONS;
+		fSumSampleSquares = fSumSampleSquares / NUM_RDRAND_ITERATIONS - fSumSamples * fSumSamples;
+
+		fprintf(stdout, "Mean of all %u samples: %lf\n", NUM_RDRAND_ITERATIONS, fSumSamples);
+		fprintf(stdout, "Variance of all %u samples: %lf\n", NUM_RDRAND_ITERATIONS, fSumSampleSquares);
+		fprintf(stdout, "On average each sample from GaussianRandVecFloatFill() costs %lf cycles.\n",
+			(double)(ulClockAfter - ulClockBefore) / NUM_RDRAND_ITERATIONS);
+	}
+
+	// In the eleventh part, we repeat the seventh part with the lane-compacting kernels,
+	//     GaussianRandVecCompactFill(), which keep every lane drawing instead of waiting for the last
+	//     rejecting one.
+	{
+		double            *pSamples;
+		double            fSumSamples = 0.0, fSumSampleSquares = 0.0;
+		unsigned long long  ulClockBefore, ulClockAfter;
+
+		fprintf(stdout, "\n\n====== Part Eleven ======\n");
+
+		pSamples = (double *) malloc(NUM_RDRAND_ITERATIONS * sizeof(double));
+		if (pSamples == NULL)
+		{
+			fprintf(stderr, "We cannot allocate %u doubles for GaussianRandVecCompactFill().\n", NUM_RDRAND_ITERATIONS);
+			return 1;
+		}
+
+		ulClockBefore = __rdtsc();
+		GaussianRandVecCompactFill(pSamples, NUM_RDRAND_ITERATIONS);
+		ulClockAfter = __rdtsc();
+
+		for (i = 0; i < NUM_RDRAND_ITERATIONS; i++)
+		{
+			fSumSamples += pSamples[i];
+			fSumSampleSquares += pSamples[i] * pSamples[i];
+		}
+		free(pSamples);
+
+		fSumSamples /= NUM_RDRAND_ITERATIONS;
+		fSumSampleSquares = fSumSampleSquares / NUM_RDRAND_ITERATIONS - fSumSamples * fSumSamples;
+
+		fprintf(stdout, "Mean of all %u samples: %lf\n", NUM_RDRAND_ITERATIONS, fSumSamples);
+		fprintf(stdout, "Variance of all %u samples: %lf\n", NUM_RDRAND_ITERATIONS, fSumSampleSquares);
+		fprintf(stdout, "On average each sample from GaussianRandVecCompactFill() costs %lf cycles.\n",
+			(double)(ulClockAfter - ulClockBefore) / NUM_RDRAND_ITERATIONS);
 	}
 
 	return 0;
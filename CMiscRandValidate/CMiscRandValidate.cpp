@@ -0,0 +1,687 @@
+// CMiscRandValidate.cpp : Statistical validation of every generator in CMiscRand, for gating new kernels.
+//
+// Each case is one generator, one instruction set and, for the engine-driven generators, one engine, like the
+//     cases of CMiscRandBench.  A case generates --samples numbers on --threads threads, each thread from its
+//     own SplitStreams() stream (or its own engine seeded with --seed plus the thread number), and every
+//     thread runs its blocks through the statistics as it goes, so nothing but one block per thread is ever
+//     kept.  The statistics are tested against the normal or the uniform distribution on [0, 1):
+//     - chi-square over about NUM_CHISQUARE_BINS bins of equal probability;
+//     - Kolmogorov-Smirnov and Anderson-Darling against the distribution function F, at the resolution of the
+//       NUM_VALIDATE_BINS bins of equal width the threads histogram the numbers into, the empirical
+//       distribution function taken as linear within each bin;
+//     - the mean of z, z^2, z^3 and z^4 for the standardized numbers z = (x - mean) / standard deviation;
+//     - the correlation of z at lags 1 to --lags;
+//     - the correlation between the NUM_VALIDATE_LANES positions of each group of NUM_VALIDATE_LANES numbers,
+//       which is where the lanes of the vectorized kernels land.
+//     The moments and the correlations are sums of products the SSE2 loops below accumulate two at a time,
+//     the correlations of every lag in NUM_VALIDATE_LANES sums by position, which give the lanes as well.
+//     A family of z-scores takes the smallest of their p-values, corrected for the number of them.  A case
+//     fails if any p-value is below --alpha or if it generates a number that is not finite.
+//
+// After the generators come the boundary cases of TruncatedGaussianFill(), intervals out in the tails, empty
+//     or with NaN bounds: each must return NUM_VALIDATE_BLOCK numbers in its interval, or NaNs for the empty
+//     ones, rather than loop forever as such intervals once did.
+//
+// The generators built on the linear congruential generator repeat after 2^32 steps per lane, shared by the
+//     NUM_SPLIT_SLICES slices of SplitStreams(), so beyond about 10^9 numbers their cases test that limit.
+//
+// CMiscRandValidate returns 0 if every case passes, 1 if any fails and 2 on bad arguments.  Every case passes
+//     with the default arguments.  Each generator case runs six tests at --alpha 1e-6, so a sound generator
+//     fails a case with probability about 6e-6, and a default run is meant to gate changes to the kernels: any
+//     failure is a regression to look at.
+//
+// Usage: CMiscRandValidate [--samples N] [--threads N] [--seed N] [--alpha P] [--lags N] [--filter TEXT]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <emmintrin.h>
+#include "MiscRand.h"
+
+#define DEFAULT_NUM_SAMPLES			(1 << 26)
+#define DEFAULT_ALPHA				1e-6
+#define DEFAULT_NUM_LAGS			16
+#define MAX_NUM_LAGS				256
+#define NUM_VALIDATE_BLOCK			16384		// Numbers generated and tallied at a time
+#define NUM_VALIDATE_BINS			(1 << 18)	// Bins of the histogram
+#define NUM_CHISQUARE_BINS			1024		// About as many bins of the chi-square test, histogram bins merged
+#define NUM_VALIDATE_LANES			16			// The widest kernels run 16 lanes
+#define NUM_VALIDATE_MOMENTS		4
+
+// ValidateDistribution is what a generator should follow: its mean, standard deviation, distribution
+//     function, the range [lo, hi) the histogram covers, the bins at either end taking whatever falls
+//     outside, and E(z^k), k = 0, ..., 2 * NUM_VALIDATE_MOMENTS, for the standardized numbers z.
+typedef struct ValidateDistribution
+{
+	double			mean, stddev;
+	double			(*cdf)(double x);
+	double			lo, hi;
+	double			moments[2 * NUM_VALIDATE_MOMENTS + 1];
+} ValidateDistribution;
+
+static double	NormalCDF(double x)
+{
+	return 0.5 * erfc(-x * 0.70710678118654752440);
+}
+
+static double	UniformCDF(double x)
+{
+	return x;
+}
+
+// The standardized uniform numbers are uniform on [-sqrt(3), sqrt(3)), so E(z^2k) = 3^k / (2k + 1).
+static const ValidateDistribution	normalDistribution = { 0.0, 1.0, NormalCDF, -8.0, 8.0,
+	{ 1.0, 0.0, 1.0, 0.0, 3.0, 0.0, 15.0, 0.0, 105.0 } };
+static const ValidateDistribution	uniformDistribution = { 0.5, 0.28867513459481288225, UniformCDF, 0.0, 1.0,
+	{ 1.0, 0.0, 1.0, 0.0, 9.0 / 5.0, 0.0, 27.0 / 7.0, 0.0, 9.0 } };
+
+// ValidateThread is what one thread generates from.
+typedef struct alignas(64) ValidateThread
+{
+	MiscRandState	state;
+	MiscRandEngine	engine;
+} ValidateThread;
+
+typedef void (*ValidateFill_t)(ValidateThread *pThread, double *pOut, size_t n);
+typedef bool (MISCRAND_CDECL *ValidateSetISA_t)(MiscRandISA isa);
+
+// ValidateGenerator describes one generator; main() expands it into one case per instruction set and per
+//     engine (when bUsesEngine is set), as CMiscRandBench does.
+typedef struct ValidateGenerator
+{
+	const char					*name;
+	const ValidateDistribution	*pDistribution;
+	ValidateSetISA_t			setISA;				// NULL if the generator has only one kernel
+	bool						bUsesEngine;
+	ValidateFill_t				fill;				// Writes n numbers to pOut, as doubles
+} ValidateGenerator;
+
+// WidenFloats() turns the n floats at the start of pOut into n doubles in place.  It goes from the end, so
+//     double i, which takes floats 2i and 2i + 1, never overwrites a float it has not read yet.
+static void	WidenFloats(double *pOut, size_t n)
+{
+	const float	*pFloats = (const float *) pOut;
+
+	while (n > 0)
+	{
+		n--;
+		pOut[n] = pFloats[n];
+	}
+}
+
+static void	FillUniformRand(ValidateThread *pThread, double *pOut, size_t n)
+{
+	UniformRandFill_r(&pThread->state, pOut, n, 0.0, 1.0);
+}
+
+static void	FillUniformRandFloat(ValidateThread *pThread, double *pOut, size_t n)
+{
+	UniformRandFillFloat_r(&pThread->state, (float *) pOut, n, 0.0f, 1.0f);
+	WidenFloats(pOut, n);
+}
+
+static void	FillGaussianRandVec(ValidateThread *pThread, double *pOut, size_t n)
+{
+	GaussianRandVecFill_r(&pThread->state, pOut, n);
+}
+
+static void	FillGaussianRandVecCompact(ValidateThread *pThread, double *pOut, size_t n)
+{
+	GaussianRandVecCompactFill_r(&pThread->state, pOut, n);
+}
+
+static void	FillGaussianRandVecFloat(ValidateThread *pThread, double *pOut, size_t n)
+{
+	GaussianRandVecFloatFill_r(&pThread->state, (float *) pOut, n);
+	WidenFloats(pOut, n);
+}
+
+static void	FillGaussianRandZig(ValidateThread *pThread, double *pOut, size_t n)
+{
+	GaussianRandZigFill_r(&pThread->state, pOut, n);
+}
+
+static void	FillGaussianRandZigEngine(ValidateThread *pThread, double *pOut, size_t n)
+{
+	GaussianRandZigEngineFill(&pThread->engine, pOut, n);
+}
+
+static void	FillGaussianRandInv(ValidateThread *pThread, double *pOut, size_t n)
+{
+	GaussianRandInvFill_r(&pThread->state, pOut, n);
+}
+
+static void	FillAddGaussianNoise(ValidateThread *pThread, double *pOut, size_t n)
+{
+	memset(pOut, 0, n * sizeof(double));
+	AddGaussianNoise_r(&pThread->state, pOut, n, 1.0, 0.0);
+}
+
+static void	FillRandEngineDouble(ValidateThread *pThread, double *pOut, size_t n)
+{
+	RandEngineFillDouble(&pThread->engine, pOut, n);
+}
+
+static const ValidateGenerator	validateGenerators[] =
+{
+	{ "UniformRandFill", &uniformDistribution, UniformRandSetISA, false, FillUniformRand },
+	{ "UniformRandFillFloat", &uniformDistribution, UniformRandSetISA, false, FillUniformRandFloat },
+	{ "GaussianRandVecFill", &normalDistribution, GaussianRandVecSetISA, false, FillGaussianRandVec },
+	{ "GaussianRandVecCompactFill", &normalDistribution, GaussianRandVecSetISA, false, FillGaussianRandVecCompact },
+	{ "GaussianRandVecFloatFill", &normalDistribution, GaussianRandVecSetISA, false, FillGaussianRandVecFloat },
+	{ "GaussianRandZigFill", &normalDistribution, GaussianRandZigSetISA, false, FillGaussianRandZig },
+	{ "GaussianRandZigEngineFill", &normalDistribution, GaussianRandZigSetISA, true, FillGaussianRandZigEngine },
+	{ "GaussianRandInvFill", &normalDistribution, GaussianRandInvSetISA, false, FillGaussianRandInv },
+	{ "AddGaussianNoise", &normalDistribution, GaussianNoiseSetISA, false, FillAddGaussianNoise },
+	{ "RandEngineFillDouble", &uniformDistribution, RandEngineSetISA, true, FillRandEngineDouble },
+};
+
+// ValidateTruncation is a boundary case of TruncatedGaussianFill(): [a, b] is empty or has a NaN bound iff
+//     bEmpty is set.
+typedef struct ValidateTruncation
+{
+	double		a, b;
+	bool		bEmpty;
+} ValidateTruncation;
+
+static const ValidateTruncation	validateTruncations[] =
+{
+	{ 30.0, HUGE_VAL, false },
+	{ 1e8, HUGE_VAL, false },
+	{ 1e200, HUGE_VAL, false },
+	{ 1e200, 2e200, false },
+	{ -HUGE_VAL, -1e200, false },
+	{ 2.0, 1.0, true },
+	{ 1.0, 1.0, true },
+	{ NAN, 1.0, true },
+	{ 0.0, NAN, true },
+};
+
+static const char	*isaNames[] = { "scalar", "sse41", "avx2", "avx512" };
+static const char	*engineNames[NUM_MISCRAND_ENGINES] = { "xoshiro256ss", "pcg64", "philox4x32" };
+
+// ValidateTally holds the sums one thread accumulated; main() adds those of all the threads up.
+typedef struct alignas(64) ValidateTally
+{
+	unsigned int		bins[NUM_VALIDATE_BINS];
+	double				momentSums[NUM_VALIDATE_MOMENTS];		// Sums of z, z^2, z^3 and z^4
+	double				lagSums[MAX_NUM_LAGS][NUM_VALIDATE_LANES];		// [lag - 1][i % NUM_VALIDATE_LANES]: sums
+	unsigned long long	numLagPairs[MAX_NUM_LAGS][NUM_VALIDATE_LANES];	//     of z[i] * z[i + lag], and their counts
+	unsigned long long	numSamples;
+	unsigned long long	numNonFinite;
+} ValidateTally;
+
+// LagSumsSSE2() adds z[i] * z[i + lag] to pSums[i % NUM_VALIDATE_LANES] and counts them in pCounts[], for
+//     i = 0, ..., n - lag - 1.  The sums over all i make the lag correlation, and for lag < NUM_VALIDATE_LANES
+//     the sums of i % NUM_VALIDATE_LANES = a < NUM_VALIDATE_LANES - lag make the correlation between
+//     positions a and a + lag of the groups, so one pass serves both.
+static void	LagSumsSSE2(const double *pZ, size_t n, int lag, double *pSums, unsigned long long *pCounts)
+{
+	__m128d	sums[NUM_VALIDATE_LANES / 2];
+	size_t	numPairs = n - lag;
+	size_t	i;
+
+	for (int k = 0; k < NUM_VALIDATE_LANES / 2; k++)
+		sums[k] = _mm_loadu_pd(pSums + 2 * k);
+	for (i = 0; i + NUM_VALIDATE_LANES <= numPairs; i += NUM_VALIDATE_LANES)
+		for (int k = 0; k < NUM_VALIDATE_LANES / 2; k++)
+			sums[k] = _mm_add_pd(sums[k], _mm_mul_pd(_mm_loadu_pd(pZ + i + 2 * k), _mm_loadu_pd(pZ + i + lag + 2 * k)));
+	for (int k = 0; k < NUM_VALIDATE_LANES / 2; k++)
+		_mm_storeu_pd(pSums + 2 * k, sums[k]);
+	for (int a = 0; a < NUM_VALIDATE_LANES; a++)
+		pCounts[a] += i / NUM_VALIDATE_LANES;
+	for (; i < numPairs; i++)
+	{
+		pSums[i % NUM_VALIDATE_LANES] += pZ[i] * pZ[i + lag];
+		pCounts[i % NUM_VALIDATE_LANES]++;
+	}
+}
+
+// TallyBlock() adds the n numbers of pBlock to *pTally.  It overwrites pBlock with the standardized numbers.
+static void	TallyBlock(const ValidateDistribution *pDistribution, int numLags, double *pBlock, size_t n,
+	ValidateTally *pTally)
+{
+	const double	invStddev = 1.0 / pDistribution->stddev;
+	const double	binScale = NUM_VALIDATE_BINS / (pDistribution->hi - pDistribution->lo);
+	__m128d			sum1 = _mm_setzero_pd(), sum2 = _mm_setzero_pd(), sum3 = _mm_setzero_pd(), sum4 = _mm_setzero_pd();
+	double			sums[2];
+	size_t			i;
+
+	// The histogram, which also catches the numbers that are not finite; they count as the mean.
+	for (i = 0; i < n; i++)
+	{
+		double	x = pBlock[i];
+		double	t;
+
+		if (!isfinite(x))
+		{
+			pTally->numNonFinite++;
+			x = pDistribution->mean;
+		}
+		t = (x - pDistribution->lo) * binScale;
+		t = (t < 0.0) ? 0.0 : ((t > NUM_VALIDATE_BINS - 1) ? NUM_VALIDATE_BINS - 1 : t);
+		pTally->bins[(int) t]++;
+		pBlock[i] = (x - pDistribution->mean) * invStddev;
+	}
+
+	// The moments, two numbers at a time.
+	for (i = 0; i + 2 <= n; i += 2)
+	{
+		__m128d	z = _mm_loadu_pd(pBlock + i);
+		__m128d	z2 = _mm_mul_pd(z, z);
+
+		sum1 = _mm_add_pd(sum1, z);
+		sum2 = _mm_add_pd(sum2, z2);
+		sum3 = _mm_add_pd(sum3, _mm_mul_pd(z2, z));
+		sum4 = _mm_add_pd(sum4, _mm_mul_pd(z2, z2));
+	}
+	_mm_storeu_pd(sums, sum1);
+	pTally->momentSums[0] += sums[0] + sums[1];
+	_mm_storeu_pd(sums, sum2);
+	pTally->momentSums[1] += sums[0] + sums[1];
+	_mm_storeu_pd(sums, sum3);
+	pTally->momentSums[2] += sums[0] + sums[1];
+	_mm_storeu_pd(sums, sum4);
+	pTally->momentSums[3] += sums[0] + sums[1];
+	for (; i < n; i++)
+	{
+		double	z2 = pBlock[i] * pBlock[i];
+
+		pTally->momentSums[0] += pBlock[i];
+		pTally->momentSums[1] += z2;
+		pTally->momentSums[2] += z2 * pBlock[i];
+		pTally->momentSums[3] += z2 * z2;
+	}
+
+	// The lags, within the block only, and the lanes with them.
+	for (int lag = 1; (lag <= numLags) || (lag < NUM_VALIDATE_LANES); lag++)
+		if ((size_t) lag < n)
+			LagSumsSSE2(pBlock, n, lag, pTally->lagSums[lag - 1], pTally->numLagPairs[lag - 1]);
+	pTally->numSamples += n;
+}
+
+// ValidateWorker() generates numSamples numbers from *pThread with pGenerator and tallies them into *pTally.
+static void	ValidateWorker(const ValidateGenerator *pGenerator, int numLags, ValidateThread *pThread,
+	unsigned long long numSamples, ValidateTally *pTally)
+{
+	double	*pBlock = (double *) _mm_malloc(NUM_VALIDATE_BLOCK * sizeof(double), 64);
+
+	if (pBlock == NULL)
+		return;
+	for (unsigned long long done = 0; done < numSamples; done += NUM_VALIDATE_BLOCK)
+	{
+		size_t	n = (numSamples - done < NUM_VALIDATE_BLOCK) ? (size_t) (numSamples - done) : NUM_VALIDATE_BLOCK;
+
+		pGenerator->fill(pThread, pBlock, n);
+		TallyBlock(pGenerator->pDistribution, numLags, pBlock, n, pTally);
+	}
+	_mm_free(pBlock);
+}
+
+// NormalTwoSidedP() returns the probability that |Z| >= |z| for a standard normal Z.
+static double	NormalTwoSidedP(double z)
+{
+	return erfc(fabs(z) * 0.70710678118654752440);
+}
+
+// FamilyP() returns the probability that the smallest of m independent p-values is at most p.
+static double	FamilyP(double p, int m)
+{
+	return -expm1(m * log1p(-p));
+}
+
+// ChiSquareP() returns the probability that a chi-square variable of df degrees of freedom is at least
+//     chiSquare, by the Wilson-Hilferty cube root transform, which is close enough for hundreds of them.
+static double	ChiSquareP(double chiSquare, int df)
+{
+	double	v = 2.0 / (9.0 * df);
+	double	z = (cbrt(chiSquare / df) - (1.0 - v)) / sqrt(v);
+
+	return 0.5 * erfc(z * 0.70710678118654752440);
+}
+
+// KolmogorovP() returns the probability that the Kolmogorov-Smirnov statistic of n numbers is at least d,
+//     with the correction of Stephens for finite n.
+static double	KolmogorovP(double d, double n)
+{
+	double	lambda = (sqrt(n) + 0.12 + 0.11 / sqrt(n)) * d;
+	double	sum = 0.0, sign = 1.0;
+
+	if (lambda < 0.3)
+		return 1.0;
+	for (int j = 1; j <= 100; j++)
+	{
+		double	term = exp(-2.0 * j * j * lambda * lambda);
+
+		sum += sign * term;
+		if (term < 1e-16)
+			break;
+		sign = -sign;
+	}
+	sum *= 2.0;
+	return (sum < 0.0) ? 0.0 : ((sum > 1.0) ? 1.0 : sum);
+}
+
+// AndersonDarlingP() returns the probability that the Anderson-Darling statistic is at least a2 for large n,
+//     by the approximation of its limiting distribution by Marsaglia and Marsaglia (2004).
+static double	AndersonDarlingP(double a2)
+{
+	double	cdf;
+
+	if (a2 <= 0.0)
+		return 1.0;
+	if (a2 < 2.0)
+		cdf = exp(-1.2337141 / a2) / sqrt(a2) * (2.00012 + (0.247105 - (0.0649821 - (0.0347962 - (0.011672
+			- 0.00168691 * a2) * a2) * a2) * a2) * a2);
+	else
+		cdf = exp(-exp(1.0776 - (2.30695 - (0.43424 - (0.082433 - (0.008056 - 0.0003146 * a2) * a2) * a2) * a2) * a2));
+	return (cdf > 1.0) ? 0.0 : 1.0 - cdf;
+}
+
+// ValidateResult keeps the p-values of one case.
+typedef struct ValidateResult
+{
+	double	chiSquareP, ksP, adP, momentP, lagP, laneP;
+	double	mean, variance;		// Of the standardized numbers
+} ValidateResult;
+
+// Evaluate() works the p-values out of the tally of all the threads.
+static void	Evaluate(const ValidateDistribution *pDistribution, int numLags, const ValidateTally *pTally,
+	ValidateResult *pResult)
+{
+	const double	n = (double) pTally->numSamples;
+	const double	binWidth = (pDistribution->hi - pDistribution->lo) / NUM_VALIDATE_BINS;
+	double			chiSquare = 0.0, d = 0.0, a2 = 0.0, cumulative = 0.0, u1 = 0.0;
+	double			observed = 0.0, expected = 0.0;
+	double			m[NUM_VALIDATE_MOMENTS], pMin;
+	int				numChiSquareBins = 0, numLanePairs = 0;
+
+	// Bin k takes F(x) from u0 = F(lo + k * binWidth) to u1, 0 and 1 at the ends.  Chi-square merges the bins
+	//     into about NUM_CHISQUARE_BINS of equal probability; Kolmogorov-Smirnov looks at the bin edges, and
+	//     Anderson-Darling integrates over each bin by the two-point Gauss-Legendre rule, the empirical
+	//     distribution function running linearly from fn0 to fn1 there.
+	for (int k = 0; k < NUM_VALIDATE_BINS; k++)
+	{
+		double	u0 = u1;
+		double	fn0 = cumulative / n, fn1;
+
+		u1 = (k == NUM_VALIDATE_BINS - 1) ? 1.0 : pDistribution->cdf(pDistribution->lo + (k + 1) * binWidth);
+		cumulative += pTally->bins[k];
+		fn1 = cumulative / n;
+		if (fabs(fn1 - u1) > d)
+			d = fabs(fn1 - u1);
+		for (int g = 0; g < 2; g++)
+		{
+			double	t = (g == 0) ? 0.21132486540518711775 : 0.78867513459481288225;
+			double	u = u0 + t * (u1 - u0);
+			double	fn = fn0 + t * (fn1 - fn0);
+
+			if ((u > 0.0) && (u < 1.0))
+				a2 += 0.5 * (u1 - u0) * (fn - u) * (fn - u) / (u * (1.0 - u));
+		}
+
+		observed += pTally->bins[k];
+		expected += (u1 - u0) * n;
+		if ((u1 * NUM_CHISQUARE_BINS >= numChiSquareBins + 1) || (k == NUM_VALIDATE_BINS - 1))
+		{
+			chiSquare += (observed - expected) * (observed - expected) / expected;
+			numChiSquareBins++;
+			observed = 0.0;
+			expected = 0.0;
+		}
+	}
+	pResult->chiSquareP = ChiSquareP(chiSquare, numChiSquareBins - 1);
+	pResult->ksP = KolmogorovP(d, n);
+	pResult->adP = AndersonDarlingP(n * a2);
+
+	// The moments: the mean of z^k against E(z^k), whose variance is E(z^2k) - E(z^k)^2.
+	pMin = 1.0;
+	for (int k = 1; k <= NUM_VALIDATE_MOMENTS; k++)
+	{
+		double	mu = pDistribution->moments[k];
+		double	sigma = sqrt((pDistribution->moments[2 * k] - mu * mu) / n);
+		double	p;
+
+		m[k - 1] = pTally->momentSums[k - 1] / n;
+		p = NormalTwoSidedP((m[k - 1] - mu) / sigma);
+		pMin = (p < pMin) ? p : pMin;
+	}
+	pResult->momentP = FamilyP(pMin, NUM_VALIDATE_MOMENTS);
+	pResult->mean = m[0];
+	pResult->variance = m[1] - m[0] * m[0];
+
+	// The correlations: z[i] * z[j] has mean 0 and variance 1 for independent z[i] and z[j].
+	pMin = 1.0;
+	for (int lag = 1; lag <= numLags; lag++)
+	{
+		double				sum = 0.0;
+		unsigned long long	numPairs = 0;
+		double				p;
+
+		for (int a = 0; a < NUM_VALIDATE_LANES; a++)
+		{
+			sum += pTally->lagSums[lag - 1][a];
+			numPairs += pTally->numLagPairs[lag - 1][a];
+		}
+		p = NormalTwoSidedP(sum / sqrt((double) numPairs));
+
+		pMin = (p < pMin) ? p : pMin;
+	}
+	pResult->lagP = FamilyP(pMin, numLags);
+
+	pMin = 1.0;
+	for (int a = 0; a < NUM_VALIDATE_LANES; a++)
+		for (int b = a + 1; b < NUM_VALIDATE_LANES; b++)
+		{
+			double	p = NormalTwoSidedP(pTally->lagSums[b - a - 1][a] / sqrt((double) pTally->numLagPairs[b - a - 1][a]));
+
+			pMin = (p < pMin) ? p : pMin;
+			numLanePairs++;
+		}
+	pResult->laneP = FamilyP(pMin, numLanePairs);
+}
+
+// RunCase() runs one case on numThreads threads and returns true if it passes.  pTallies holds numThreads
+//     tallies.
+static bool	RunCase(const ValidateGenerator *pGenerator, MiscRandEngineType engineType, unsigned long long numSamples,
+	int numThreads, unsigned long seed, int numLags, double alpha, ValidateThread *pThreads, ValidateTally *pTallies,
+	ValidateResult *pResult, double *pSeconds)
+{
+	std::vector<std::thread>	workers;
+	unsigned long long			numPerThread = (numSamples + numThreads - 1) / numThreads;
+	std::chrono::steady_clock::time_point	tBefore = std::chrono::steady_clock::now();
+
+	// The threads take whole groups of NUM_VALIDATE_LANES numbers, the last one what is left.
+	numPerThread = (numPerThread + NUM_VALIDATE_LANES - 1) / NUM_VALIDATE_LANES * NUM_VALIDATE_LANES;
+	for (int t = 0; t < numThreads; t++)
+	{
+		SplitStreamAt(&pThreads[t].state, seed, t, (1ULL << 32) / NUM_SPLIT_SLICES / numThreads);
+		RandEngineInit(&pThreads[t].engine, engineType, seed + t);
+		memset(&pTallies[t], 0, sizeof(ValidateTally));
+	}
+	for (int t = 0; t < numThreads; t++)
+	{
+		unsigned long long	first = t * numPerThread;
+		unsigned long long	count = (first >= numSamples) ? 0 : ((numSamples - first < numPerThread) ? numSamples - first
+			: numPerThread);
+
+		workers.push_back(std::thread(ValidateWorker, pGenerator, numLags, &pThreads[t], count, &pTallies[t]));
+	}
+	for (int t = 0; t < numThreads; t++)
+		workers[t].join();
+
+	// The tallies of the other threads go into the first.
+	for (int t = 1; t < numThreads; t++)
+	{
+		for (int k = 0; k < NUM_VALIDATE_BINS; k++)
+			pTallies[0].bins[k] += pTallies[t].bins[k];
+		for (int k = 0; k < NUM_VALIDATE_MOMENTS; k++)
+			pTallies[0].momentSums[k] += pTallies[t].momentSums[k];
+		for (int lag = 0; lag < MAX_NUM_LAGS; lag++)
+			for (int a = 0; a < NUM_VALIDATE_LANES; a++)
+			{
+				pTallies[0].lagSums[lag][a] += pTallies[t].lagSums[lag][a];
+				pTallies[0].numLagPairs[lag][a] += pTallies[t].numLagPairs[lag][a];
+			}
+		pTallies[0].numSamples += pTallies[t].numSamples;
+		pTallies[0].numNonFinite += pTallies[t].numNonFinite;
+	}
+	Evaluate(pGenerator->pDistribution, numLags, &pTallies[0], pResult);
+	*pSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - tBefore).count();
+
+	return (pTallies[0].numSamples == numSamples) && (pTallies[0].numNonFinite == 0) && (pResult->chiSquareP >= alpha)
+		&& (pResult->ksP >= alpha) && (pResult->adP >= alpha) && (pResult->momentP >= alpha) && (pResult->lagP >= alpha)
+		&& (pResult->laneP >= alpha);
+}
+
+// RunTruncationCase() runs *pTruncation from *pState and returns whether it passed.
+static bool	RunTruncationCase(const ValidateTruncation *pTruncation, MiscRandState *pState)
+{
+	double	*pBlock = (double *) _mm_malloc(NUM_VALIDATE_BLOCK * sizeof(double), 64);
+	bool	bPassed = true;
+
+	if (pBlock == NULL)
+		return false;
+	TruncatedGaussianFill_r(pState, pBlock, NUM_VALIDATE_BLOCK, pTruncation->a, pTruncation->b);
+	for (size_t i = 0; i < NUM_VALIDATE_BLOCK; i++)
+	{
+		if (pTruncation->bEmpty ? !isnan(pBlock[i]) : !((pBlock[i] >= pTruncation->a) && (pBlock[i] <= pTruncation->b)))
+			bPassed = false;
+	}
+	_mm_free(pBlock);
+	return bPassed;
+}
+
+static int	Usage()
+{
+	fprintf(stderr, "Usage: CMiscRandValidate [--samples N] [--threads N] [--seed N] [--alpha P] [--lags N]\n"
+		"                         [--filter TEXT]\n");
+	return 2;
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned long long	numSamples = DEFAULT_NUM_SAMPLES;
+	int					numThreads = (int) std::thread::hardware_concurrency(), numLags = DEFAULT_NUM_LAGS;
+	unsigned long		seed = 1;
+	double				alpha = DEFAULT_ALPHA;
+	const char			*filter = NULL;
+	const int			numGenerators = sizeof(validateGenerators) / sizeof(validateGenerators[0]);
+	ValidateThread		*pThreads;
+	ValidateTally		*pTallies;
+	int					numCases = 0, numFailed = 0;
+
+	for (int a = 1; a < argc; a++)
+	{
+		if (a + 1 >= argc)
+			return Usage();
+		if (strcmp(argv[a], "--samples") == 0)
+			numSamples = strtoull(argv[++a], NULL, 0);
+		else if (strcmp(argv[a], "--threads") == 0)
+			numThreads = atoi(argv[++a]);
+		else if (strcmp(argv[a], "--seed") == 0)
+			seed = strtoul(argv[++a], NULL, 0);
+		else if (strcmp(argv[a], "--alpha") == 0)
+			alpha = atof(argv[++a]);
+		else if (strcmp(argv[a], "--lags") == 0)
+			numLags = atoi(argv[++a]);
+		else if (strcmp(argv[a], "--filter") == 0)
+			filter = argv[++a];
+		else
+			return Usage();
+	}
+	if (numThreads < 1)
+		numThreads = 1;
+	if ((numSamples < NUM_CHISQUARE_BINS) || (numLags < 1) || (numLags > MAX_NUM_LAGS) || (alpha <= 0.0) || (alpha >= 1.0))
+		return Usage();
+
+	pThreads = (ValidateThread *) _mm_malloc(numThreads * sizeof(ValidateThread), 64);
+	pTallies = (ValidateTally *) _mm_malloc(numThreads * sizeof(ValidateTally), 64);
+	if ((pThreads == NULL) || (pTallies == NULL))
+	{
+		fprintf(stderr, "We cannot allocate the tallies of %d threads.\n", numThreads);
+		return 1;
+	}
+
+	fprintf(stdout, "%llu numbers per case on %d threads, seed %lu, alpha %g.\n\n", numSamples, numThreads, seed, alpha);
+	fprintf(stdout, "%-26s %-7s %-13s %9s %10s %10s %10s %10s %10s %10s %10s  %s\n", "generator", "isa", "engine",
+		"Msamples/s", "variance", "chi2 p", "KS p", "AD p", "moments p", "lags p", "lanes p", "result");
+
+	for (int g = 0; g < numGenerators; g++)
+	{
+		const ValidateGenerator	*pGenerator = &validateGenerators[g];
+		MiscRandISA				savedISA = MISCRAND_ISA_SCALAR;
+
+		if ((filter != NULL) && (strstr(pGenerator->name, filter) == NULL))
+			continue;
+		if (pGenerator->setISA == GaussianRandVecSetISA)
+			savedISA = GaussianRandVecISA();
+		else if (pGenerator->setISA == GaussianRandZigSetISA)
+			savedISA = GaussianRandZigISA();
+		else if (pGenerator->setISA == RandEngineSetISA)
+			savedISA = RandEngineISA();
+		else if (pGenerator->setISA == UniformRandSetISA)
+			savedISA = UniformRandISA();
+		else if (pGenerator->setISA == GaussianNoiseSetISA)
+			savedISA = GaussianNoiseISA();
+		else if (pGenerator->setISA == GaussianRandInvSetISA)
+			savedISA = GaussianRandInvISA();
+
+		for (int isa = MISCRAND_ISA_SCALAR; isa <= MISCRAND_ISA_AVX512; isa++)
+		{
+			if ((pGenerator->setISA == NULL) ? (isa != MISCRAND_ISA_SCALAR) : !pGenerator->setISA((MiscRandISA) isa))
+				continue;
+
+			for (int e = 0; e < (pGenerator->bUsesEngine ? NUM_MISCRAND_ENGINES : 1); e++)
+			{
+				ValidateResult	result;
+				double			seconds;
+				bool			bPassed = RunCase(pGenerator, (MiscRandEngineType) e, numSamples, numThreads, seed,
+					numLags, alpha, pThreads, pTallies, &result, &seconds);
+
+				numCases++;
+				numFailed += bPassed ? 0 : 1;
+				fprintf(stdout, "%-26s %-7s %-13s %9.1f %10.6f %10.3g %10.3g %10.3g %10.3g %10.3g %10.3g  %s\n",
+					pGenerator->name, (pGenerator->setISA == NULL) ? "-" : isaNames[isa],
+					pGenerator->bUsesEngine ? engineNames[e] : "-", numSamples / seconds / 1e6, result.variance,
+					result.chiSquareP, result.ksP, result.adP, result.momentP, result.lagP, result.laneP,
+					bPassed ? "pass" : "FAIL");
+				if (pTallies[0].numNonFinite != 0)
+					fprintf(stdout, "    %llu numbers are not finite.\n", pTallies[0].numNonFinite);
+				fflush(stdout);
+			}
+		}
+
+		if (pGenerator->setISA != NULL)
+			pGenerator->setISA(savedISA);
+	}
+
+	if ((filter == NULL) || (strstr("TruncatedGaussianFill", filter) != NULL))
+	{
+		const int	numTruncations = sizeof(validateTruncations) / sizeof(validateTruncations[0]);
+
+		fprintf(stdout, "\n%-26s %-26s %s\n", "generator", "interval", "result");
+		SplitStreamAt(&pThreads[0].state, seed, 0, (1ULL << 32) / NUM_SPLIT_SLICES);
+		for (int c = 0; c < numTruncations; c++)
+		{
+			const ValidateTruncation	*pTruncation = &validateTruncations[c];
+			char						interval[64];
+			bool						bPassed = RunTruncationCase(pTruncation, &pThreads[0].state);
+
+			numCases++;
+			numFailed += bPassed ? 0 : 1;
+			sprintf(interval, "[%g, %g]", pTruncation->a, pTruncation->b);
+			fprintf(stdout, "%-26s %-26s %s\n", "TruncatedGaussianFill", interval, bPassed ? "pass" : "FAIL");
+			fflush(stdout);
+		}
+	}
+
+	fprintf(stdout, "\n%d of %d cases failed.\n", numFailed, numCases);
+	_mm_free(pTallies);
+	_mm_free(pThreads);
+	return (numFailed == 0) ? 0 : 1;
+}